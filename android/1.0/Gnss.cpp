@@ -21,6 +21,8 @@
 #define LOG_TAG "LocSvc_GnssInterface"
 #define LOG_NDEBUG 0
 
+#include <inttypes.h>
+#include <stdio.h>
 #include <fstream>
 #include <log_util.h>
 #include <dlfcn.h>
@@ -324,6 +326,45 @@ Return<sp<V1_0::IGnssDebug>> Gnss::getExtensionGnssDebug() {
     return mGnssDebug;
 }
 
+// Methods from ::android::hidl::base::V1_0::IBase follow.
+/*
+ * Dumps the statistics of the location stack which IGnssDebug::DebugData
+ * has no room for, e.g. on "lshal debug android.hardware.gnss@1.0::IGnss/default".
+ */
+Return<void> Gnss::debug(const hidl_handle& fd, const hidl_vec<hidl_string>& /*options*/) {
+    ENTRY_LOG_CALLFLOW();
+    if (fd == nullptr || fd->numFds < 1) {
+        LOC_LOGe("no fd to dump into");
+        return Void();
+    }
+    const GnssInterface* gnssInterface = getGnssInterface();
+    if (nullptr == gnssInterface) {
+        LOC_LOGe("Null GNSS interface");
+        return Void();
+    }
+    GnssDebugReport reports = { };
+    gnssInterface->getDebugReport(reports);
+
+    int out = fd->data[0];
+    dprintf(out, "thread policies:\n%s", reports.mThreadPolicies.c_str());
+    dprintf(out, "odcpi: framework requests %u, emergency requests %u, merged %u,"
+            " cache hits %u\n", reports.mOdcpiStats.frameworkRequests,
+            reports.mOdcpiStats.emergencyRequests, reports.mOdcpiStats.mergedRequests,
+            reports.mOdcpiStats.cacheHits);
+    dprintf(out, "avoided tracking restarts: %u\n", reports.mAvoidedTrackingRestarts);
+    dprintf(out, "clock model: samples %u, steps %u, realtime sets %u, error %" PRIi64
+            " ns, max %" PRIi64 " ns, drift %" PRIi64 " ppb\n", reports.mClockStats.samples,
+            reports.mClockStats.steps, reports.mClockStats.realtimeSets,
+            reports.mClockStats.lastErrorNanos, reports.mClockStats.maxErrorNanos,
+            reports.mClockStats.driftPpb);
+    dprintf(out, "work accounting:\n%s", reports.mWorkAccounting.c_str());
+    uint64_t received = 0, published = 0, suppressed = 0;
+    loc_extn_battery_properties_get_filter_stats(&received, &published, &suppressed);
+    dprintf(out, "power state updates: received %" PRIu64 ", published %" PRIu64
+            ", suppressed %" PRIu64 "\n", received, published, suppressed);
+    return Void();
+}
+
 Return<sp<V1_0::IAGnssRil>> Gnss::getExtensionAGnssRil() {
     mGnssRil = new AGnssRil(this);
     return mGnssRil;
@@ -69,6 +69,7 @@ GnssAPIClient::GnssAPIClient(const sp<IGnssCallback>& gpsCb,
     mTrackingOptions.minInterval = 1000;
     mTrackingOptions.minDistance = 0;
     mTrackingOptions.mode = GNSS_SUPL_MODE_STANDALONE;
+    initNmeaOptions();
 
     gnssUpdateCallbacks(gpsCb, niCb);
 }
@@ -82,6 +83,21 @@ GnssAPIClient::~GnssAPIClient()
     }
 }
 
+void GnssAPIClient::initNmeaOptions()
+{
+    mNmeaAggregation = false;
+    mNmeaEpochSentences = 0;
+    mNmeaEpochBinderCalls = 0;
+
+    uint32_t aggregation = 0;
+    loc_param_s_type nmeaConfTable[] =
+    {
+        { "NMEA_HIDL_AGGREGATION", &aggregation, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, nmeaConfTable);
+    mNmeaAggregation = (aggregation != 0);
+}
+
 // for GpsInterface
 void GnssAPIClient::gnssUpdateCallbacks(const sp<IGnssCallback>& gpsCb,
     const sp<IGnssNiCallback>& niCb)
@@ -469,13 +485,33 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
     mMutex.unlock();
 
     if (gnssCbIface != nullptr) {
-        const std::string s(gnssNmeaNotification.nmea);
-        std::stringstream ss(s);
-        std::string each;
-        while(std::getline(ss, each, '\n')) {
-            each += '\n';
+        // hidl_string sends the byte after its data as the terminator, so the
+        // sentences are NUL terminated in place in a private copy of the report
+        // rather than each being copied out into its own string
+        size_t length = strlen(gnssNmeaNotification.nmea);
+        if (mNmeaBuffer.size() < length + 2) {
+            mNmeaBuffer.resize(length + 2);
+        }
+        char* nmea = mNmeaBuffer.data();
+        memcpy(nmea, gnssNmeaNotification.nmea, length);
+        if (length > 0 && nmea[length - 1] != '\n') {
+            nmea[length++] = '\n';
+        }
+        nmea[length] = '\0';
+
+        // the report carrying GGA opens a new fix epoch
+        if (nullptr != strstr(nmea, "GGA,")) {
+            if (mNmeaEpochSentences > 0) {
+                LOC_LOGv("NMEA epoch: %u sentences in %u binder calls",
+                         mNmeaEpochSentences, mNmeaEpochBinderCalls);
+            }
+            mNmeaEpochSentences = 0;
+            mNmeaEpochBinderCalls = 0;
+        }
+
+        auto sendNmea = [&](const char* sentence, size_t sentenceLength) {
             android::hardware::hidl_string nmeaString;
-            nmeaString.setToExternal(each.c_str(), each.length());
+            nmeaString.setToExternal(sentence, sentenceLength);
             auto r = gnssCbIface->gnssNmeaCb(
                     static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
             if (!r.isOk()) {
@@ -483,6 +519,23 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
                             gnssNmeaNotification.nmea, gnssNmeaNotification.length,
                             r.description().c_str());
             }
+            mNmeaEpochBinderCalls++;
+        };
+
+        char* end = nmea + length;
+        for (char* start = nmea; start < end; ) {
+            char* eol = (char*)memchr(start, '\n', end - start);
+            mNmeaEpochSentences++;
+            if (!mNmeaAggregation) {
+                char next = eol[1];
+                eol[1] = '\0';
+                sendNmea(start, eol + 1 - start);
+                eol[1] = next;
+            }
+            start = eol + 1;
+        }
+        if (mNmeaAggregation && length > 0) {
+            sendNmea(nmea, length);
         }
     }
 }
@@ -32,6 +32,7 @@
 
 
 #include <mutex>
+#include <vector>
 #include <android/hardware/gnss/1.0/IGnss.h>
 #include <android/hardware/gnss/1.0/IGnssCallback.h>
 #include <android/hardware/gnss/1.0/IGnssNiCallback.h>
@@ -100,6 +101,12 @@ private:
     LocationCapabilitiesMask mLocationCapabilitiesMask;
     bool mLocationCapabilitiesCached;
     TrackingOptions mTrackingOptions;
+
+    // NMEA delivery, only touched from onGnssNmeaCb
+    bool mNmeaAggregation;
+    std::vector<char> mNmeaBuffer;
+    uint32_t mNmeaEpochSentences;
+    uint32_t mNmeaEpochBinderCalls;
 };
 
 }  // namespace implementation
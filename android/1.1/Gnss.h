@@ -44,6 +44,7 @@ namespace V1_1 {
 namespace implementation {
 
 using ::android::hardware::hidl_array;
+using ::android::hardware::hidl_handle;
 using ::android::hardware::hidl_memory;
 using ::android::hardware::hidl_string;
 using ::android::hardware::hidl_vec;
@@ -95,6 +96,9 @@ struct Gnss : public IGnss {
 
     Return<sp<V1_0::IGnssDebug>> getExtensionGnssDebug() override;
 
+    // Methods from ::android::hidl::base::V1_0::IBase follow.
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& options) override;
+
     // Methods from ::android::hardware::gnss::V1_1::IGnss follow.
     Return<bool> setCallback_1_1(const sp<V1_1::IGnssCallback>& callback) override;
     Return<bool> setPositionMode_1_1(V1_0::IGnss::GnssPositionMode mode,
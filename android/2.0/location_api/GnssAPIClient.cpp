@@ -68,6 +68,7 @@ GnssAPIClient::GnssAPIClient(const sp<V1_0::IGnssCallback>& gpsCb,
     LOC_LOGD("%s]: (%p %p)", __FUNCTION__, &gpsCb, &niCb);
 
     initLocationOptions();
+    initNmeaOptions();
     gnssUpdateCallbacks(gpsCb, niCb);
 }
 
@@ -84,6 +85,7 @@ GnssAPIClient::GnssAPIClient(const sp<V2_0::IGnssCallback>& gpsCb) :
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
 
     initLocationOptions();
+    initNmeaOptions();
     gnssUpdateCallbacks_2_0(gpsCb);
 }
 
@@ -106,6 +108,21 @@ void GnssAPIClient::initLocationOptions()
     mTrackingOptions.mode = GNSS_SUPL_MODE_STANDALONE;
 }
 
+void GnssAPIClient::initNmeaOptions()
+{
+    mNmeaAggregation = false;
+    mNmeaEpochSentences = 0;
+    mNmeaEpochBinderCalls = 0;
+
+    uint32_t aggregation = 0;
+    loc_param_s_type nmeaConfTable[] =
+    {
+        { "NMEA_HIDL_AGGREGATION", &aggregation, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, nmeaConfTable);
+    mNmeaAggregation = (aggregation != 0);
+}
+
 void GnssAPIClient::setCallbacks()
 {
     LocationCallbacks locationCallbacks;
@@ -570,13 +587,33 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
     mMutex.unlock();
 
     if (gnssCbIface != nullptr || gnssCbIface_2_0 != nullptr) {
-        const std::string s(gnssNmeaNotification.nmea);
-        std::stringstream ss(s);
-        std::string each;
-        while(std::getline(ss, each, '\n')) {
-            each += '\n';
+        // hidl_string sends the byte after its data as the terminator, so the
+        // sentences are NUL terminated in place in a private copy of the report
+        // rather than each being copied out into its own string
+        size_t length = strlen(gnssNmeaNotification.nmea);
+        if (mNmeaBuffer.size() < length + 2) {
+            mNmeaBuffer.resize(length + 2);
+        }
+        char* nmea = mNmeaBuffer.data();
+        memcpy(nmea, gnssNmeaNotification.nmea, length);
+        if (length > 0 && nmea[length - 1] != '\n') {
+            nmea[length++] = '\n';
+        }
+        nmea[length] = '\0';
+
+        // the report carrying GGA opens a new fix epoch
+        if (nullptr != strstr(nmea, "GGA,")) {
+            if (mNmeaEpochSentences > 0) {
+                LOC_LOGv("NMEA epoch: %u sentences in %u binder calls",
+                         mNmeaEpochSentences, mNmeaEpochBinderCalls);
+            }
+            mNmeaEpochSentences = 0;
+            mNmeaEpochBinderCalls = 0;
+        }
+
+        auto sendNmea = [&](const char* sentence, size_t sentenceLength) {
             android::hardware::hidl_string nmeaString;
-            nmeaString.setToExternal(each.c_str(), each.length());
+            nmeaString.setToExternal(sentence, sentenceLength);
             if (gnssCbIface_2_0 != nullptr) {
                 auto r = gnssCbIface_2_0->gnssNmeaCb(
                         static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
@@ -594,6 +631,23 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
                              r.description().c_str());
                 }
             }
+            mNmeaEpochBinderCalls++;
+        };
+
+        char* end = nmea + length;
+        for (char* start = nmea; start < end; ) {
+            char* eol = (char*)memchr(start, '\n', end - start);
+            mNmeaEpochSentences++;
+            if (!mNmeaAggregation) {
+                char next = eol[1];
+                eol[1] = '\0';
+                sendNmea(start, eol + 1 - start);
+                eol[1] = next;
+            }
+            start = eol + 1;
+        }
+        if (mNmeaAggregation && length > 0) {
+            sendNmea(nmea, length);
         }
     }
 }
@@ -32,6 +32,7 @@
 
 
 #include <mutex>
+#include <vector>
 #include <android/hardware/gnss/2.0/IGnss.h>
 #include <android/hardware/gnss/2.0/IGnssCallback.h>
 #include <LocationAPIClientBase.h>
@@ -95,6 +96,7 @@ private:
     virtual ~GnssAPIClient();
 
     void setCallbacks();
+    void initNmeaOptions();
     void initLocationOptions();
     sp<V1_0::IGnssCallback> mGnssCbIface;
     sp<V1_0::IGnssNiCallback> mGnssNiCbIface;
@@ -105,6 +107,12 @@ private:
     TrackingOptions mTrackingOptions;
     bool mTracking;
     sp<V2_0::IGnssCallback> mGnssCbIface_2_0;
+
+    // NMEA delivery, only touched from onGnssNmeaCb
+    bool mNmeaAggregation;
+    std::vector<char> mNmeaBuffer;
+    uint32_t mNmeaEpochSentences;
+    uint32_t mNmeaEpochBinderCalls;
 };
 
 }  // namespace implementation
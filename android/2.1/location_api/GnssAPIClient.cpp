@@ -52,8 +52,10 @@ using ::android::hardware::gnss::V2_0::GnssLocation;
 
 static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::GnssSvStatus& out);
 static void convertGnssSvStatus(GnssSvNotification& in,
+        std::vector<V2_0::IGnssCallback::GnssSvInfo>& svInfos,
         hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out);
 static void convertGnssSvStatus(GnssSvNotification& in,
+        std::vector<V2_1::IGnssCallback::GnssSvInfo>& svInfos,
         hidl_vec<V2_1::IGnssCallback::GnssSvInfo>& out);
 
 GnssAPIClient::GnssAPIClient(const sp<V1_0::IGnssCallback>& gpsCb,
@@ -70,6 +72,7 @@ GnssAPIClient::GnssAPIClient(const sp<V1_0::IGnssCallback>& gpsCb,
     LOC_LOGD("%s]: (%p %p)", __FUNCTION__, &gpsCb, &niCb);
 
     initLocationOptions();
+    initNmeaOptions();
     gnssUpdateCallbacks(gpsCb, niCb);
 }
 
@@ -86,6 +89,7 @@ GnssAPIClient::GnssAPIClient(const sp<V2_0::IGnssCallback>& gpsCb) :
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
 
     initLocationOptions();
+    initNmeaOptions();
     gnssUpdateCallbacks_2_0(gpsCb);
 }
 
@@ -102,6 +106,7 @@ GnssAPIClient::GnssAPIClient(const sp<V2_1::IGnssCallback>& gpsCb) :
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
 
     initLocationOptions();
+    initNmeaOptions();
     gnssUpdateCallbacks_2_1(gpsCb);
 }
 
@@ -124,6 +129,21 @@ void GnssAPIClient::initLocationOptions()
     mTrackingOptions.mode = GNSS_SUPL_MODE_STANDALONE;
 }
 
+void GnssAPIClient::initNmeaOptions()
+{
+    mNmeaAggregation = false;
+    mNmeaEpochSentences = 0;
+    mNmeaEpochBinderCalls = 0;
+
+    uint32_t aggregation = 0;
+    loc_param_s_type nmeaConfTable[] =
+    {
+        { "NMEA_HIDL_AGGREGATION", &aggregation, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, nmeaConfTable);
+    mNmeaAggregation = (aggregation != 0);
+}
+
 void GnssAPIClient::setCallbacks()
 {
     LocationCallbacks locationCallbacks;
@@ -615,7 +635,7 @@ void GnssAPIClient::onGnssSvCb(GnssSvNotification gnssSvNotification)
 
     if (gnssCbIface_2_1 != nullptr) {
         hidl_vec<V2_1::IGnssCallback::GnssSvInfo> svInfoList;
-        convertGnssSvStatus(gnssSvNotification, svInfoList);
+        convertGnssSvStatus(gnssSvNotification, mSvInfos_2_1, svInfoList);
         auto r = gnssCbIface_2_1->gnssSvStatusCb_2_1(svInfoList);
         if (!r.isOk()) {
             LOC_LOGE("%s] Error from gnssSvStatusCb_2_1 description=%s",
@@ -623,7 +643,7 @@ void GnssAPIClient::onGnssSvCb(GnssSvNotification gnssSvNotification)
         }
     } else if (gnssCbIface_2_0 != nullptr) {
         hidl_vec<V2_0::IGnssCallback::GnssSvInfo> svInfoList;
-        convertGnssSvStatus(gnssSvNotification, svInfoList);
+        convertGnssSvStatus(gnssSvNotification, mSvInfos_2_0, svInfoList);
         auto r = gnssCbIface_2_0->gnssSvStatusCb_2_0(svInfoList);
         if (!r.isOk()) {
             LOC_LOGE("%s] Error from gnssSvStatusCb_2_0 description=%s",
@@ -649,13 +669,33 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
     mMutex.unlock();
 
     if (gnssCbIface != nullptr || gnssCbIface_2_0 != nullptr| gnssCbIface_2_1 != nullptr) {
-        const std::string s(gnssNmeaNotification.nmea);
-        std::stringstream ss(s);
-        std::string each;
-        while(std::getline(ss, each, '\n')) {
-            each += '\n';
+        // hidl_string sends the byte after its data as the terminator, so the
+        // sentences are NUL terminated in place in a private copy of the report
+        // rather than each being copied out into its own string
+        size_t length = strlen(gnssNmeaNotification.nmea);
+        if (mNmeaBuffer.size() < length + 2) {
+            mNmeaBuffer.resize(length + 2);
+        }
+        char* nmea = mNmeaBuffer.data();
+        memcpy(nmea, gnssNmeaNotification.nmea, length);
+        if (length > 0 && nmea[length - 1] != '\n') {
+            nmea[length++] = '\n';
+        }
+        nmea[length] = '\0';
+
+        // the report carrying GGA opens a new fix epoch
+        if (nullptr != strstr(nmea, "GGA,")) {
+            if (mNmeaEpochSentences > 0) {
+                LOC_LOGv("NMEA epoch: %u sentences in %u binder calls",
+                         mNmeaEpochSentences, mNmeaEpochBinderCalls);
+            }
+            mNmeaEpochSentences = 0;
+            mNmeaEpochBinderCalls = 0;
+        }
+
+        auto sendNmea = [&](const char* sentence, size_t sentenceLength) {
             android::hardware::hidl_string nmeaString;
-            nmeaString.setToExternal(each.c_str(), each.length());
+            nmeaString.setToExternal(sentence, sentenceLength);
             if (gnssCbIface_2_1 != nullptr) {
                 auto r = gnssCbIface_2_1->gnssNmeaCb(
                         static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
@@ -681,6 +721,23 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
                              r.description().c_str());
                 }
             }
+            mNmeaEpochBinderCalls++;
+        };
+
+        char* end = nmea + length;
+        for (char* start = nmea; start < end; ) {
+            char* eol = (char*)memchr(start, '\n', end - start);
+            mNmeaEpochSentences++;
+            if (!mNmeaAggregation) {
+                char next = eol[1];
+                eol[1] = '\0';
+                sendNmea(start, eol + 1 - start);
+                eol[1] = next;
+            }
+            start = eol + 1;
+        }
+        if (mNmeaAggregation && length > 0) {
+            sendNmea(nmea, length);
         }
     }
 }
@@ -780,6 +837,27 @@ void GnssAPIClient::onStopTrackingCb(LocationError error)
     }
 }
 
+static const LocToHidlBit sSvFlags[] = {
+    { GNSS_SV_OPTIONS_HAS_EPHEMER_BIT,
+      static_cast<uint32_t>(IGnssCallback::GnssSvFlags::HAS_EPHEMERIS_DATA) },
+    { GNSS_SV_OPTIONS_HAS_ALMANAC_BIT,
+      static_cast<uint32_t>(IGnssCallback::GnssSvFlags::HAS_ALMANAC_DATA) },
+    { GNSS_SV_OPTIONS_USED_IN_FIX_BIT,
+      static_cast<uint32_t>(IGnssCallback::GnssSvFlags::USED_IN_FIX) },
+    { GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT,
+      static_cast<uint32_t>(IGnssCallback::GnssSvFlags::HAS_CARRIER_FREQUENCY) },
+};
+
+static void convertGnssSvInfo(GnssSv& in, V1_0::IGnssCallback::GnssSvInfo& out)
+{
+    convertGnssSvid(in, out.svid);
+    out.cN0Dbhz = in.cN0Dbhz;
+    out.elevationDegrees = in.elevation;
+    out.azimuthDegrees = in.azimuth;
+    out.carrierFrequencyHz = in.carrierFrequencyHz;
+    out.svFlag = static_cast<uint8_t>(convertBits(in.gnssSvOptionsMask, sSvFlags));
+}
+
 static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::GnssSvStatus& out)
 {
     memset(&out, 0, sizeof(IGnssCallback::GnssSvStatus));
@@ -790,71 +868,40 @@ static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::Gns
         out.numSvs = static_cast<uint32_t>(V1_0::GnssMax::SVS_COUNT);
     }
     for (size_t i = 0; i < out.numSvs; i++) {
-        convertGnssSvid(in.gnssSvs[i], out.gnssSvList[i].svid);
+        convertGnssSvInfo(in.gnssSvs[i], out.gnssSvList[i]);
         convertGnssConstellationType(in.gnssSvs[i].type, out.gnssSvList[i].constellation);
-        out.gnssSvList[i].cN0Dbhz = in.gnssSvs[i].cN0Dbhz;
-        out.gnssSvList[i].elevationDegrees = in.gnssSvs[i].elevation;
-        out.gnssSvList[i].azimuthDegrees = in.gnssSvs[i].azimuth;
-        out.gnssSvList[i].carrierFrequencyHz = in.gnssSvs[i].carrierFrequencyHz;
-        out.gnssSvList[i].svFlag = static_cast<uint8_t>(IGnssCallback::GnssSvFlags::NONE);
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_EPHEMER_BIT)
-            out.gnssSvList[i].svFlag |= IGnssCallback::GnssSvFlags::HAS_EPHEMERIS_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_ALMANAC_BIT)
-            out.gnssSvList[i].svFlag |= IGnssCallback::GnssSvFlags::HAS_ALMANAC_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT)
-            out.gnssSvList[i].svFlag |= IGnssCallback::GnssSvFlags::USED_IN_FIX;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT)
-            out.gnssSvList[i].svFlag |= IGnssCallback::GnssSvFlags::HAS_CARRIER_FREQUENCY;
     }
 }
 
+/* svInfos is the caller's storage, kept across reports so it only grows to the
+   largest SV count seen; out is pointed at its first in.count entries. */
 static void convertGnssSvStatus(GnssSvNotification& in,
+        std::vector<V2_0::IGnssCallback::GnssSvInfo>& svInfos,
         hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out)
 {
-    out.resize(in.count);
+    if (svInfos.size() < in.count) {
+        svInfos.resize(in.count);
+    }
     for (size_t i = 0; i < in.count; i++) {
-        convertGnssSvid(in.gnssSvs[i], out[i].v1_0.svid);
-        out[i].v1_0.cN0Dbhz = in.gnssSvs[i].cN0Dbhz;
-        out[i].v1_0.elevationDegrees = in.gnssSvs[i].elevation;
-        out[i].v1_0.azimuthDegrees = in.gnssSvs[i].azimuth;
-        out[i].v1_0.carrierFrequencyHz = in.gnssSvs[i].carrierFrequencyHz;
-        out[i].v1_0.svFlag = static_cast<uint8_t>(IGnssCallback::GnssSvFlags::NONE);
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_EPHEMER_BIT)
-            out[i].v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_EPHEMERIS_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_ALMANAC_BIT)
-            out[i].v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_ALMANAC_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT)
-            out[i].v1_0.svFlag |= IGnssCallback::GnssSvFlags::USED_IN_FIX;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT)
-            out[i].v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_CARRIER_FREQUENCY;
-
-        convertGnssConstellationType(in.gnssSvs[i].type, out[i].constellation);
+        convertGnssSvInfo(in.gnssSvs[i], svInfos[i].v1_0);
+        convertGnssConstellationType(in.gnssSvs[i].type, svInfos[i].constellation);
     }
+    out.setToExternal(svInfos.data(), in.count);
 }
 
 static void convertGnssSvStatus(GnssSvNotification& in,
+        std::vector<V2_1::IGnssCallback::GnssSvInfo>& svInfos,
         hidl_vec<V2_1::IGnssCallback::GnssSvInfo>& out)
 {
-    out.resize(in.count);
+    if (svInfos.size() < in.count) {
+        svInfos.resize(in.count);
+    }
     for (size_t i = 0; i < in.count; i++) {
-        convertGnssSvid(in.gnssSvs[i], out[i].v2_0.v1_0.svid);
-        out[i].v2_0.v1_0.cN0Dbhz = in.gnssSvs[i].cN0Dbhz;
-        out[i].v2_0.v1_0.elevationDegrees = in.gnssSvs[i].elevation;
-        out[i].v2_0.v1_0.azimuthDegrees = in.gnssSvs[i].azimuth;
-        out[i].v2_0.v1_0.carrierFrequencyHz = in.gnssSvs[i].carrierFrequencyHz;
-        out[i].v2_0.v1_0.svFlag = static_cast<uint8_t>(IGnssCallback::GnssSvFlags::NONE);
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_EPHEMER_BIT)
-            out[i].v2_0.v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_EPHEMERIS_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_ALMANAC_BIT)
-            out[i].v2_0.v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_ALMANAC_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT)
-            out[i].v2_0.v1_0.svFlag |= IGnssCallback::GnssSvFlags::USED_IN_FIX;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT)
-            out[i].v2_0.v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_CARRIER_FREQUENCY;
-
-        convertGnssConstellationType(in.gnssSvs[i].type, out[i].v2_0.constellation);
-        out[i].basebandCN0DbHz = in.gnssSvs[i].basebandCarrierToNoiseDbHz;
+        convertGnssSvInfo(in.gnssSvs[i], svInfos[i].v2_0.v1_0);
+        convertGnssConstellationType(in.gnssSvs[i].type, svInfos[i].v2_0.constellation);
+        svInfos[i].basebandCN0DbHz = in.gnssSvs[i].basebandCarrierToNoiseDbHz;
     }
+    out.setToExternal(svInfos.data(), in.count);
 }
 
 }  // namespace implementation
@@ -32,6 +32,7 @@
 
 
 #include <mutex>
+#include <vector>
 #include <android/hardware/gnss/2.1/IGnss.h>
 #include <android/hardware/gnss/2.1/IGnssCallback.h>
 #include <LocationAPIClientBase.h>
@@ -96,6 +97,7 @@ public:
 private:
     virtual ~GnssAPIClient();
     void setCallbacks();
+    void initNmeaOptions();
     void initLocationOptions();
 
     sp<V1_0::IGnssCallback> mGnssCbIface;
@@ -108,6 +110,16 @@ private:
     bool mTracking;
     sp<V2_0::IGnssCallback> mGnssCbIface_2_0;
     sp<V2_1::IGnssCallback> mGnssCbIface_2_1;
+
+    // SV conversion storage reused across reports, only touched from onGnssSvCb
+    std::vector<V2_0::IGnssCallback::GnssSvInfo> mSvInfos_2_0;
+    std::vector<V2_1::IGnssCallback::GnssSvInfo> mSvInfos_2_1;
+
+    // NMEA delivery, only touched from onGnssNmeaCb
+    bool mNmeaAggregation;
+    std::vector<char> mNmeaBuffer;
+    uint32_t mNmeaEpochSentences;
+    uint32_t mNmeaEpochBinderCalls;
 };
 
 }  // namespace implementation
@@ -149,62 +149,46 @@ void convertGnssLocation(const V2_0::GnssLocation& in, Location& out)
     convertGnssLocation(in.v1_0, out);
 }
 
+// indexed by GnssSvType
+static const V1_0::GnssConstellationType sConstellationType_1_0[] = {
+    V1_0::GnssConstellationType::UNKNOWN,   // GNSS_SV_TYPE_UNKNOWN
+    V1_0::GnssConstellationType::GPS,       // GNSS_SV_TYPE_GPS
+    V1_0::GnssConstellationType::SBAS,      // GNSS_SV_TYPE_SBAS
+    V1_0::GnssConstellationType::GLONASS,   // GNSS_SV_TYPE_GLONASS
+    V1_0::GnssConstellationType::QZSS,      // GNSS_SV_TYPE_QZSS
+    V1_0::GnssConstellationType::BEIDOU,    // GNSS_SV_TYPE_BEIDOU
+    V1_0::GnssConstellationType::GALILEO,   // GNSS_SV_TYPE_GALILEO
+    V1_0::GnssConstellationType::UNKNOWN,   // GNSS_SV_TYPE_NAVIC
+};
+
+static const V2_0::GnssConstellationType sConstellationType_2_0[] = {
+    V2_0::GnssConstellationType::UNKNOWN,   // GNSS_SV_TYPE_UNKNOWN
+    V2_0::GnssConstellationType::GPS,       // GNSS_SV_TYPE_GPS
+    V2_0::GnssConstellationType::SBAS,      // GNSS_SV_TYPE_SBAS
+    V2_0::GnssConstellationType::GLONASS,   // GNSS_SV_TYPE_GLONASS
+    V2_0::GnssConstellationType::QZSS,      // GNSS_SV_TYPE_QZSS
+    V2_0::GnssConstellationType::BEIDOU,    // GNSS_SV_TYPE_BEIDOU
+    V2_0::GnssConstellationType::GALILEO,   // GNSS_SV_TYPE_GALILEO
+    V2_0::GnssConstellationType::IRNSS,     // GNSS_SV_TYPE_NAVIC
+};
+
 void convertGnssConstellationType(GnssSvType& in, V1_0::GnssConstellationType& out)
 {
-    switch(in) {
-        case GNSS_SV_TYPE_GPS:
-            out = V1_0::GnssConstellationType::GPS;
-            break;
-        case GNSS_SV_TYPE_SBAS:
-            out = V1_0::GnssConstellationType::SBAS;
-            break;
-        case GNSS_SV_TYPE_GLONASS:
-            out = V1_0::GnssConstellationType::GLONASS;
-            break;
-        case GNSS_SV_TYPE_QZSS:
-            out = V1_0::GnssConstellationType::QZSS;
-            break;
-        case GNSS_SV_TYPE_BEIDOU:
-            out = V1_0::GnssConstellationType::BEIDOU;
-            break;
-        case GNSS_SV_TYPE_GALILEO:
-            out = V1_0::GnssConstellationType::GALILEO;
-            break;
-        case GNSS_SV_TYPE_UNKNOWN:
-        default:
-            out = V1_0::GnssConstellationType::UNKNOWN;
-            break;
+    size_t index = static_cast<size_t>(in);
+    if (index < sizeof(sConstellationType_1_0) / sizeof(sConstellationType_1_0[0])) {
+        out = sConstellationType_1_0[index];
+    } else {
+        out = V1_0::GnssConstellationType::UNKNOWN;
     }
 }
 
 void convertGnssConstellationType(GnssSvType& in, V2_0::GnssConstellationType& out)
 {
-    switch(in) {
-        case GNSS_SV_TYPE_GPS:
-            out = V2_0::GnssConstellationType::GPS;
-            break;
-        case GNSS_SV_TYPE_SBAS:
-            out = V2_0::GnssConstellationType::SBAS;
-            break;
-        case GNSS_SV_TYPE_GLONASS:
-            out = V2_0::GnssConstellationType::GLONASS;
-            break;
-        case GNSS_SV_TYPE_QZSS:
-            out = V2_0::GnssConstellationType::QZSS;
-            break;
-        case GNSS_SV_TYPE_BEIDOU:
-            out = V2_0::GnssConstellationType::BEIDOU;
-            break;
-        case GNSS_SV_TYPE_GALILEO:
-            out = V2_0::GnssConstellationType::GALILEO;
-            break;
-        case GNSS_SV_TYPE_NAVIC:
-            out = V2_0::GnssConstellationType::IRNSS;
-            break;
-        case GNSS_SV_TYPE_UNKNOWN:
-        default:
-            out = V2_0::GnssConstellationType::UNKNOWN;
-            break;
+    size_t index = static_cast<size_t>(in);
+    if (index < sizeof(sConstellationType_2_0) / sizeof(sConstellationType_2_0[0])) {
+        out = sConstellationType_2_0[index];
+    } else {
+        out = V2_0::GnssConstellationType::UNKNOWN;
     }
 }
 
@@ -45,6 +45,25 @@ using MeasurementCorrectionsV1_0 =
         ::android::hardware::gnss::measurement_corrections::V1_0::MeasurementCorrections;
 using ::android::hardware::gnss::measurement_corrections::V1_0::SingleSatCorrection;
 
+// maps one location api bit onto the matching HIDL bit, so that the option,
+// flag and state masks convert through a table instead of an if per bit
+struct LocToHidlBit {
+    uint64_t locBit;
+    uint32_t hidlBit;
+};
+
+template <size_t N>
+inline uint32_t convertBits(uint64_t in, const LocToHidlBit (&table)[N])
+{
+    uint32_t out = 0;
+    for (size_t i = 0; i < N; i++) {
+        if (in & table[i].locBit) {
+            out |= table[i].hidlBit;
+        }
+    }
+    return out;
+}
+
 void convertGnssLocation(Location& in, V1_0::GnssLocation& out);
 void convertGnssLocation(Location& in, V2_0::GnssLocation& out);
 void convertGnssLocation(const V1_0::GnssLocation& in, Location& out);
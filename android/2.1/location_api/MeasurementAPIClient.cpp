@@ -50,13 +50,18 @@ using ::android::hardware::gnss::V2_0::IGnssMeasurementCallback;
 static void convertGnssData(GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out);
 static void convertGnssData_1_1(GnssMeasurementsNotification& in,
+        std::vector<V1_1::IGnssMeasurementCallback::GnssMeasurement>& measurements,
         V1_1::IGnssMeasurementCallback::GnssData& out);
 static void convertGnssData_2_0(GnssMeasurementsNotification& in,
+        std::vector<V2_0::IGnssMeasurementCallback::GnssMeasurement>& measurements,
         V2_0::IGnssMeasurementCallback::GnssData& out);
 static void convertGnssData_2_1(GnssMeasurementsNotification& in,
+        std::vector<V2_1::IGnssMeasurementCallback::GnssMeasurement>& measurements,
         V2_1::IGnssMeasurementCallback::GnssData& out);
 static void convertGnssMeasurement(GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out);
+static void convertGnssMeasurement_2_0(GnssMeasurementsData& in,
+        V2_0::IGnssMeasurementCallback::GnssMeasurement& out);
 static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out);
 static void convertGnssClock_2_1(GnssMeasurementsClock& in,
         V2_1::IGnssMeasurementCallback::GnssClock& out);
@@ -232,7 +237,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
 
         if (gnssMeasurementCbIface_2_1 != nullptr) {
             V2_1::IGnssMeasurementCallback::GnssData gnssData;
-            convertGnssData_2_1(gnssMeasurementsNotification, gnssData);
+            convertGnssData_2_1(gnssMeasurementsNotification, mMeasurements_2_1, gnssData);
             auto r = gnssMeasurementCbIface_2_1->gnssMeasurementCb_2_1(gnssData);
             if (!r.isOk()) {
                 LOC_LOGE("%s] Error from gnssMeasurementCb description=%s",
@@ -240,7 +245,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
             }
         } else if (gnssMeasurementCbIface_2_0 != nullptr) {
             V2_0::IGnssMeasurementCallback::GnssData gnssData;
-            convertGnssData_2_0(gnssMeasurementsNotification, gnssData);
+            convertGnssData_2_0(gnssMeasurementsNotification, mMeasurements_2_0, gnssData);
             auto r = gnssMeasurementCbIface_2_0->gnssMeasurementCb_2_0(gnssData);
             if (!r.isOk()) {
                 LOC_LOGE("%s] Error from gnssMeasurementCb description=%s",
@@ -248,7 +253,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
             }
         } else if (gnssMeasurementCbIface_1_1 != nullptr) {
             V1_1::IGnssMeasurementCallback::GnssData gnssData;
-            convertGnssData_1_1(gnssMeasurementsNotification, gnssData);
+            convertGnssData_1_1(gnssMeasurementsNotification, mMeasurements_1_1, gnssData);
             auto r = gnssMeasurementCbIface_1_1->gnssMeasurementCb(gnssData);
             if (!r.isOk()) {
                 LOC_LOGE("%s] Error from gnssMeasurementCb description=%s",
@@ -266,67 +271,178 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
     }
 }
 
+using MeasurementFlags = IGnssMeasurementCallback::GnssMeasurementFlags;
+using MeasurementFlags_2_1 = V2_1::IGnssMeasurementCallback::GnssMeasurementFlags;
+using MeasurementState = IGnssMeasurementCallback::GnssMeasurementState;
+using AdrState = IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState;
+using ClockFlags = IGnssMeasurementCallback::GnssClockFlags;
+
+static const LocToHidlBit sMeasurementFlags[] = {
+    { GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT,
+      static_cast<uint32_t>(MeasurementFlags::HAS_SNR) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT,
+      static_cast<uint32_t>(MeasurementFlags::HAS_CARRIER_FREQUENCY) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT,
+      static_cast<uint32_t>(MeasurementFlags::HAS_CARRIER_CYCLES) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT,
+      static_cast<uint32_t>(MeasurementFlags::HAS_CARRIER_PHASE) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT,
+      static_cast<uint32_t>(MeasurementFlags::HAS_CARRIER_PHASE_UNCERTAINTY) },
+    { GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT,
+      static_cast<uint32_t>(MeasurementFlags::HAS_AUTOMATIC_GAIN_CONTROL) },
+};
+
+static const LocToHidlBit sMeasurementFlags_2_1[] = {
+    { GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_SNR) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_CARRIER_FREQUENCY) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_CARRIER_CYCLES) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_CARRIER_PHASE) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_CARRIER_PHASE_UNCERTAINTY) },
+    { GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_AUTOMATIC_GAIN_CONTROL) },
+    { GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_FULL_ISB) },
+    { GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_FULL_ISB_UNCERTAINTY) },
+    { GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_SATELLITE_ISB) },
+    { GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT,
+      static_cast<uint32_t>(MeasurementFlags_2_1::HAS_SATELLITE_ISB_UNCERTAINTY) },
+};
+
+// states known to the 1.0 interface
+static const LocToHidlBit sMeasurementStates_1_0[] = {
+    { GNSS_MEASUREMENTS_STATE_CODE_LOCK_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_CODE_LOCK) },
+    { GNSS_MEASUREMENTS_STATE_BIT_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_BIT_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_SUBFRAME_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_SUBFRAME_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_TOW_DECODED) },
+    { GNSS_MEASUREMENTS_STATE_MSEC_AMBIGUOUS_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_MSEC_AMBIGUOUS) },
+    { GNSS_MEASUREMENTS_STATE_SYMBOL_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_SYMBOL_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_GLO_STRING_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GLO_STRING_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_GLO_TOD_DECODED_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GLO_TOD_DECODED) },
+    { GNSS_MEASUREMENTS_STATE_BDS_D2_BIT_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_BDS_D2_BIT_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_BDS_D2_SUBFRAME_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_BDS_D2_SUBFRAME_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_GAL_E1BC_CODE_LOCK_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GAL_E1BC_CODE_LOCK) },
+    { GNSS_MEASUREMENTS_STATE_GAL_E1C_2ND_CODE_LOCK_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GAL_E1C_2ND_CODE_LOCK) },
+    { GNSS_MEASUREMENTS_STATE_GAL_E1B_PAGE_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GAL_E1B_PAGE_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_SBAS_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_SBAS_SYNC) },
+};
+
+static const LocToHidlBit sMeasurementStates[] = {
+    { GNSS_MEASUREMENTS_STATE_CODE_LOCK_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_CODE_LOCK) },
+    { GNSS_MEASUREMENTS_STATE_BIT_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_BIT_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_SUBFRAME_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_SUBFRAME_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_TOW_DECODED) },
+    { GNSS_MEASUREMENTS_STATE_MSEC_AMBIGUOUS_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_MSEC_AMBIGUOUS) },
+    { GNSS_MEASUREMENTS_STATE_SYMBOL_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_SYMBOL_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_GLO_STRING_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GLO_STRING_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_GLO_TOD_DECODED_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GLO_TOD_DECODED) },
+    { GNSS_MEASUREMENTS_STATE_BDS_D2_BIT_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_BDS_D2_BIT_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_BDS_D2_SUBFRAME_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_BDS_D2_SUBFRAME_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_GAL_E1BC_CODE_LOCK_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GAL_E1BC_CODE_LOCK) },
+    { GNSS_MEASUREMENTS_STATE_GAL_E1C_2ND_CODE_LOCK_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GAL_E1C_2ND_CODE_LOCK) },
+    { GNSS_MEASUREMENTS_STATE_GAL_E1B_PAGE_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GAL_E1B_PAGE_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_SBAS_SYNC_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_SBAS_SYNC) },
+    { GNSS_MEASUREMENTS_STATE_TOW_KNOWN_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_TOW_KNOWN) },
+    { GNSS_MEASUREMENTS_STATE_GLO_TOD_KNOWN_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_GLO_TOD_KNOWN) },
+    { GNSS_MEASUREMENTS_STATE_2ND_CODE_LOCK_BIT,
+      static_cast<uint32_t>(MeasurementState::STATE_2ND_CODE_LOCK) },
+};
+
+// ADR states known to the 1.0 interface
+static const LocToHidlBit sAdrStates_1_0[] = {
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT,
+      static_cast<uint32_t>(AdrState::ADR_STATE_VALID) },
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_RESET_BIT,
+      static_cast<uint32_t>(AdrState::ADR_STATE_RESET) },
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_CYCLE_SLIP_BIT,
+      static_cast<uint32_t>(AdrState::ADR_STATE_CYCLE_SLIP) },
+};
+
+static const LocToHidlBit sAdrStates[] = {
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT,
+      static_cast<uint32_t>(AdrState::ADR_STATE_VALID) },
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_RESET_BIT,
+      static_cast<uint32_t>(AdrState::ADR_STATE_RESET) },
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_CYCLE_SLIP_BIT,
+      static_cast<uint32_t>(AdrState::ADR_STATE_CYCLE_SLIP) },
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_HALF_CYCLE_RESOLVED_BIT,
+      static_cast<uint32_t>(AdrState::ADR_STATE_HALF_CYCLE_RESOLVED) },
+};
+
+static const LocToHidlBit sClockFlags[] = {
+    { GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT,
+      static_cast<uint32_t>(ClockFlags::HAS_LEAP_SECOND) },
+    { GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT,
+      static_cast<uint32_t>(ClockFlags::HAS_TIME_UNCERTAINTY) },
+    { GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT,
+      static_cast<uint32_t>(ClockFlags::HAS_FULL_BIAS) },
+    { GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT,
+      static_cast<uint32_t>(ClockFlags::HAS_BIAS) },
+    { GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT,
+      static_cast<uint32_t>(ClockFlags::HAS_BIAS_UNCERTAINTY) },
+    { GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT,
+      static_cast<uint32_t>(ClockFlags::HAS_DRIFT) },
+    { GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT,
+      static_cast<uint32_t>(ClockFlags::HAS_DRIFT_UNCERTAINTY) },
+};
+
+// indexed by GnssMeasurementsCodeType, GNSS_MEASUREMENTS_CODE_TYPE_OTHER excluded
+static const char* const sCodeTypes[] = {
+    "A", "B", "C", "I", "L", "M", "P", "Q", "S", "W", "X", "Y", "Z", "N"
+};
+
 static void convertGnssMeasurement(GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out)
 {
     memset(&out, 0, sizeof(out));
-    if (in.flags & GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT)
-        out.flags |= IGnssMeasurementCallback::GnssMeasurementFlags::HAS_SNR;
-    if (in.flags & GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT)
-        out.flags |= IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_FREQUENCY;
-    if (in.flags & GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT)
-        out.flags |= IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_CYCLES;
-    if (in.flags & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT)
-        out.flags |= IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_PHASE;
-    if (in.flags & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT)
-        out.flags |= IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_PHASE_UNCERTAINTY;
-    if (in.flags & GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT)
-        out.flags |= IGnssMeasurementCallback::GnssMeasurementFlags::HAS_AUTOMATIC_GAIN_CONTROL;
+    out.flags = convertBits(in.flags, sMeasurementFlags);
     convertGnssSvid(in, out.svid);
     convertGnssConstellationType(in.svType, out.constellation);
     out.timeOffsetNs = in.timeOffsetNs;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_CODE_LOCK_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_CODE_LOCK;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_BIT_SYNC_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_BIT_SYNC;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_SUBFRAME_SYNC_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_SUBFRAME_SYNC;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_TOW_DECODED;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_MSEC_AMBIGUOUS_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_MSEC_AMBIGUOUS;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_SYMBOL_SYNC_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_SYMBOL_SYNC;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_GLO_STRING_SYNC_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GLO_STRING_SYNC;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_GLO_TOD_DECODED_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GLO_TOD_DECODED;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_BDS_D2_BIT_SYNC_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_BDS_D2_BIT_SYNC;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_BDS_D2_SUBFRAME_SYNC_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_BDS_D2_SUBFRAME_SYNC;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_GAL_E1BC_CODE_LOCK_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GAL_E1BC_CODE_LOCK;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_GAL_E1C_2ND_CODE_LOCK_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GAL_E1C_2ND_CODE_LOCK;
-    if (in.stateMask & GNSS_MEASUREMENTS_STATE_GAL_E1B_PAGE_SYNC_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GAL_E1B_PAGE_SYNC;
-    if (in.stateMask &  GNSS_MEASUREMENTS_STATE_SBAS_SYNC_BIT)
-        out.state |= IGnssMeasurementCallback::GnssMeasurementState::STATE_SBAS_SYNC;
+    out.state = convertBits(in.stateMask, sMeasurementStates_1_0);
     out.receivedSvTimeInNs = in.receivedSvTimeNs;
     out.receivedSvTimeUncertaintyInNs = in.receivedSvTimeUncertaintyNs;
     out.cN0DbHz = in.carrierToNoiseDbHz;
     out.pseudorangeRateMps = in.pseudorangeRateMps;
     out.pseudorangeRateUncertaintyMps = in.pseudorangeRateUncertaintyMps;
-    if (in.adrStateMask & GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT)
-        out.accumulatedDeltaRangeState |=
-            IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState::ADR_STATE_VALID;
-    if (in.adrStateMask & GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_RESET_BIT)
-        out.accumulatedDeltaRangeState |=
-            IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState::ADR_STATE_RESET;
-    if (in.adrStateMask & GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_CYCLE_SLIP_BIT)
-        out.accumulatedDeltaRangeState |=
-            IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState::ADR_STATE_CYCLE_SLIP;
+    out.accumulatedDeltaRangeState =
+            static_cast<uint16_t>(convertBits(in.adrStateMask, sAdrStates_1_0));
     out.accumulatedDeltaRangeM = in.adrMeters;
     out.accumulatedDeltaRangeUncertaintyM = in.adrUncertaintyMeters;
     out.carrierFrequencyHz = in.carrierFrequencyHz;
@@ -345,23 +461,21 @@ static void convertGnssMeasurement(GnssMeasurementsData& in,
     out.agcLevelDb = in.agcLevelDb;
 }
 
+static void convertGnssMeasurement_2_0(GnssMeasurementsData& in,
+        V2_0::IGnssMeasurementCallback::GnssMeasurement& out)
+{
+    convertGnssMeasurement(in, out.v1_1.v1_0);
+    convertGnssConstellationType(in.svType, out.constellation);
+    convertGnssMeasurementsCodeType(in.codeType, in.otherCodeTypeName, out.codeType);
+    convertGnssMeasurementsAccumulatedDeltaRangeState(in.adrStateMask,
+            out.v1_1.accumulatedDeltaRangeState);
+    convertGnssMeasurementsState(in.stateMask, out.state);
+}
+
 static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out)
 {
     memset(&out, 0, sizeof(out));
-    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT)
-        out.gnssClockFlags |= IGnssMeasurementCallback::GnssClockFlags::HAS_LEAP_SECOND;
-    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT)
-        out.gnssClockFlags |= IGnssMeasurementCallback::GnssClockFlags::HAS_TIME_UNCERTAINTY;
-    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT)
-        out.gnssClockFlags |= IGnssMeasurementCallback::GnssClockFlags::HAS_FULL_BIAS;
-    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT)
-        out.gnssClockFlags |= IGnssMeasurementCallback::GnssClockFlags::HAS_BIAS;
-    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT)
-        out.gnssClockFlags |= IGnssMeasurementCallback::GnssClockFlags::HAS_BIAS_UNCERTAINTY;
-    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT)
-        out.gnssClockFlags |= IGnssMeasurementCallback::GnssClockFlags::HAS_DRIFT;
-    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT)
-        out.gnssClockFlags |= IGnssMeasurementCallback::GnssClockFlags::HAS_DRIFT_UNCERTAINTY;
+    out.gnssClockFlags = static_cast<uint16_t>(convertBits(in.flags, sClockFlags));
     out.leapSecond = in.leapSecond;
     out.timeNs = in.timeNs;
     out.timeUncertaintyNs = in.timeUncertaintyNs;
@@ -403,34 +517,38 @@ static void convertGnssData(GnssMeasurementsNotification& in,
     convertGnssClock(in.clock, out.clock);
 }
 
+/* The measurements vectors are the client's storage, kept across epochs so
+   they only grow to the largest measurement count seen; out.measurements is
+   pointed at the first in.count entries instead of being resized. */
 static void convertGnssData_1_1(GnssMeasurementsNotification& in,
+        std::vector<V1_1::IGnssMeasurementCallback::GnssMeasurement>& measurements,
         V1_1::IGnssMeasurementCallback::GnssData& out)
 {
     memset(&out, 0, sizeof(out));
-    out.measurements.resize(in.count);
+    if (measurements.size() < in.count) {
+        measurements.resize(in.count);
+    }
     for (size_t i = 0; i < in.count; i++) {
-        convertGnssMeasurement(in.measurements[i], out.measurements[i].v1_0);
+        convertGnssMeasurement(in.measurements[i], measurements[i].v1_0);
         convertGnssMeasurementsAccumulatedDeltaRangeState(in.measurements[i].adrStateMask,
-                out.measurements[i].accumulatedDeltaRangeState);
+                measurements[i].accumulatedDeltaRangeState);
     }
+    out.measurements.setToExternal(measurements.data(), in.count);
     convertGnssClock(in.clock, out.clock);
 }
 
 static void convertGnssData_2_0(GnssMeasurementsNotification& in,
+        std::vector<V2_0::IGnssMeasurementCallback::GnssMeasurement>& measurements,
         V2_0::IGnssMeasurementCallback::GnssData& out)
 {
     memset(&out, 0, sizeof(out));
-    out.measurements.resize(in.count);
+    if (measurements.size() < in.count) {
+        measurements.resize(in.count);
+    }
     for (size_t i = 0; i < in.count; i++) {
-        convertGnssMeasurement(in.measurements[i], out.measurements[i].v1_1.v1_0);
-        convertGnssConstellationType(in.measurements[i].svType, out.measurements[i].constellation);
-        convertGnssMeasurementsCodeType(in.measurements[i].codeType,
-            in.measurements[i].otherCodeTypeName,
-            out.measurements[i].codeType);
-        convertGnssMeasurementsAccumulatedDeltaRangeState(in.measurements[i].adrStateMask,
-                out.measurements[i].v1_1.accumulatedDeltaRangeState);
-        convertGnssMeasurementsState(in.measurements[i].stateMask, out.measurements[i].state);
+        convertGnssMeasurement_2_0(in.measurements[i], measurements[i]);
     }
+    out.measurements.setToExternal(measurements.data(), in.count);
     convertGnssClock(in.clock, out.clock);
     convertElapsedRealtimeNanos(in, out.elapsedRealtime);
 }
@@ -438,54 +556,12 @@ static void convertGnssData_2_0(GnssMeasurementsNotification& in,
 static void convertGnssMeasurementsCodeType(GnssMeasurementsCodeType& inCodeType,
         char* inOtherCodeTypeName, ::android::hardware::hidl_string& out)
 {
-    memset(&out, 0, sizeof(out));
-    switch(inCodeType) {
-        case GNSS_MEASUREMENTS_CODE_TYPE_A:
-            out = "A";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_B:
-            out = "B";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_C:
-            out = "C";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_I:
-            out = "I";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_L:
-            out = "L";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_M:
-            out = "M";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_P:
-            out = "P";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_Q:
-            out = "Q";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_S:
-            out = "S";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_W:
-            out = "W";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_X:
-            out = "X";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_Y:
-            out = "Y";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_Z:
-            out = "Z";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_N:
-            out = "N";
-            break;
-        case GNSS_MEASUREMENTS_CODE_TYPE_OTHER:
-        default:
-            out = inOtherCodeTypeName;
-            break;
+    size_t index = static_cast<size_t>(inCodeType);
+    if (index < sizeof(sCodeTypes) / sizeof(sCodeTypes[0])) {
+        // points at the static literal, nothing is copied
+        out.setToExternal(sCodeTypes[index], 1);
+    } else {
+        out = inOtherCodeTypeName;
     }
 }
 
@@ -493,129 +569,46 @@ static void convertGnssMeasurementsAccumulatedDeltaRangeState(GnssMeasurementsAd
         ::android::hardware::hidl_bitfield
                 <V1_1::IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState>& out)
 {
-    memset(&out, 0, sizeof(out));
-    if (in & GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT)
-        out |= IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState::ADR_STATE_VALID;
-    if (in & GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_RESET_BIT)
-        out |= IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState::ADR_STATE_RESET;
-    if (in & GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_CYCLE_SLIP_BIT)
-        out |= IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState::ADR_STATE_CYCLE_SLIP;
-    if (in & GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_HALF_CYCLE_RESOLVED_BIT)
-        out |= IGnssMeasurementCallback::
-                GnssAccumulatedDeltaRangeState::ADR_STATE_HALF_CYCLE_RESOLVED;
+    out = static_cast<uint16_t>(convertBits(in, sAdrStates));
 }
 
 static void convertGnssMeasurementsState(GnssMeasurementsStateMask& in,
         ::android::hardware::hidl_bitfield
                 <V2_0::IGnssMeasurementCallback::GnssMeasurementState>& out)
 {
-    memset(&out, 0, sizeof(out));
-    if (in & GNSS_MEASUREMENTS_STATE_CODE_LOCK_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_CODE_LOCK;
-    if (in & GNSS_MEASUREMENTS_STATE_BIT_SYNC_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_BIT_SYNC;
-    if (in & GNSS_MEASUREMENTS_STATE_SUBFRAME_SYNC_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_SUBFRAME_SYNC;
-    if (in & GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_TOW_DECODED;
-    if (in & GNSS_MEASUREMENTS_STATE_MSEC_AMBIGUOUS_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_MSEC_AMBIGUOUS;
-    if (in & GNSS_MEASUREMENTS_STATE_SYMBOL_SYNC_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_SYMBOL_SYNC;
-    if (in & GNSS_MEASUREMENTS_STATE_GLO_STRING_SYNC_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GLO_STRING_SYNC;
-    if (in & GNSS_MEASUREMENTS_STATE_GLO_TOD_DECODED_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GLO_TOD_DECODED;
-    if (in & GNSS_MEASUREMENTS_STATE_BDS_D2_BIT_SYNC_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_BDS_D2_BIT_SYNC;
-    if (in & GNSS_MEASUREMENTS_STATE_BDS_D2_SUBFRAME_SYNC_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_BDS_D2_SUBFRAME_SYNC;
-    if (in & GNSS_MEASUREMENTS_STATE_GAL_E1BC_CODE_LOCK_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GAL_E1BC_CODE_LOCK;
-    if (in & GNSS_MEASUREMENTS_STATE_GAL_E1C_2ND_CODE_LOCK_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GAL_E1C_2ND_CODE_LOCK;
-    if (in & GNSS_MEASUREMENTS_STATE_GAL_E1B_PAGE_SYNC_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GAL_E1B_PAGE_SYNC;
-    if (in & GNSS_MEASUREMENTS_STATE_SBAS_SYNC_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_SBAS_SYNC;
-    if (in & GNSS_MEASUREMENTS_STATE_TOW_KNOWN_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_TOW_KNOWN;
-    if (in & GNSS_MEASUREMENTS_STATE_GLO_TOD_KNOWN_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_GLO_TOD_KNOWN;
-    if (in & GNSS_MEASUREMENTS_STATE_2ND_CODE_LOCK_BIT)
-        out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_2ND_CODE_LOCK;
+    out = convertBits(in, sMeasurementStates);
 }
 
 static void convertGnssData_2_1(GnssMeasurementsNotification& in,
+        std::vector<V2_1::IGnssMeasurementCallback::GnssMeasurement>& measurements,
         V2_1::IGnssMeasurementCallback::GnssData& out)
 {
     memset(&out, 0, sizeof(out));
-    out.measurements.resize(in.count);
+    if (measurements.size() < in.count) {
+        measurements.resize(in.count);
+    }
     for (size_t i = 0; i < in.count; i++) {
-        out.measurements[i].flags = 0;
-        convertGnssMeasurement(in.measurements[i], out.measurements[i].v2_0.v1_1.v1_0);
-        convertGnssConstellationType(in.measurements[i].svType,
-                out.measurements[i].v2_0.constellation);
-        convertGnssMeasurementsCodeType(in.measurements[i].codeType,
-                in.measurements[i].otherCodeTypeName,
-                out.measurements[i].v2_0.codeType);
-        convertGnssMeasurementsAccumulatedDeltaRangeState(in.measurements[i].adrStateMask,
-                out.measurements[i].v2_0.v1_1.accumulatedDeltaRangeState);
-        convertGnssMeasurementsState(in.measurements[i].stateMask,
-                out.measurements[i].v2_0.state);
-        out.measurements[i].basebandCN0DbHz = in.measurements[i].basebandCarrierToNoiseDbHz;
-
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_SNR;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_FREQUENCY;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_CYCLES;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_PHASE;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::
-                        GnssMeasurementFlags::HAS_CARRIER_PHASE_UNCERTAINTY;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_AUTOMATIC_GAIN_CONTROL;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) {
-            out.measurements[i].fullInterSignalBiasNs = in.measurements[i].fullInterSignalBiasNs;
-            out.measurements[i].flags |=
-                    V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_FULL_ISB;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) {
-            out.measurements[i].fullInterSignalBiasUncertaintyNs =
-                    in.measurements[i].fullInterSignalBiasUncertaintyNs;
-            out.measurements[i].flags |=
-                    V2_1::IGnssMeasurementCallback::
-                            GnssMeasurementFlags::HAS_FULL_ISB_UNCERTAINTY;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT) {
-            out.measurements[i].satelliteInterSignalBiasNs =
-                    in.measurements[i].satelliteInterSignalBiasNs;
-            out.measurements[i].flags |=
-                    V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_SATELLITE_ISB;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT) {
-            out.measurements[i].satelliteInterSignalBiasUncertaintyNs =
-                    in.measurements[i].satelliteInterSignalBiasUncertaintyNs;
-            out.measurements[i].flags |=
-                    V2_1::IGnssMeasurementCallback::
-                            GnssMeasurementFlags::HAS_SATELLITE_ISB_UNCERTAINTY;
-        }
+        GnssMeasurementsData& data = in.measurements[i];
+        V2_1::IGnssMeasurementCallback::GnssMeasurement& measurement = measurements[i];
+
+        convertGnssMeasurement_2_0(data, measurement.v2_0);
+        measurement.basebandCN0DbHz = data.basebandCarrierToNoiseDbHz;
+        measurement.flags = convertBits(data.flags, sMeasurementFlags_2_1);
+        // storage is reused, so absent values are cleared rather than left over
+        measurement.fullInterSignalBiasNs =
+                (data.flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) ?
+                data.fullInterSignalBiasNs : 0;
+        measurement.fullInterSignalBiasUncertaintyNs =
+                (data.flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) ?
+                data.fullInterSignalBiasUncertaintyNs : 0;
+        measurement.satelliteInterSignalBiasNs =
+                (data.flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT) ?
+                data.satelliteInterSignalBiasNs : 0;
+        measurement.satelliteInterSignalBiasUncertaintyNs =
+                (data.flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT) ?
+                data.satelliteInterSignalBiasUncertaintyNs : 0;
     }
+    out.measurements.setToExternal(measurements.data(), in.count);
     convertGnssClock_2_1(in.clock, out.clock);
     convertElapsedRealtimeNanos(in, out.elapsedRealtime);
 }
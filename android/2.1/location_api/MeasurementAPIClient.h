@@ -31,6 +31,7 @@
 #define MEASUREMENT_API_CLINET_H
 
 #include <mutex>
+#include <vector>
 #include <android/hardware/gnss/2.1/IGnssMeasurement.h>
 //#include <android/hardware/gnss/1.1/IGnssMeasurementCallback.h>
 #include <android/hardware/gnss/2.1/IGnssMeasurementCallback.h>
@@ -86,6 +87,11 @@ private:
     sp<V2_1::IGnssMeasurementCallback> mGnssMeasurementCbIface_2_1;
     bool mTracking;
     void clearInterfaces();
+
+    // conversion storage reused across epochs, only touched from onGnssMeasurementsCb
+    std::vector<V1_1::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_1_1;
+    std::vector<V2_0::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_2_0;
+    std::vector<V2_1::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_2_1;
 };
 
 }  // namespace implementation
@@ -40,6 +40,8 @@
 #include <hidl/HidlTransportSupport.h>
 #include <thread>
 #include <log_util.h>
+#include <loc_cfg.h>
+#include <LocPowerStateFilter.h>
 
 using android::hardware::interfacesEqual;
 using android::hardware::Return;
@@ -50,18 +52,22 @@ using android::hardware::health::V2_1::IHealthInfoCallback;
 using android::hardware::health::V2_1::IHealth;
 using android::hardware::health::V2_0::Result;
 using android::hidl::manager::V1_0::IServiceManager;
-using namespace std::literals::chrono_literals;
+using loc_util::LocChargeStatus;
+using loc_util::LocPowerStateFilter;
 
 static bool sIsBatteryListened = false;
 namespace android {
 
 #define GET_HEALTH_SVC_RETRY_CNT 5
 #define GET_HEALTH_SVC_WAIT_TIME_MS 500
+/* NOT_CHARGING is seen for about a second after a charger is plugged in,
+ * before CHARGING; hold NOT_CHARGING this long before reporting it */
+#define DEFAULT_POWER_STATE_SETTLE_WINDOW_MS 3000
 
 struct BatteryListenerImpl : public hardware::health::V2_1::IHealthInfoCallback,
                              public hardware::hidl_death_recipient {
     typedef std::function<void(bool)> cb_fn_t;
-    BatteryListenerImpl(cb_fn_t cb);
+    BatteryListenerImpl(cb_fn_t cb, uint32_t settleWindowMs);
     virtual ~BatteryListenerImpl ();
     virtual hardware::Return<void> healthInfoChanged(
             const hardware::health::V2_0::HealthInfo& info);
@@ -70,21 +76,31 @@ struct BatteryListenerImpl : public hardware::health::V2_1::IHealthInfoCallback,
     virtual void serviceDied(uint64_t cookie,
                              const wp<hidl::base::V1_0::IBase>& who);
     bool isCharging() {
-        std::lock_guard<std::mutex> _l(mLock);
-        return statusToBool(mStatus);
+        return mFilter.isCharging();
+    }
+    LocPowerStateFilter::Stats getFilterStats() {
+        return mFilter.getStats();
     }
   private:
     sp<hardware::health::V2_1::IHealth> mHealth;
     status_t init();
     BatteryStatus mStatus;
-    cb_fn_t mCb;
     std::mutex mLock;
-    std::condition_variable mCond;
-    std::unique_ptr<std::thread> mThread;
-    bool mDone;
-    bool statusToBool(const BatteryStatus &s) const {
-        return (s == BatteryStatus::CHARGING) ||
-               (s ==  BatteryStatus::FULL);
+    // coalesces health updates into charging edges, published to the cb
+    LocPowerStateFilter mFilter;
+    static LocChargeStatus toChargeStatus(const BatteryStatus &s) {
+        switch (s) {
+            case BatteryStatus::CHARGING:
+                return loc_util::LOC_CHARGE_STATUS_CHARGING;
+            case BatteryStatus::DISCHARGING:
+                return loc_util::LOC_CHARGE_STATUS_DISCHARGING;
+            case BatteryStatus::NOT_CHARGING:
+                return loc_util::LOC_CHARGE_STATUS_NOT_CHARGING;
+            case BatteryStatus::FULL:
+                return loc_util::LOC_CHARGE_STATUS_FULL;
+            default:
+                return loc_util::LOC_CHARGE_STATUS_UNKNOWN;
+        }
     }
 };
 
@@ -123,43 +139,6 @@ status_t BatteryListenerImpl::init()
     if (mStatus == BatteryStatus::UNKNOWN) {
         LOC_LOGw("batterylistener: init: invalid battery status");
     }
-    mDone = false;
-    mThread = std::make_unique<std::thread>([this]() {
-            std::unique_lock<std::mutex> l(mLock);
-            BatteryStatus local_status = mStatus;
-            while (!mDone) {
-                if (local_status == mStatus) {
-                    mCond.wait(l);
-                    continue;
-                }
-                local_status = mStatus;
-                switch (local_status) {
-                    // NOT_CHARGING is a special event that indicates, a battery is connected,
-                    // but not charging. This is seen for approx a second
-                    // after charger is plugged in. A charging event is eventually received.
-                    // We must try to avoid an unnecessary cb to HAL
-                    // only to call it again shortly.
-                    // An option to deal with this transient event would be to ignore this.
-                    // Or process this event with a slight delay (i.e cancel this event
-                    // if a different event comes in within a timeout
-                    case BatteryStatus::NOT_CHARGING : {
-                        auto mStatusnot_ncharging =
-                                [this, local_status]() { return mStatus != local_status; };
-                        mCond.wait_for(l, 3s, mStatusnot_ncharging);
-                        if (mStatusnot_ncharging()) // i.e event changed
-                            break;
-                        [[clang::fallthrough]]; //explicit fall-through between switch labels
-                    }
-                    default:
-                        bool c = statusToBool(local_status);
-                        LOC_LOGi("healthInfo cb thread: cb %s", c ? "CHARGING" : "NOT CHARGING");
-                        l.unlock();
-                        mCb(c);
-                        l.lock();
-                        break;
-                }
-            }
-    });
     auto reg = mHealth->registerCallback(this);
     if (!reg.isOk()) {
         LOC_LOGe("Transaction error in registeringCb to HealthHAL death: %s",
@@ -174,60 +153,48 @@ status_t BatteryListenerImpl::init()
     return NO_ERROR;
 }
 
-BatteryListenerImpl::BatteryListenerImpl(cb_fn_t cb) :
-        mCb(cb)
+BatteryListenerImpl::BatteryListenerImpl(cb_fn_t cb, uint32_t settleWindowMs) :
+        mStatus(BatteryStatus::UNKNOWN), mFilter(cb, settleWindowMs)
 {
+    std::lock_guard<std::mutex> _l(mLock);
     init();
+    mFilter.seed(LocPowerStateFilter::isChargingStatus(toChargeStatus(mStatus)));
 }
 
 BatteryListenerImpl::~BatteryListenerImpl()
 {
-    {
-        std::lock_guard<std::mutex> _l(mLock);
-        if (mHealth != NULL)
-            mHealth->unregisterCallback(this);
-            auto r = mHealth->unlinkToDeath(this);
-            if (!r.isOk() || r == false) {
-                LOC_LOGe("Transaction error in unregister to HealthHAL death: %s",
-                        r.description().c_str());
-            }
+    std::lock_guard<std::mutex> _l(mLock);
+    if (mHealth != NULL) {
+        mHealth->unregisterCallback(this);
+        auto r = mHealth->unlinkToDeath(this);
+        if (!r.isOk() || r == false) {
+            LOC_LOGe("Transaction error in unregister to HealthHAL death: %s",
+                    r.description().c_str());
+        }
     }
-    mDone = true;
-    mThread->join();
 }
 
 void BatteryListenerImpl::serviceDied(uint64_t cookie __unused,
                                      const wp<hidl::base::V1_0::IBase>& who)
 {
-    {
-        std::lock_guard<std::mutex> _l(mLock);
-        if (mHealth == NULL || !interfacesEqual(mHealth, who.promote())) {
-            LOC_LOGe("health not initialized or unknown interface died");
-            return;
-        }
-        LOC_LOGi("health service died, reinit");
-        mDone = true;
+    std::lock_guard<std::mutex> _l(mLock);
+    if (mHealth == NULL || !interfacesEqual(mHealth, who.promote())) {
+        LOC_LOGe("health not initialized or unknown interface died");
+        return;
     }
+    LOC_LOGi("health service died, reinit");
     mHealth = NULL;
-    mCond.notify_one();
-    mThread->join();
-    std::lock_guard<std::mutex> _l(mLock);
     init();
+    // the state may have changed while the service was down
+    mFilter.onChargeStatus(toChargeStatus(mStatus));
 }
 
-// this callback seems to be a SYNC callback and so
-// waits for return before next event is issued.
-// therefore we need not have a queue to process
-// NOT_CHARGING and CHARGING concurrencies.
-// Replace single var by a list if this assumption is broken
+// Health updates arrive often, e.g. on every level change while charging;
+// the filter drops the ones that do not change the charging state
 Return<void> BatteryListenerImpl::healthInfoChanged(
         const hardware::health::V2_0::HealthInfo& info) {
     LOC_LOGv("healthInfoChanged: %d", info.legacy.batteryStatus);
-    std::unique_lock<std::mutex> l(mLock);
-    if (info.legacy.batteryStatus != mStatus) {
-        mStatus = info.legacy.batteryStatus;
-        mCond.notify_one();
-    }
+    mFilter.onChargeStatus(toChargeStatus(info.legacy.batteryStatus));
     return Void();
 }
 
@@ -245,7 +212,13 @@ bool batteryPropertiesListenerIsCharging() {
 }
 
 status_t batteryPropertiesListenerInit(BatteryListenerImpl::cb_fn_t cb) {
-    batteryListener = new BatteryListenerImpl(cb);
+    uint32_t settleWindowMs = DEFAULT_POWER_STATE_SETTLE_WINDOW_MS;
+    loc_param_s_type powerStateConfTable[] =
+    {
+        { "POWER_STATE_SETTLE_WINDOW_MS", &settleWindowMs, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, powerStateConfTable);
+    batteryListener = new BatteryListenerImpl(cb, settleWindowMs);
     bool isCharging = batteryPropertiesListenerIsCharging();
     LOC_LOGv("charging status: %s charging", isCharging ? "" : "not");;
     if (isCharging) {
@@ -254,6 +227,13 @@ status_t batteryPropertiesListenerInit(BatteryListenerImpl::cb_fn_t cb) {
     return NO_ERROR;
 }
 
+void batteryPropertiesListenerGetFilterStats(LocPowerStateFilter::Stats& stats) {
+    sp<BatteryListenerImpl> listener = batteryListener;
+    if (listener != nullptr) {
+        stats = listener->getFilterStats();
+    }
+}
+
 status_t batteryPropertiesListenerDeinit() {
     batteryListener.clear();
     return OK;
@@ -278,3 +258,12 @@ void loc_extn_battery_properties_listener_deinit() {
 bool loc_extn_battery_properties_is_charging() {
     return android::batteryPropertiesListenerIsCharging();
 }
+
+void loc_extn_battery_properties_get_filter_stats(uint64_t* received, uint64_t* published,
+                                                  uint64_t* suppressed) {
+    LocPowerStateFilter::Stats stats = {0, 0, 0};
+    android::batteryPropertiesListenerGetFilterStats(stats);
+    *received = stats.mReceived;
+    *published = stats.mPublished;
+    *suppressed = stats.mSuppressed;
+}
@@ -26,7 +26,13 @@
 * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
 * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#include <stdint.h>
+
 typedef void (* battery_status_change_fn_t)(bool);
 void loc_extn_battery_properties_listener_init(battery_status_change_fn_t fn);
 void loc_extn_battery_properties_listener_deinit();
 bool loc_extn_battery_properties_is_charging();
+// health updates received, charging edges published, and updates suppressed as redundant
+// or undone in time; all 0 until the listener is up
+void loc_extn_battery_properties_get_filter_stats(uint64_t* received, uint64_t* published,
+                                                  uint64_t* suppressed);
@@ -0,0 +1,348 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_BatchedLocationStore"
+
+#include <string.h>
+#include <inttypes.h>
+#include <log_util.h>
+#include <BatchedLocationStore.h>
+
+static inline void putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+// fails on a varint running past end or longer than 64 bits
+static inline bool getVarint(const uint8_t* in, uint32_t end, uint32_t& offset,
+                             uint64_t& value)
+{
+    value = 0;
+    for (uint32_t shift = 0; shift < 64 && offset < end; shift += 7) {
+        uint8_t byte = in[offset++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (0 == (byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// floating point fields are stored as their bit patterns, so they read back
+// bit for bit. Close values share sign, exponent and upper mantissa, so the
+// delta of their patterns stays small.
+static inline int64_t doubleBits(double value)
+{
+    int64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline double bitsDouble(int64_t bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static inline int64_t floatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float bitsFloat(int64_t bits)
+{
+    uint32_t bits32 = (uint32_t)bits;
+    float value;
+    memcpy(&value, &bits32, sizeof(value));
+    return value;
+}
+
+// masks are stored as they are, all other columns as delta to the previous fix
+static inline bool isDeltaColumn(uint32_t column)
+{
+    return BatchedLocationStore::COLUMN_FLAGS != column &&
+           BatchedLocationStore::COLUMN_TECH_MASK != column &&
+           BatchedLocationStore::COLUMN_SPOOF_MASK != column &&
+           BatchedLocationStore::COLUMN_ELAPSED_REAL_TIME_UNC != column;
+}
+
+static int64_t getColumnValue(const Location& location, uint32_t column)
+{
+    switch (column) {
+    case BatchedLocationStore::COLUMN_FLAGS:
+        return location.flags;
+    case BatchedLocationStore::COLUMN_TIMESTAMP:
+        return (int64_t)location.timestamp;
+    case BatchedLocationStore::COLUMN_LATITUDE:
+        return doubleBits(location.latitude);
+    case BatchedLocationStore::COLUMN_LONGITUDE:
+        return doubleBits(location.longitude);
+    case BatchedLocationStore::COLUMN_ALTITUDE:
+        return doubleBits(location.altitude);
+    case BatchedLocationStore::COLUMN_SPEED:
+        return floatBits(location.speed);
+    case BatchedLocationStore::COLUMN_BEARING:
+        return floatBits(location.bearing);
+    case BatchedLocationStore::COLUMN_ACCURACY:
+        return floatBits(location.accuracy);
+    case BatchedLocationStore::COLUMN_VERTICAL_ACCURACY:
+        return floatBits(location.verticalAccuracy);
+    case BatchedLocationStore::COLUMN_SPEED_ACCURACY:
+        return floatBits(location.speedAccuracy);
+    case BatchedLocationStore::COLUMN_BEARING_ACCURACY:
+        return floatBits(location.bearingAccuracy);
+    case BatchedLocationStore::COLUMN_CONFORMITY_INDEX:
+        return floatBits(location.conformityIndex);
+    case BatchedLocationStore::COLUMN_TECH_MASK:
+        return location.techMask;
+    case BatchedLocationStore::COLUMN_SPOOF_MASK:
+        return location.spoofMask;
+    case BatchedLocationStore::COLUMN_ELAPSED_REAL_TIME:
+        return (int64_t)location.elapsedRealTime;
+    case BatchedLocationStore::COLUMN_ELAPSED_REAL_TIME_UNC:
+        return (int64_t)location.elapsedRealTimeUnc;
+    default:
+        return 0;
+    }
+}
+
+static void setColumnValue(Location& location, uint32_t column, int64_t value)
+{
+    switch (column) {
+    case BatchedLocationStore::COLUMN_FLAGS:
+        location.flags = (LocationFlagsMask)value;
+        break;
+    case BatchedLocationStore::COLUMN_TIMESTAMP:
+        location.timestamp = (uint64_t)value;
+        break;
+    case BatchedLocationStore::COLUMN_LATITUDE:
+        location.latitude = bitsDouble(value);
+        break;
+    case BatchedLocationStore::COLUMN_LONGITUDE:
+        location.longitude = bitsDouble(value);
+        break;
+    case BatchedLocationStore::COLUMN_ALTITUDE:
+        location.altitude = bitsDouble(value);
+        break;
+    case BatchedLocationStore::COLUMN_SPEED:
+        location.speed = bitsFloat(value);
+        break;
+    case BatchedLocationStore::COLUMN_BEARING:
+        location.bearing = bitsFloat(value);
+        break;
+    case BatchedLocationStore::COLUMN_ACCURACY:
+        location.accuracy = bitsFloat(value);
+        break;
+    case BatchedLocationStore::COLUMN_VERTICAL_ACCURACY:
+        location.verticalAccuracy = bitsFloat(value);
+        break;
+    case BatchedLocationStore::COLUMN_SPEED_ACCURACY:
+        location.speedAccuracy = bitsFloat(value);
+        break;
+    case BatchedLocationStore::COLUMN_BEARING_ACCURACY:
+        location.bearingAccuracy = bitsFloat(value);
+        break;
+    case BatchedLocationStore::COLUMN_CONFORMITY_INDEX:
+        location.conformityIndex = bitsFloat(value);
+        break;
+    case BatchedLocationStore::COLUMN_TECH_MASK:
+        location.techMask = (LocationTechnologyMask)value;
+        break;
+    case BatchedLocationStore::COLUMN_SPOOF_MASK:
+        location.spoofMask = (LocationSpoofMask)value;
+        break;
+    case BatchedLocationStore::COLUMN_ELAPSED_REAL_TIME:
+        location.elapsedRealTime = (uint64_t)value;
+        break;
+    case BatchedLocationStore::COLUMN_ELAPSED_REAL_TIME_UNC:
+        location.elapsedRealTimeUnc = (uint64_t)value;
+        break;
+    default:
+        break;
+    }
+}
+
+void BatchedLocationStore::encode(const Location* locations, size_t count,
+                                  BatchingMode batchingMode, Block& block)
+{
+    std::vector<uint8_t> columns[COLUMN_COUNT];
+
+    block.batchingMode = batchingMode;
+    block.count = (uint32_t)count;
+    for (uint32_t column = 0; column < COLUMN_COUNT; column++) {
+        bool delta = isDeltaColumn(column);
+        int64_t prev = 0;
+        columns[column].reserve(count * 2);
+        for (size_t i = 0; i < count; i++) {
+            int64_t value = getColumnValue(locations[i], column);
+            if (delta) {
+                putVarint(columns[column], zigzag((int64_t)((uint64_t)value - (uint64_t)prev)));
+                prev = value;
+            } else {
+                putVarint(columns[column], (uint64_t)value);
+            }
+        }
+    }
+
+    size_t size = 0;
+    for (uint32_t column = 0; column < COLUMN_COUNT; column++) {
+        block.columnOffset[column] = (uint32_t)size;
+        size += columns[column].size();
+    }
+    block.columnOffset[COLUMN_COUNT] = (uint32_t)size;
+    block.data.clear();
+    block.data.reserve(size);
+    for (uint32_t column = 0; column < COLUMN_COUNT; column++) {
+        block.data.insert(block.data.end(), columns[column].begin(), columns[column].end());
+    }
+}
+
+void BatchedLocationStore::push(Block&& block)
+{
+    if (0 == block.count) {
+        return;
+    }
+    mStats.storedLocations += block.count;
+    mStats.rawBytes += (uint64_t)block.count * sizeof(Location);
+    mStats.encodedBytes += block.data.size();
+
+    mCurrentBytes += block.data.size();
+    mBlocks.push_back(std::move(block));
+
+    // drop the oldest blocks over the byte budget, but neither the block
+    // being read nor the one just pushed
+    size_t dropIndex = (0 != mReadIndex) ? 1 : 0;
+    while (0 != mMaxBytes && mCurrentBytes > mMaxBytes && dropIndex + 1 < mBlocks.size()) {
+        auto dropIt = mBlocks.begin() + dropIndex;
+        LOC_LOGw("store over %zu bytes, dropping %u locations", mMaxBytes, dropIt->count);
+        mStats.droppedLocations += dropIt->count;
+        mCurrentBytes -= dropIt->data.size();
+        mBlocks.erase(dropIt);
+    }
+    if (mCurrentBytes > mStats.peakBytes) {
+        mStats.peakBytes = mCurrentBytes;
+    }
+    mStats.currentBytes = mCurrentBytes;
+}
+
+size_t BatchedLocationStore::read(Location* locations, size_t maxCount,
+                                  BatchingMode& batchingMode)
+{
+    if (mBlocks.empty() || 0 == maxCount) {
+        return 0;
+    }
+
+    const Block& block = mBlocks.front();
+    if (0 == mReadIndex) {
+        if (!isValid(block)) {
+            dropFront("invalid column offsets");
+            return 0;
+        }
+        memcpy(mReadOffset, block.columnOffset, sizeof(mReadOffset));
+        memset(mReadPrev, 0, sizeof(mReadPrev));
+    }
+
+    size_t count = block.count - mReadIndex;
+    if (count > maxCount) {
+        count = maxCount;
+    }
+    const uint8_t* data = block.data.data();
+    for (size_t i = 0; i < count; i++) {
+        memset(&locations[i], 0, sizeof(Location));
+        locations[i].size = sizeof(Location);
+    }
+    for (uint32_t column = 0; column < COLUMN_COUNT; column++) {
+        bool delta = isDeltaColumn(column);
+        uint32_t columnEnd = block.columnOffset[column + 1];
+        for (size_t i = 0; i < count; i++) {
+            uint64_t raw;
+            if (!getVarint(data, columnEnd, mReadOffset[column], raw)) {
+                dropFront("truncated column");
+                return 0;
+            }
+            int64_t value = (int64_t)raw;
+            if (delta) {
+                value = (int64_t)((uint64_t)mReadPrev[column] + (uint64_t)unzigzag(raw));
+                mReadPrev[column] = value;
+            }
+            setColumnValue(locations[i], column, value);
+        }
+    }
+
+    batchingMode = block.batchingMode;
+    mReadIndex += (uint32_t)count;
+    mStats.deliveredChunks++;
+    if (mReadIndex >= block.count) {
+        popFront();
+    }
+    return count;
+}
+
+bool BatchedLocationStore::isValid(const Block& block)
+{
+    for (uint32_t column = 0; column < COLUMN_COUNT; column++) {
+        if (block.columnOffset[column] > block.columnOffset[column + 1]) {
+            return false;
+        }
+    }
+    return block.columnOffset[COLUMN_COUNT] <= block.data.size();
+}
+
+void BatchedLocationStore::dropFront(const char* reason)
+{
+    const Block& block = mBlocks.front();
+    LOC_LOGe("dropping block %" PRIu64 " of %u locations, %s",
+             block.sequence, block.count, reason);
+    mStats.droppedLocations += block.count - mReadIndex;
+    popFront();
+}
+
+void BatchedLocationStore::popFront()
+{
+    mCurrentBytes -= mBlocks.front().data.size();
+    mStats.currentBytes = mCurrentBytes;
+    mBlocks.pop_front();
+    mReadIndex = 0;
+}
@@ -0,0 +1,136 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef BATCHED_LOCATION_STORE_H
+#define BATCHED_LOCATION_STORE_H
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <LocationDataTypes.h>
+
+/* Columnar store of the batched locations reported by the modem, pending
+ * delivery to the clients. Each reported batch is encoded once into a block
+ * of per-field columns, every field being delta and/or varint encoded against
+ * the previous fix of the batch. Doubles and floats are kept as their bit
+ * patterns, so the locations read back are exactly the reported ones. Blocks
+ * are read back in fixed-size chunks from the oldest one, and the oldest
+ * blocks are dropped once the store exceeds its byte budget. A block that
+ * fails to decode is dropped. */
+class BatchedLocationStore {
+public:
+    enum Column {
+        COLUMN_FLAGS = 0,
+        COLUMN_TIMESTAMP,
+        COLUMN_LATITUDE,
+        COLUMN_LONGITUDE,
+        COLUMN_ALTITUDE,
+        COLUMN_SPEED,
+        COLUMN_BEARING,
+        COLUMN_ACCURACY,
+        COLUMN_VERTICAL_ACCURACY,
+        COLUMN_SPEED_ACCURACY,
+        COLUMN_BEARING_ACCURACY,
+        COLUMN_CONFORMITY_INDEX,
+        COLUMN_TECH_MASK,
+        COLUMN_SPOOF_MASK,
+        COLUMN_ELAPSED_REAL_TIME,
+        COLUMN_ELAPSED_REAL_TIME_UNC,
+        COLUMN_COUNT
+    };
+
+    // one encoded batch, built in the reporting thread and moved into the store
+    struct Block {
+        uint64_t sequence;  // set by the owner, e.g. to track the block in a journal
+        std::vector<uint32_t> sessionIds;  // sessions the batch is for, set by the owner
+        BatchingMode batchingMode;
+        uint32_t count;
+        uint32_t columnOffset[COLUMN_COUNT + 1];
+        std::vector<uint8_t> data;
+        inline Block() :
+                sequence(0), batchingMode(BATCHING_MODE_ROUTINE), count(0), columnOffset() {}
+    };
+
+    struct Stats {
+        uint64_t storedLocations;   // locations encoded since start
+        uint64_t rawBytes;          // sizeof(Location) of all stored locations
+        uint64_t encodedBytes;      // encoded size of all stored locations
+        uint64_t droppedLocations;  // dropped over the byte budget
+        uint64_t deliveredChunks;
+        size_t currentBytes;        // encoded bytes pending delivery
+        size_t peakBytes;
+    };
+
+    static void encode(const Location* locations, size_t count,
+                       BatchingMode batchingMode, Block& block);
+
+    inline BatchedLocationStore() :
+            mCurrentBytes(0), mMaxBytes(0), mReadIndex(0),
+            mReadOffset(), mReadPrev(), mStats() {}
+
+    // 0 means no byte budget
+    inline void setMaxBytes(size_t maxBytes) { mMaxBytes = maxBytes; }
+    void push(Block&& block);
+    inline bool empty() const { return mBlocks.empty(); }
+    inline const std::deque<Block>& getBlocks() const { return mBlocks; }
+    inline uint64_t frontSequence() const {
+        return mBlocks.empty() ? 0 : mBlocks.front().sequence;
+    }
+    // locations left to read in the oldest block
+    inline size_t readableCount() const {
+        return mBlocks.empty() ? 0 : mBlocks.front().count - mReadIndex;
+    }
+
+    // Decodes up to maxCount locations of the oldest block into locations, which
+    // must hold maxCount elements, and consumes them. A chunk never spans two
+    // blocks, so all locations read at once share batchingMode.
+    size_t read(Location* locations, size_t maxCount, BatchingMode& batchingMode);
+
+    inline const Stats& getStats() const { return mStats; }
+    // encoded bytes per 100 raw bytes, 100 if nothing was stored yet
+    inline uint32_t getCompressionPercent() const {
+        return (0 == mStats.rawBytes) ? 100 :
+                (uint32_t)(mStats.encodedBytes * 100 / mStats.rawBytes);
+    }
+
+private:
+    std::deque<Block> mBlocks;
+    size_t mCurrentBytes;
+    size_t mMaxBytes;
+    // read cursor into the front block
+    uint32_t mReadIndex;
+    uint32_t mReadOffset[COLUMN_COUNT];
+    int64_t mReadPrev[COLUMN_COUNT];
+    Stats mStats;
+
+    static bool isValid(const Block& block);
+    void dropFront(const char* reason);
+    void popFront();
+};
+
+#endif // BATCHED_LOCATION_STORE_H
@@ -29,21 +29,33 @@
 #define LOG_NDEBUG 0
 #define LOG_TAG "LocSvc_BatchingAdapter"
 
+#include <algorithm>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <LocContext.h>
+#include <LocWorkAccounting.h>
 #include <BatchingAdapter.h>
 
 using namespace loc_core;
 
+#define BATCH_DELIVERY_CHUNK_SIZE_DEFAULT 64
+#define BATCH_JOURNAL_SYNC_RECORDS_DEFAULT 8
+#define BATCH_JOURNAL_PATH_DEFAULT "/data/vendor/location/batching_journal"
+#define BATCH_RECOVERY_ADOPT_TIMEOUT_MS 60000
+
 BatchingAdapter::BatchingAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
-                   false, nullptr, true),
+                   false, nullptr, true,
+                   LocContext::getAdapterMsgTask(LocContext::mBatchingWorkerName)),
     mOngoingTripDistance(0),
     mOngoingTripTBFInterval(0),
     mTripWithOngoingTBFDropped(false),
     mTripWithOngoingTripDistanceDropped(false),
+    mReplayPending(false),
+    mDeliveryChunkSize(BATCH_DELIVERY_CHUNK_SIZE_DEFAULT),
+    mRecoveredSessionsTimer(this),
+    mNextBatchSequence(1),
     mBatchingTimeout(0),
     mBatchingAccuracy(1),
     mBatchSize(0),
@@ -73,22 +85,40 @@ BatchingAdapter::readConfigCommand()
             uint32_t batchingAccuracy = 0;
             uint32_t batchSize = 0;
             uint32_t tripBatchSize = 0;
+            uint32_t deliveryChunkSize = BATCH_DELIVERY_CHUNK_SIZE_DEFAULT;
+            uint32_t storeMaxKBytes = 0;
+            uint32_t journalMaxKBytes = 0;
+            uint32_t journalSyncRecords = BATCH_JOURNAL_SYNC_RECORDS_DEFAULT;
+            char journalPath[LOC_MAX_PARAM_STRING] = BATCH_JOURNAL_PATH_DEFAULT;
             static const loc_param_s_type flp_conf_param_table[] =
             {
                 {"BATCH_SIZE", &batchSize, NULL, 'n'},
                 {"OUTDOOR_TRIP_BATCH_SIZE", &tripBatchSize, NULL, 'n'},
                 {"BATCH_SESSION_TIMEOUT", &batchingTimeout, NULL, 'n'},
                 {"ACCURACY", &batchingAccuracy, NULL, 'n'},
+                {"BATCH_DELIVERY_CHUNK_SIZE", &deliveryChunkSize, NULL, 'n'},
+                {"BATCH_STORE_MAX_KBYTES", &storeMaxKBytes, NULL, 'n'},
+                {"BATCH_JOURNAL_MAX_KBYTES", &journalMaxKBytes, NULL, 'n'},
+                {"BATCH_JOURNAL_SYNC_RECORDS", &journalSyncRecords, NULL, 'n'},
+                {"BATCH_JOURNAL_PATH", &journalPath, NULL, 's'},
             };
             UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
 
             LOC_LOGD("%s]: batchSize %u tripBatchSize %u batchingAccuracy %u batchingTimeout %u ",
                      __func__, batchSize, tripBatchSize, batchingAccuracy, batchingTimeout);
+            LOC_LOGD("%s]: deliveryChunkSize %u storeMaxKBytes %u",
+                     __func__, deliveryChunkSize, storeMaxKBytes);
 
              mAdapter.setBatchSize(batchSize);
              mAdapter.setTripBatchSize(tripBatchSize);
              mAdapter.setBatchingTimeout(batchingTimeout);
              mAdapter.setBatchingAccuracy(batchingAccuracy);
+             mAdapter.setDeliveryChunkSize(deliveryChunkSize);
+             mAdapter.setLocationStoreMaxBytes((size_t)storeMaxKBytes * 1024);
+             if (0 != journalMaxKBytes) {
+                 mAdapter.openJournal(journalPath, (size_t)journalMaxKBytes * 1024,
+                                      journalSyncRecords);
+             }
         }
     };
 
@@ -167,17 +197,12 @@ BatchingAdapter::handleEngineUpEvent()
 {
     struct MsgSSREvent : public LocMsg {
         BatchingAdapter& mAdapter;
-        LocApiBase& mApi;
-        inline MsgSSREvent(BatchingAdapter& adapter,
-                           LocApiBase& api) :
+        inline MsgSSREvent(BatchingAdapter& adapter) :
             LocMsg(),
-            mAdapter(adapter),
-            mApi(api) {}
+            mAdapter(adapter) {}
         virtual void proc() const {
             mAdapter.setEngineCapabilitiesKnown(true);
             mAdapter.broadcastCapabilities(mAdapter.getCapabilities());
-            mApi.setBatchSize(mAdapter.getBatchSize());
-            mApi.setTripBatchSize(mAdapter.getTripBatchSize());
             mAdapter.restartSessions();
             for (auto msg: mAdapter.mPendingMsgs) {
                 mAdapter.sendMsg(msg);
@@ -186,7 +211,8 @@ BatchingAdapter::handleEngineUpEvent()
         }
     };
 
-    sendMsg(new MsgSSREvent(*this, *mLocApi));
+    mLocApi->getEngineStateSnapshot().expect(ENGINE_REPLAY_PRIORITY_BATCHING);
+    sendMsg(new MsgSSREvent(*this));
 }
 
 void
@@ -194,6 +220,22 @@ BatchingAdapter::restartSessions()
 {
     LOC_LOGD("%s]: ", __func__);
 
+    // the calls are replayed by the engine state snapshot on this thread, after tracking
+    // and geofences; the client commands wait for it so they see the replayed sessions
+    mReplayPending = true;
+    mLocApi->getEngineStateSnapshot().submit(ENGINE_REPLAY_PRIORITY_BATCHING, *getMsgTask(),
+                                             {[this] () { replaySessions(); }});
+}
+
+void
+BatchingAdapter::replaySessions()
+{
+    LOC_LOGD("%s]: releasing %zu commands", __func__, mPendingMsgs.size());
+    mReplayPending = false;
+
+    mLocApi->setBatchSize(getBatchSize());
+    mLocApi->setTripBatchSize(getTripBatchSize());
+
     if (autoReportBatchingSessionsCount() > 0) {
         updateEvtMask(LOC_API_ADAPTER_BIT_BATCH_FULL,
                       LOC_REGISTRATION_MASK_ENABLED);
@@ -203,7 +245,7 @@ BatchingAdapter::restartSessions()
         if (it->second.batchingMode != BATCHING_MODE_TRIP) {
             mLocApi->startBatching(it->first.id, it->second,
                                     getBatchingAccuracy(), getBatchingTimeout(),
-                                    new LocApiResponse(*getContext(),
+                                    new LocApiResponse(*getMsgTask(),
                                     [] (LocationError /*err*/) {}));
         }
     }
@@ -236,14 +278,21 @@ BatchingAdapter::restartSessions()
         }
 
         mLocApi->startOutdoorTripBatching(mOngoingTripDistance, mOngoingTripTBFInterval,
-                getBatchingTimeout(), new LocApiResponse(*getContext(), [this] (LocationError err) {
+                getBatchingTimeout(), new LocApiResponse(*getMsgTask(),
+                [this] (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
                 mOngoingTripDistance = 0;
                 mOngoingTripTBFInterval = 0;
             }
             printTripReport();
+            journalSessionStatus();
         }));
     }
+
+    for (auto msg: mPendingMsgs) {
+        sendMsg(msg);
+    }
+    mPendingMsgs.clear();
 }
 
 bool
@@ -288,6 +337,9 @@ BatchingAdapter::reportResponse(LocationAPI* client, LocationError err, uint32_t
 {
     LOC_LOGD("%s]: client %p id %u err %u", __func__, client, sessionId, err);
 
+    // the first response to a session is the one to its start
+    adoptRecoveredBatches(client, sessionId, err);
+
     auto it = mClientData.find(client);
     if (it != mClientData.end() &&
         it->second.responseCb != nullptr) {
@@ -337,7 +389,7 @@ BatchingAdapter::startBatchingCommand(
             mSessionId(sessionId),
             mBatchingOptions(batchOptions) {}
         inline virtual void proc() const {
-            if (!mAdapter.isEngineCapabilitiesKnown()) {
+            if (!mAdapter.isEngineCapabilitiesKnown() || mAdapter.isReplayPending()) {
                 mAdapter.mPendingMsgs.push_back(new MsgStartBatching(*this));
                 return;
             }
@@ -354,9 +406,13 @@ BatchingAdapter::startBatchingCommand(
             if (LOCATION_ERROR_SUCCESS == err) {
                 if (mBatchingOptions.batchingMode == BATCHING_MODE_ROUTINE ||
                     mBatchingOptions.batchingMode == BATCHING_MODE_NO_AUTO_REPORT) {
+                    mAdapter.takeRecoveredSession(mSessionId, mBatchingOptions);
                     mAdapter.startBatching(mClient, mSessionId, mBatchingOptions);
                 } else if (mBatchingOptions.batchingMode == BATCHING_MODE_TRIP) {
-                    mAdapter.startTripBatchingMultiplex(mClient, mSessionId, mBatchingOptions);
+                    uint32_t recoveredDistance =
+                            mAdapter.takeRecoveredSession(mSessionId, mBatchingOptions);
+                    mAdapter.startTripBatchingMultiplex(mClient, mSessionId, mBatchingOptions,
+                                                        recoveredDistance);
                 } else {
                     mAdapter.reportResponse(mClient, LOCATION_ERROR_INVALID_PARAMETER, mSessionId);
                 }
@@ -384,7 +440,7 @@ BatchingAdapter::startBatching(LocationAPI* client, uint32_t sessionId,
     // Assume start will be OK, remove session if not
     saveBatchingSession(client, sessionId, batchingOptions);
     mLocApi->startBatching(sessionId, batchingOptions, getBatchingAccuracy(), getBatchingTimeout(),
-            new LocApiResponse(*getContext(),
+            new LocApiResponse(*getMsgTask(),
             [this, client, sessionId, batchingOptions] (LocationError err) {
         if (LOCATION_ERROR_SUCCESS != err) {
             eraseBatchingSession(client, sessionId);
@@ -430,7 +486,7 @@ BatchingAdapter::updateBatchingOptionsCommand(LocationAPI* client, uint32_t id,
             mSessionId(sessionId),
             mBatchOptions(batchOptions) {}
         inline virtual void proc() const {
-            if (!mAdapter.isEngineCapabilitiesKnown()) {
+            if (!mAdapter.isEngineCapabilitiesKnown() || mAdapter.isReplayPending()) {
                 mAdapter.mPendingMsgs.push_back(new MsgUpdateBatching(*this));
                 return;
             }
@@ -474,7 +530,7 @@ BatchingAdapter::stopBatchingCommand(LocationAPI* client, uint32_t id)
             mClient(client),
             mSessionId(sessionId) {}
         inline virtual void proc() const {
-            if (!mAdapter.isEngineCapabilitiesKnown()) {
+            if (!mAdapter.isEngineCapabilitiesKnown() || mAdapter.isReplayPending()) {
                 mAdapter.mPendingMsgs.push_back(new MsgStopBatching(*this));
                 return;
             }
@@ -506,7 +562,7 @@ BatchingAdapter::stopBatching(LocationAPI* client, uint32_t sessionId, bool rest
         // Assume stop will be OK, restore session if not
         eraseBatchingSession(client, sessionId);
         mLocApi->stopBatching(sessionId,
-                new LocApiResponse(*getContext(),
+                new LocApiResponse(*getMsgTask(),
                 [this, client, sessionId, flpOptions, restartNeeded, batchOptions]
                 (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
@@ -557,7 +613,7 @@ BatchingAdapter::getBatchedLocationsCommand(LocationAPI* client, uint32_t id, si
             mSessionId(sessionId),
             mCount(count) {}
         inline virtual void proc() const {
-            if (!mAdapter.isEngineCapabilitiesKnown()) {
+            if (!mAdapter.isEngineCapabilitiesKnown() || mAdapter.isReplayPending()) {
                 mAdapter.mPendingMsgs.push_back(new MsgGetBatchedLocations(*this));
                 return;
             }
@@ -570,16 +626,16 @@ BatchingAdapter::getBatchedLocationsCommand(LocationAPI* client, uint32_t id, si
             if (LOCATION_ERROR_SUCCESS == err) {
                 if (mAdapter.isTripSession(mSessionId)) {
                     mApi.getBatchedTripLocations(mCount, 0,
-                            new LocApiResponse(*mAdapter.getContext(),
+                            new LocApiResponse(*mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mSessionId = mSessionId,
                             mClient = mClient] (LocationError err) {
-                        mAdapter.reportResponse(mClient, err, mSessionId);
+                        mAdapter.reportFlushResponse(mClient, err, mSessionId);
                     }));
                 } else {
-                    mApi.getBatchedLocations(mCount, new LocApiResponse(*mAdapter.getContext(),
+                    mApi.getBatchedLocations(mCount, new LocApiResponse(*mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mSessionId = mSessionId,
                             mClient = mClient] (LocationError err) {
-                        mAdapter.reportResponse(mClient, err, mSessionId);
+                        mAdapter.reportFlushResponse(mClient, err, mSessionId);
                     }));
                 }
             } else {
@@ -599,37 +655,123 @@ BatchingAdapter::reportLocationsEvent(const Location* locations, size_t count,
 
     struct MsgReportLocations : public LocMsg {
         BatchingAdapter& mAdapter;
-        Location* mLocations;
-        size_t mCount;
-        BatchingMode mBatchingMode;
+        // moved into the adapter store in proc()
+        mutable BatchedLocationStore::Block mBlock;
         inline MsgReportLocations(BatchingAdapter& adapter,
                                   const Location* locations,
                                   size_t count,
                                   BatchingMode batchingMode) :
             LocMsg(),
-            mAdapter(adapter),
-            mLocations(new Location[count]),
-            mCount(count),
-            mBatchingMode(batchingMode)
+            mAdapter(adapter)
         {
-            if (nullptr == mLocations) {
-                LOC_LOGE("%s]: new failed to allocate mLocations", __func__);
-                return;
+            BatchedLocationStore::encode(locations, count, batchingMode, mBlock);
+        }
+        inline virtual void proc() const {
+            // a delivery already in progress picks up the new block
+            bool deliveryIdle = mAdapter.mLocationStore.empty();
+            mBlock.sequence = mAdapter.mNextBatchSequence++;
+            // the batch is reported to all the sessions, journaled as theirs
+            for (auto itt = mAdapter.mTripSessions.begin();
+                    itt != mAdapter.mTripSessions.end(); itt++) {
+                mBlock.sessionIds.push_back(itt->first);
             }
-            for (size_t i=0; i < mCount; ++i) {
-                mLocations[i] = locations[i];
+            for (auto it = mAdapter.mBatchingSessions.begin();
+                    it != mAdapter.mBatchingSessions.end(); ++it) {
+                if (BATCHING_MODE_TRIP != it->second.batchingMode) {
+                    mBlock.sessionIds.push_back(it->first.id);
+                }
+            }
+            mAdapter.journalBatch(mBlock);
+            mAdapter.mLocationStore.push(std::move(mBlock));
+            if (deliveryIdle) {
+                mAdapter.deliverBatchedLocations();
             }
         }
-        inline virtual ~MsgReportLocations() {
-            if (nullptr != mLocations)
-                delete[] mLocations;
-        }
+    };
+
+    sendMsg(new MsgReportLocations(*this, locations, count, batchingMode));
+}
+
+void
+BatchingAdapter::deliverBatchedLocations()
+{
+    struct MsgDeliverBatchedLocations : public LocMsg {
+        BatchingAdapter& mAdapter;
+        inline MsgDeliverBatchedLocations(BatchingAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
         inline virtual void proc() const {
-            mAdapter.reportLocations(mLocations, mCount, mBatchingMode);
+            mAdapter.deliverBatchedLocations();
         }
     };
 
-    sendMsg(new MsgReportLocations(*this, locations, count, batchingMode));
+    size_t count = mLocationStore.readableCount();
+    if (0 != mDeliveryChunkSize && count > mDeliveryChunkSize) {
+        count = mDeliveryChunkSize;
+    }
+    if (0 == count) {
+        reportPendingFlushResponses();
+        return;
+    }
+    if (mDeliveryChunk.size() < count) {
+        mDeliveryChunk.resize(count);
+    }
+
+    BatchingMode batchingMode = BATCHING_MODE_ROUTINE;
+    uint64_t sequence = mLocationStore.frontSequence();
+    count = mLocationStore.read(mDeliveryChunk.data(), count, batchingMode);
+    if (0 != count) {
+        auto adopted = mAdoptedBlockSessions.find(sequence);
+        if (mAdoptedBlockSessions.end() == adopted) {
+            reportLocations(mDeliveryChunk.data(), count, batchingMode);
+        } else {
+            reportLocations(adopted->second, mDeliveryChunk.data(), count, batchingMode);
+        }
+    }
+    if (mLocationStore.empty() || mLocationStore.frontSequence() != sequence) {
+        journalDelivered(sequence);
+        // forget the adopted batches delivered or dropped from the store
+        mAdoptedBlockSessions.erase(mAdoptedBlockSessions.begin(), mLocationStore.empty() ?
+                mAdoptedBlockSessions.end() :
+                mAdoptedBlockSessions.lower_bound(mLocationStore.frontSequence()));
+    }
+    reportPendingFlushResponses();
+
+    if (!mLocationStore.empty()) {
+        // deliver the next chunk in a new message, so that the messages queued
+        // meanwhile do not wait for the whole batch to be delivered
+        sendMsg(new MsgDeliverBatchedLocations(*this));
+    } else {
+        const BatchedLocationStore::Stats& stats = mLocationStore.getStats();
+        LOC_LOGD("%s]: stored %" PRIu64 " compression %u%% peak %zu bytes"
+                 " dropped %" PRIu64 " chunks %" PRIu64, __func__,
+                 stats.storedLocations, mLocationStore.getCompressionPercent(),
+                 stats.peakBytes, stats.droppedLocations, stats.deliveredChunks);
+    }
+}
+
+void
+BatchingAdapter::reportFlushResponse(LocationAPI* client, LocationError err, uint32_t sessionId)
+{
+    // the batches of this flush are already in the store, while their chunks
+    // may still be queued for delivery
+    if (mLocationStore.empty()) {
+        reportResponse(client, err, sessionId);
+    } else {
+        mPendingFlushResponses.push_back({client, sessionId, err, mNextBatchSequence});
+    }
+}
+
+void
+BatchingAdapter::reportPendingFlushResponses()
+{
+    while (!mPendingFlushResponses.empty() &&
+           (mLocationStore.empty() ||
+            mLocationStore.frontSequence() >= mPendingFlushResponses.front().sequence)) {
+        PendingFlushResponse response = mPendingFlushResponses.front();
+        mPendingFlushResponses.pop_front();
+        reportResponse(response.client, response.err, response.sessionId);
+    }
 }
 
 void
@@ -639,11 +781,28 @@ BatchingAdapter::reportLocations(Location* locations, size_t count, BatchingMode
 
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.batchingCb) {
+            LocWorkAccounting::ClientCallbackScope accounting(it->first);
             it->second.batchingCb(count, locations, batchOptions);
         }
     }
 }
 
+void
+BatchingAdapter::reportLocations(const LocationSessionKey& key, Location* locations,
+                                 size_t count, BatchingMode batchingMode)
+{
+    auto it = mClientData.find(key.client);
+    if (it == mClientData.end() || nullptr == it->second.batchingCb ||
+            (!isBatchingSession(key.client, key.id) && !isTripSession(key.id))) {
+        LOC_LOGW("%s]: client %p id %u is gone, dropping %zu recovered locations",
+                 __func__, key.client, key.id, count);
+        return;
+    }
+    BatchingOptions batchOptions = {sizeof(BatchingOptions), batchingMode};
+    LocWorkAccounting::ClientCallbackScope accounting(it->first);
+    it->second.batchingCb(count, locations, batchOptions);
+}
+
 void
 BatchingAdapter::reportCompletedTripsEvent(uint32_t accumulated_distance)
 {
@@ -698,6 +857,7 @@ BatchingAdapter::reportCompletedTripsEvent(uint32_t accumulated_distance)
             } else {
                 mAdapter.printTripReport();
             }
+            mAdapter.journalSessionStatus();
         }
     };
 
@@ -716,6 +876,7 @@ BatchingAdapter::reportBatchStatusChange(BatchingStatus batchStatus,
 
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.batchingStatusCb) {
+            LocWorkAccounting::ClientCallbackScope accounting(it->first);
             it->second.batchingStatusCb(batchStatusInfo, completedTripsList);
         }
     }
@@ -748,8 +909,13 @@ BatchingAdapter::reportBatchStatusChangeEvent(BatchingStatus batchStatus)
 
 void
 BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessionId,
-        const BatchingOptions& batchingOptions)
+        const BatchingOptions& batchingOptions, uint32_t recoveredDistance)
 {
+    if (recoveredDistance >= batchingOptions.minDistance) {
+        recoveredDistance = 0;
+    }
+    uint32_t remainingDistance = batchingOptions.minDistance - recoveredDistance;
+
     if (mTripSessions.size() == 0) {
         // if there is currenty no batching sessions interested in batch full event, then this
         // new session will need to register for batch full event
@@ -761,16 +927,18 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
         // Assume start will be OK, remove session if not
         saveBatchingSession(client, sessionId, batchingOptions);
 
-        mTripSessions[sessionId] = { 0, 0, 0, batchingOptions.minDistance,
-                batchingOptions.minInterval};
-        mLocApi->startOutdoorTripBatching(batchingOptions.minDistance,
-                batchingOptions.minInterval, getBatchingTimeout(), new LocApiResponse(*getContext(),
-                [this, client, sessionId, batchingOptions] (LocationError err) {
+        mTripSessions[sessionId] = { 0, recoveredDistance, recoveredDistance,
+                batchingOptions.minDistance, batchingOptions.minInterval};
+        mLocApi->startOutdoorTripBatching(remainingDistance,
+                batchingOptions.minInterval, getBatchingTimeout(), new LocApiResponse(*getMsgTask(),
+                [this, client, sessionId, batchingOptions, remainingDistance]
+                (LocationError err) {
             if (err == LOCATION_ERROR_SUCCESS) {
-                mOngoingTripDistance = batchingOptions.minDistance;
+                mOngoingTripDistance = remainingDistance;
                 mOngoingTripTBFInterval = batchingOptions.minInterval;
                 LOC_LOGD("%s] New Trip started ...", __func__);
                 printTripReport();
+                journalSessionStatus();
             } else {
                 eraseBatchingSession(client, sessionId);
                 mTripSessions.erase(sessionId);
@@ -786,8 +954,8 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
     } else {
         // query accumulated distance
         mLocApi->queryAccumulatedTripDistance(
-                new LocApiResponseData<LocApiBatchData>(*getContext(),
-                [this, batchingOptions, sessionId, client]
+                new LocApiResponseData<LocApiBatchData>(*getMsgTask(),
+                [this, batchingOptions, sessionId, client, recoveredDistance, remainingDistance]
                 (LocationError err, LocApiBatchData data) {
             uint32_t accumulatedDistanceOngoingBatch = 0;
             uint32_t numOfBatchedPositions = 0;
@@ -802,14 +970,15 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
             }
             accumulatedDistanceOngoingBatch = data.accumulatedDistance;
             numOfBatchedPositions = data.numOfBatchedPositions;
-            TripSessionStatus newTripSession = { accumulatedDistanceOngoingBatch, 0, 0,
+            TripSessionStatus newTripSession = { accumulatedDistanceOngoingBatch,
+                                                 recoveredDistance, recoveredDistance,
                                                  batchingOptions.minDistance,
                                                  batchingOptions.minInterval};
             if (err != LOCATION_ERROR_SUCCESS) {
                 // unable to query accumulated distance, assume remaining distance in
                 // ongoing batch is mongoingTripDistance.
-                if (batchingOptions.minDistance < ongoingTripDistance) {
-                    ongoingTripDistance = batchingOptions.minDistance;
+                if (remainingDistance < ongoingTripDistance) {
+                    ongoingTripDistance = remainingDistance;
                     needsRestart = true;
                 }
             } else {
@@ -818,8 +987,8 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                         accumulatedDistanceOngoingBatch;
 
                 // check if new trip distance is lesser than the ongoing batch remaining distance
-                if (batchingOptions.minDistance < ongoing_trip_remaining_distance) {
-                    ongoingTripDistance = batchingOptions.minDistance;
+                if (remainingDistance < ongoing_trip_remaining_distance) {
+                    ongoingTripDistance = remainingDistance;
                     needsRestart = true;
                 } else if (needsRestart == true) {
                     // needsRestart is anyways true , may be because of lesser TBF of new session.
@@ -828,6 +997,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                 mTripSessions[sessionId] = newTripSession;
                 LOC_LOGD("%s] New Trip started ...", __func__);
                 printTripReport();
+                journalSessionStatus();
             }
 
             if (needsRestart) {
@@ -843,7 +1013,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                             tripSessStatus.accumulatedDistanceThisTrip;
                 }
                 mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
-                        getBatchingTimeout(), new LocApiResponse(*getContext(),
+                        getBatchingTimeout(), new LocApiResponse(*getMsgTask(),
                         [this, client, sessionId] (LocationError err) {
                     if (err != LOCATION_ERROR_SUCCESS) {
                         LOC_LOGE("%s] New Trip restart failed!", __func__);
@@ -864,7 +1034,7 @@ BatchingAdapter::stopTripBatchingMultiplex(LocationAPI* client, uint32_t session
     LocationError err = LOCATION_ERROR_SUCCESS;
 
     if (mTripSessions.size() == 1) {
-        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getContext(),
+        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getMsgTask(),
                 [this, restartNeeded, client, sessionId, batchOptions]
                 (LocationError err) {
             if (LOCATION_ERROR_SUCCESS == err) {
@@ -907,6 +1077,7 @@ BatchingAdapter::stopTripBatchingMultiplexCommon(LocationError err, LocationAPI*
     } else {
         restartTripBatching(true);
     }
+    journalSessionStatus();
 
     if (restartNeeded) {
         eraseBatchingSession(client, sessionId);
@@ -931,7 +1102,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
 
     // if no more trips left, stop the ongoing trip
     if (mTripSessions.size() == 0) {
-        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getContext(),
+        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getMsgTask(),
                                                [] (LocationError /*err*/) {}));
         mOngoingTripDistance = 0;
         mOngoingTripTBFInterval = 0;
@@ -963,7 +1134,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
     }
 
     mLocApi->queryAccumulatedTripDistance(
-            new LocApiResponseData<LocApiBatchData>(*getContext(),
+            new LocApiResponseData<LocApiBatchData>(*getMsgTask(),
             [this, queryAccumulatedDistance, minRemainingDistance, minTBFInterval, accDist,
             numbatchedPos] (LocationError /*err*/, LocApiBatchData data) {
         bool needsRestart = false;
@@ -1003,7 +1174,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
 
         if (needsRestart) {
             mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
-                    getBatchingTimeout(), new LocApiResponse(*getContext(),
+                    getBatchingTimeout(), new LocApiResponse(*getMsgTask(),
                     [this, accumulatedDistance, ongoingTripDistance, ongoingTripInterval]
                     (LocationError err) {
 
@@ -1022,6 +1193,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
 
                     mOngoingTripDistance = ongoingTripDistance;
                     mOngoingTripTBFInterval = ongoingTripInterval;
+                    journalSessionStatus();
                 }
             }));
         }
@@ -1049,3 +1221,255 @@ BatchingAdapter::printTripReport()
         }
     }
 }
+
+void
+BatchingAdapter::openJournal(const char* path, size_t maxBytes, uint32_t syncRecords)
+{
+    BatchingJournal::SessionStatus sessionStatus;
+    std::deque<BatchedLocationStore::Block> pending;
+    if (!mJournal.open(path, maxBytes, syncRecords, pending, sessionStatus)) {
+        return;
+    }
+
+    // session ids start over in each run, so the recovered sessions get new ones
+    std::map<uint32_t, uint32_t> sessionIds;
+    for (auto& record : sessionStatus.sessions) {
+        uint32_t sessionId = generateSessionId();
+        sessionIds[record.sessionId] = sessionId;
+        record.sessionId = sessionId;
+        mRecoveredSessions[sessionId] = record;
+    }
+    for (auto& block : pending) {
+        if (block.sequence >= mNextBatchSequence) {
+            mNextBatchSequence = block.sequence + 1;
+        }
+        std::vector<uint32_t> owners;
+        for (auto id : block.sessionIds) {
+            auto it = sessionIds.find(id);
+            if (it != sessionIds.end()) {
+                owners.push_back(it->second);
+            }
+        }
+        if (owners.empty()) {
+            LOC_LOGW("%s]: no session for batch %" PRIu64 ", dropping %u locations",
+                     __func__, block.sequence, block.count);
+        } else {
+            block.sessionIds.swap(owners);
+            mRecoveredBlocks.push_back(std::move(block));
+        }
+    }
+    if (!mRecoveredSessions.empty()) {
+        LOC_LOGI("%s]: %zu sessions with %zu batches to adopt, ongoing trip distance %u"
+                 " TBF interval %u", __func__, mRecoveredSessions.size(),
+                 mRecoveredBlocks.size(), sessionStatus.ongoingTripDistance,
+                 sessionStatus.ongoingTripTBFInterval);
+        mRecoveredSessionsTimer.start(BATCH_RECOVERY_ADOPT_TIMEOUT_MS, false);
+    }
+    compactJournal();
+}
+
+uint32_t
+BatchingAdapter::takeRecoveredSession(uint32_t sessionId, const BatchingOptions& options)
+{
+    auto it = mRecoveredSessions.begin();
+    while (it != mRecoveredSessions.end() &&
+           (it->second.batchingMode != (uint32_t)options.batchingMode ||
+            it->second.minInterval != options.minInterval ||
+            it->second.minDistance != options.minDistance)) {
+        ++it;
+    }
+    if (it == mRecoveredSessions.end()) {
+        return 0;
+    }
+
+    LOC_LOGI("%s]: session %u adopts recovered session %u", __func__, sessionId, it->first);
+    const BatchingJournal::SessionRecord& record = it->second;
+    uint32_t recoveredDistance = record.accumulatedDistanceThisTrip;
+    mAdoptingSessions[sessionId] = record;
+    mRecoveredSessions.erase(it);
+    if (mRecoveredSessions.empty()) {
+        mRecoveredSessionsTimer.stop();
+    }
+    return (BATCHING_MODE_TRIP == options.batchingMode) ? recoveredDistance : 0;
+}
+
+void
+BatchingAdapter::adoptRecoveredBatches(LocationAPI* client, uint32_t sessionId,
+                                       LocationError err)
+{
+    auto it = mAdoptingSessions.find(sessionId);
+    if (it == mAdoptingSessions.end()) {
+        return;
+    }
+    BatchingJournal::SessionRecord record = it->second;
+    mAdoptingSessions.erase(it);
+    if (LOCATION_ERROR_SUCCESS != err) {
+        // the session did not start, another one may still adopt the recovered one
+        mRecoveredSessions[record.sessionId] = record;
+        mRecoveredSessionsTimer.start(BATCH_RECOVERY_ADOPT_TIMEOUT_MS, false);
+        return;
+    }
+
+    // the batches of the recovered session are reported to the adopting session only
+    bool deliveryIdle = mLocationStore.empty();
+    for (auto blockIt = mRecoveredBlocks.begin(); blockIt != mRecoveredBlocks.end();) {
+        auto idIt = std::find(blockIt->sessionIds.begin(), blockIt->sessionIds.end(),
+                              record.sessionId);
+        if (idIt == blockIt->sessionIds.end()) {
+            ++blockIt;
+            continue;
+        }
+        blockIt->sessionIds.erase(idIt);
+        BatchedLocationStore::Block block;
+        if (blockIt->sessionIds.empty()) {
+            block = std::move(*blockIt);
+            blockIt = mRecoveredBlocks.erase(blockIt);
+        } else {
+            block = *blockIt;
+            ++blockIt;
+        }
+        block.sequence = mNextBatchSequence++;
+        block.sessionIds.assign(1, sessionId);
+        mAdoptedBlockSessions.emplace(block.sequence, LocationSessionKey(client, sessionId));
+        mLocationStore.push(std::move(block));
+    }
+    // journals the adopted batches under their new sequence
+    compactJournal();
+    if (deliveryIdle) {
+        deliverBatchedLocations();
+    }
+}
+
+void
+BatchingAdapter::dropRecoveredSessions()
+{
+    if (mRecoveredSessions.empty()) {
+        return;
+    }
+    LOC_LOGW("%s]: %zu recovered sessions were not adopted", __func__,
+             mRecoveredSessions.size());
+    for (auto blockIt = mRecoveredBlocks.begin(); blockIt != mRecoveredBlocks.end();) {
+        auto& owners = blockIt->sessionIds;
+        owners.erase(std::remove_if(owners.begin(), owners.end(), [this] (uint32_t id) {
+                    return mRecoveredSessions.end() != mRecoveredSessions.find(id);
+                }), owners.end());
+        if (owners.empty()) {
+            LOC_LOGW("%s]: dropping batch %" PRIu64 " of %u locations", __func__,
+                     blockIt->sequence, blockIt->count);
+            blockIt = mRecoveredBlocks.erase(blockIt);
+        } else {
+            ++blockIt;
+        }
+    }
+    mRecoveredSessions.clear();
+    compactJournal();
+}
+
+void
+RecoveredSessionsTimer::timeOutCallback()
+{
+    if (nullptr != mAdapter) {
+        mAdapter->recoveredSessionsTimeoutEvent();
+    }
+}
+
+// Called in the context of LocTimer thread
+void
+BatchingAdapter::recoveredSessionsTimeoutEvent()
+{
+    struct MsgRecoveredSessionsTimeout : public LocMsg {
+        BatchingAdapter& mAdapter;
+        inline MsgRecoveredSessionsTimeout(BatchingAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.dropRecoveredSessions();
+        }
+    };
+
+    sendMsg(new MsgRecoveredSessionsTimeout(*this));
+}
+
+void
+BatchingAdapter::journalBatch(const BatchedLocationStore::Block& block)
+{
+    if (mJournal.isOpen() && !mJournal.appendBatch(block)) {
+        compactJournal();
+        if (!mJournal.appendBatch(block)) {
+            LOC_LOGW("%s]: batch of %u locations does not fit in the journal",
+                     __func__, block.count);
+        }
+    }
+}
+
+void
+BatchingAdapter::journalDelivered(uint64_t sequence)
+{
+    // once compacted the journal has no record of the delivered batch anymore
+    if (mJournal.isOpen() && !mJournal.appendDelivered(sequence)) {
+        compactJournal();
+    }
+}
+
+void
+BatchingAdapter::journalSessionStatus()
+{
+    if (mJournal.isOpen()) {
+        BatchingJournal::SessionStatus sessionStatus;
+        getSessionStatus(sessionStatus);
+        if (!mJournal.appendSessionStatus(sessionStatus)) {
+            compactJournal();
+        }
+    }
+}
+
+void
+BatchingAdapter::compactJournal()
+{
+    BatchingJournal::SessionStatus sessionStatus;
+    getSessionStatus(sessionStatus);
+
+    mJournal.reset();
+    bool fits = mJournal.appendSessionStatus(sessionStatus);
+    for (auto it = mRecoveredBlocks.begin(); fits && it != mRecoveredBlocks.end(); ++it) {
+        fits = mJournal.appendBatch(*it);
+    }
+    for (auto it = mLocationStore.getBlocks().begin();
+            fits && it != mLocationStore.getBlocks().end(); ++it) {
+        fits = mJournal.appendBatch(*it);
+    }
+    if (!fits) {
+        LOC_LOGW("%s]: pending batches do not fit in the journal", __func__);
+    }
+    mJournal.sync();
+}
+
+void
+BatchingAdapter::getSessionStatus(BatchingJournal::SessionStatus& sessionStatus)
+{
+    sessionStatus.ongoingTripDistance = mOngoingTripDistance;
+    sessionStatus.ongoingTripTBFInterval = mOngoingTripTBFInterval;
+    sessionStatus.sessions.clear();
+    for (auto itt = mTripSessions.begin(); itt != mTripSessions.end(); itt++) {
+        const TripSessionStatus& tripSessStatus = itt->second;
+        sessionStatus.sessions.push_back({itt->first, (uint32_t)BATCHING_MODE_TRIP,
+                tripSessStatus.tripTBFInterval,
+                tripSessStatus.tripDistance,
+                tripSessStatus.accumulatedDistanceOngoingBatch,
+                tripSessStatus.accumulatedDistanceThisTrip,
+                tripSessStatus.accumulatedDistanceOnTripRestart, 0});
+    }
+    for (auto it = mBatchingSessions.begin(); it != mBatchingSessions.end(); ++it) {
+        if (BATCHING_MODE_TRIP != it->second.batchingMode) {
+            sessionStatus.sessions.push_back({it->first.id, (uint32_t)it->second.batchingMode,
+                    it->second.minInterval, it->second.minDistance, 0, 0, 0, 0});
+        }
+    }
+    // the recovered sessions outlive a new crash until they are adopted or gone
+    for (auto it = mRecoveredSessions.begin(); it != mRecoveredSessions.end(); ++it) {
+        sessionStatus.sessions.push_back(it->second);
+    }
+    for (auto it = mAdoptingSessions.begin(); it != mAdoptingSessions.end(); ++it) {
+        sessionStatus.sessions.push_back(it->second);
+    }
+}
@@ -32,10 +32,29 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
+#include <BatchedLocationStore.h>
+#include <BatchingJournal.h>
+#include <LocTimer.h>
 #include <map>
+#include <vector>
 
 using namespace loc_core;
 
+class BatchingAdapter;
+
+// ends the time the sessions recovered from the journal can be adopted in
+class RecoveredSessionsTimer : public LocTimer {
+public:
+    inline RecoveredSessionsTimer(BatchingAdapter* adapter) :
+            LocTimer(), mAdapter(adapter) {}
+
+private:
+    // Override
+    virtual void timeOutCallback() override;
+
+    BatchingAdapter* mAdapter;
+};
+
 class BatchingAdapter : public LocAdapterBase {
 
     /* ==== BATCHING ======================================================================= */
@@ -55,9 +74,12 @@ class BatchingAdapter : public LocAdapterBase {
     uint32_t mOngoingTripTBFInterval;
     bool mTripWithOngoingTBFDropped;
     bool mTripWithOngoingTripDistanceDropped;
+    bool mReplayPending; //engine restarted, the sessions are not restarted yet
 
+    // recoveredDistance is the distance a recovered trip session already covered
     void startTripBatchingMultiplex(LocationAPI* client, uint32_t sessionId,
-                                    const BatchingOptions& batchingOptions);
+                                    const BatchingOptions& batchingOptions,
+                                    uint32_t recoveredDistance = 0);
     void stopTripBatchingMultiplex(LocationAPI* client, uint32_t sessionId,
                                    bool restartNeeded,
                                    const BatchingOptions& batchOptions);
@@ -74,6 +96,47 @@ class BatchingAdapter : public LocAdapterBase {
                              uint32_t numbatchedPos = 0);
     void printTripReport();
 
+    /* ==== BATCHED LOCATIONS ============================================================== */
+    BatchedLocationStore mLocationStore;
+    std::vector<Location> mDeliveryChunk;
+    size_t mDeliveryChunkSize;
+    void deliverBatchedLocations();
+    // flush responses held until the batches reported before them are delivered
+    struct PendingFlushResponse {
+        LocationAPI* client;
+        uint32_t sessionId;
+        LocationError err;
+        uint64_t sequence;  // sequence of the first batch reported after the response
+    };
+    std::deque<PendingFlushResponse> mPendingFlushResponses;
+    void reportFlushResponse(LocationAPI* client, LocationError err, uint32_t sessionId);
+    void reportPendingFlushResponses();
+
+    /* ==== JOURNAL ======================================================================== */
+    BatchingJournal mJournal;
+    // Sessions of the previous run recovered from the journal, keyed by the id
+    // they are given in this run, along with their pending batches. A session
+    // started with the same options adopts a recovered session, with the trip
+    // distance it covered and its batches. The sessions which are not adopted
+    // within BATCH_RECOVERY_ADOPT_TIMEOUT_MS are gone, and so are their batches.
+    std::map<uint32_t, BatchingJournal::SessionRecord> mRecoveredSessions;
+    std::deque<BatchedLocationStore::Block> mRecoveredBlocks;
+    // recovered sessions being adopted, by the id of the adopting session
+    std::map<uint32_t, BatchingJournal::SessionRecord> mAdoptingSessions;
+    // adopted batches in the store by sequence, reported to their session only
+    std::map<uint64_t, LocationSessionKey> mAdoptedBlockSessions;
+    RecoveredSessionsTimer mRecoveredSessionsTimer;
+    uint64_t mNextBatchSequence;
+    uint32_t takeRecoveredSession(uint32_t sessionId, const BatchingOptions& options);
+    void adoptRecoveredBatches(LocationAPI* client, uint32_t sessionId, LocationError err);
+    void dropRecoveredSessions();
+    void openJournal(const char* path, size_t maxBytes, uint32_t syncRecords);
+    void journalBatch(const BatchedLocationStore::Block& block);
+    void journalDelivered(uint64_t sequence);
+    void journalSessionStatus();
+    void compactJournal();
+    void getSessionStatus(BatchingJournal::SessionStatus& sessionStatus);
+
     /* ==== CONFIGURATION ================================================================== */
     uint32_t mBatchingTimeout;
     uint32_t mBatchingAccuracy;
@@ -95,6 +158,8 @@ public:
     virtual void handleEngineUpEvent();
     /* ======== UTILITIES ================================================================== */
     void restartSessions();
+    void replaySessions();
+    inline bool isReplayPending() const { return mReplayPending; }
 
     /* ==== BATCHING ======================================================================= */
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
@@ -130,6 +195,8 @@ public:
     void reportBatchStatusChangeEvent(BatchingStatus batchStatus);
     /* ======== UTILITIES ================================================================== */
     void reportLocations(Location* locations, size_t count, BatchingMode batchingMode);
+    void reportLocations(const LocationSessionKey& key, Location* locations, size_t count,
+                         BatchingMode batchingMode);
     void reportBatchStatusChange(BatchingStatus batchStatus,
             std::list<uint32_t> & completedTripsList);
 
@@ -137,6 +204,8 @@ public:
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
     void readConfigCommand();
     void setConfigCommand();
+    /* ======== EVENTS ====(Called from LocTimer Thread)=================================== */
+    void recoveredSessionsTimeoutEvent();
     /* ======== UTILITIES ================================================================== */
     void setBatchSize(size_t batchSize) { mBatchSize = batchSize; }
     size_t getBatchSize() { return mBatchSize; }
@@ -146,6 +215,8 @@ public:
     uint32_t getBatchingTimeout() { return mBatchingTimeout; }
     void setBatchingAccuracy(uint32_t accuracy) { mBatchingAccuracy = accuracy; }
     uint32_t getBatchingAccuracy() { return mBatchingAccuracy; }
+    void setDeliveryChunkSize(size_t chunkSize) { mDeliveryChunkSize = chunkSize; }
+    void setLocationStoreMaxBytes(size_t maxBytes) { mLocationStore.setMaxBytes(maxBytes); }
 
 };
 
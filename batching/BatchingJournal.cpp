@@ -0,0 +1,353 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_BatchingJournal"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <set>
+#include <log_util.h>
+#include <BatchingJournal.h>
+
+#define JOURNAL_MAGIC           0x4c424a4e  // "LBJN"
+#define JOURNAL_VERSION         3
+#define JOURNAL_MIN_SIZE        4096
+#define JOURNAL_ALIGN(x)        (((x) + 7) & ~((size_t)7))
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t generation;
+    uint32_t reserved;
+    uint64_t dataSize;    // committed bytes following the header
+} JournalHeader;
+
+typedef struct {
+    uint32_t type;
+    uint32_t length;      // payload length, the record is padded to 8 bytes
+    uint32_t generation;
+    uint32_t checksum;    // of the payload
+} RecordHeader;
+
+typedef struct {
+    uint64_t sequence;
+    uint32_t batchingMode;
+    uint32_t count;
+    uint32_t columnOffset[BatchedLocationStore::COLUMN_COUNT + 1];
+    uint32_t sessionCount;  // session ids follow the record, then the block data
+    uint32_t reserved;
+} BatchRecord;
+
+typedef struct {
+    uint32_t ongoingTripDistance;
+    uint32_t ongoingTripTBFInterval;
+    uint32_t sessionCount;
+    uint32_t reserved;
+} SessionStatusRecord;
+
+static inline uint32_t checksum(uint32_t hash, const void* data, size_t length)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static inline uint64_t getMonotonicUs()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+BatchingJournal::BatchingJournal() :
+    mFd(-1),
+    mBase(nullptr),
+    mSize(0),
+    mSyncRecords(1),
+    mUnsyncedRecords(0),
+    mUnsyncedStart(0),
+    mRecoveryTimeUs(0),
+    mSyncCount(0)
+{
+}
+
+BatchingJournal::~BatchingJournal()
+{
+    close();
+}
+
+bool BatchingJournal::open(const char* path, size_t maxBytes, uint32_t syncRecords,
+                           std::deque<BatchedLocationStore::Block>& pending,
+                           SessionStatus& sessionStatus)
+{
+    uint64_t startUs = getMonotonicUs();
+
+    close();
+    if (maxBytes < JOURNAL_MIN_SIZE) {
+        maxBytes = JOURNAL_MIN_SIZE;
+    }
+    mFd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0660);
+    if (mFd < 0) {
+        LOC_LOGe("open %s failed, errno %d", path, errno);
+        return false;
+    }
+
+    struct stat st = {};
+    if (0 == fstat(mFd, &st) && (size_t)st.st_size >= sizeof(JournalHeader)) {
+        void* previous = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, mFd, 0);
+        if (MAP_FAILED != previous) {
+            recover((const uint8_t*)previous, st.st_size, pending, sessionStatus);
+            munmap(previous, st.st_size);
+        }
+    }
+
+    if (0 != ftruncate(mFd, maxBytes)) {
+        LOC_LOGe("ftruncate %s to %zu failed, errno %d", path, maxBytes, errno);
+        close();
+        return false;
+    }
+    // a store to a page with no backing block raises SIGBUS when the disk is full,
+    // so every block is reserved before the file is mapped
+    int err = posix_fallocate(mFd, 0, maxBytes);
+    if (0 != err) {
+        LOC_LOGe("posix_fallocate %s to %zu failed, error %d", path, maxBytes, err);
+        close();
+        return false;
+    }
+    void* base = mmap(nullptr, maxBytes, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (MAP_FAILED == base) {
+        LOC_LOGe("mmap %s failed, errno %d", path, errno);
+        close();
+        return false;
+    }
+    mBase = (uint8_t*)base;
+    mSize = maxBytes;
+    mSyncRecords = (0 == syncRecords) ? 1 : syncRecords;
+    reset();
+
+    mRecoveryTimeUs = getMonotonicUs() - startUs;
+    LOC_LOGi("%s: %zu pending batches, %zu sessions recovered in %" PRIu64 " us",
+             path, pending.size(), sessionStatus.sessions.size(), mRecoveryTimeUs);
+    return true;
+}
+
+void BatchingJournal::close()
+{
+    if (nullptr != mBase) {
+        sync();
+        munmap(mBase, mSize);
+        mBase = nullptr;
+        mSize = 0;
+    }
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+}
+
+void BatchingJournal::recover(const uint8_t* base, size_t size,
+                              std::deque<BatchedLocationStore::Block>& pending,
+                              SessionStatus& sessionStatus)
+{
+    const JournalHeader* header = (const JournalHeader*)base;
+    if (JOURNAL_MAGIC != header->magic || JOURNAL_VERSION != header->version) {
+        LOC_LOGw("no valid journal to recover");
+        return;
+    }
+
+    size_t end = sizeof(JournalHeader) + header->dataSize;
+    if (end > size) {
+        end = size;
+    }
+    size_t offset = sizeof(JournalHeader);
+    std::set<uint64_t> delivered;
+    std::deque<BatchedLocationStore::Block> batches;
+
+    while (offset + sizeof(RecordHeader) <= end) {
+        const RecordHeader* record = (const RecordHeader*)(base + offset);
+        const uint8_t* payload = base + offset + sizeof(RecordHeader);
+        if (record->generation != header->generation ||
+            record->length > end - offset - sizeof(RecordHeader) ||
+            record->checksum != checksum(2166136261u, payload, record->length)) {
+            LOC_LOGw("journal ends with a torn record at %zu", offset);
+            break;
+        }
+
+        if (RECORD_BATCH == record->type && record->length >= sizeof(BatchRecord)) {
+            const BatchRecord* batch = (const BatchRecord*)payload;
+            size_t idsLength = (size_t)batch->sessionCount * sizeof(uint32_t);
+            if (idsLength <= record->length - sizeof(BatchRecord) &&
+                batch->columnOffset[BatchedLocationStore::COLUMN_COUNT] ==
+                        record->length - sizeof(BatchRecord) - idsLength) {
+                const uint8_t* ids = payload + sizeof(BatchRecord);
+                BatchedLocationStore::Block block;
+                block.sequence = batch->sequence;
+                block.batchingMode = (BatchingMode)batch->batchingMode;
+                block.count = batch->count;
+                memcpy(block.columnOffset, batch->columnOffset, sizeof(block.columnOffset));
+                block.sessionIds.resize(batch->sessionCount);
+                memcpy(block.sessionIds.data(), ids, idsLength);
+                block.data.assign(ids + idsLength, payload + record->length);
+                batches.push_back(std::move(block));
+            }
+        } else if (RECORD_DELIVERED == record->type && record->length >= sizeof(uint64_t)) {
+            uint64_t sequence;
+            memcpy(&sequence, payload, sizeof(sequence));
+            delivered.insert(sequence);
+        } else if (RECORD_SESSION_STATUS == record->type &&
+                   record->length >= sizeof(SessionStatusRecord)) {
+            const SessionStatusRecord* status = (const SessionStatusRecord*)payload;
+            if (record->length >= sizeof(SessionStatusRecord) +
+                    (size_t)status->sessionCount * sizeof(SessionRecord)) {
+                const SessionRecord* sessions =
+                        (const SessionRecord*)(payload + sizeof(SessionStatusRecord));
+                sessionStatus.ongoingTripDistance = status->ongoingTripDistance;
+                sessionStatus.ongoingTripTBFInterval = status->ongoingTripTBFInterval;
+                sessionStatus.sessions.assign(sessions, sessions + status->sessionCount);
+            }
+        }
+        offset += JOURNAL_ALIGN(sizeof(RecordHeader) + record->length);
+    }
+
+    for (auto& block : batches) {
+        if (delivered.end() == delivered.find(block.sequence)) {
+            pending.push_back(std::move(block));
+        }
+    }
+}
+
+bool BatchingJournal::append(uint32_t type, const void* head, uint32_t headLength,
+                             const void* data, uint32_t dataLength)
+{
+    if (nullptr == mBase) {
+        return false;
+    }
+
+    JournalHeader* header = (JournalHeader*)mBase;
+    size_t offset = sizeof(JournalHeader) + header->dataSize;
+    size_t recordSize = JOURNAL_ALIGN(sizeof(RecordHeader) + headLength + dataLength);
+    if (recordSize > mSize - offset) {
+        return false;
+    }
+
+    RecordHeader* record = (RecordHeader*)(mBase + offset);
+    uint8_t* payload = mBase + offset + sizeof(RecordHeader);
+    memcpy(payload, head, headLength);
+    if (dataLength > 0) {
+        memcpy(payload + headLength, data, dataLength);
+    }
+    record->type = type;
+    record->length = headLength + dataLength;
+    record->generation = header->generation;
+    record->checksum = checksum(2166136261u, payload, record->length);
+
+    // the record is committed once dataSize covers it
+    header->dataSize += recordSize;
+    if (++mUnsyncedRecords >= mSyncRecords) {
+        sync();
+    }
+    return true;
+}
+
+bool BatchingJournal::appendBatch(const BatchedLocationStore::Block& block)
+{
+    BatchRecord batch = {};
+    batch.sequence = block.sequence;
+    batch.batchingMode = block.batchingMode;
+    batch.count = block.count;
+    memcpy(batch.columnOffset, block.columnOffset, sizeof(batch.columnOffset));
+    batch.sessionCount = (uint32_t)block.sessionIds.size();
+    std::vector<uint8_t> head(sizeof(batch) + batch.sessionCount * sizeof(uint32_t));
+    memcpy(head.data(), &batch, sizeof(batch));
+    if (0 != batch.sessionCount) {
+        memcpy(head.data() + sizeof(batch), block.sessionIds.data(),
+               batch.sessionCount * sizeof(uint32_t));
+    }
+    return append(RECORD_BATCH, head.data(), (uint32_t)head.size(),
+                  block.data.data(), (uint32_t)block.data.size());
+}
+
+bool BatchingJournal::appendDelivered(uint64_t sequence)
+{
+    return append(RECORD_DELIVERED, &sequence, sizeof(sequence), nullptr, 0);
+}
+
+bool BatchingJournal::appendSessionStatus(const SessionStatus& sessionStatus)
+{
+    SessionStatusRecord status = {};
+    status.ongoingTripDistance = sessionStatus.ongoingTripDistance;
+    status.ongoingTripTBFInterval = sessionStatus.ongoingTripTBFInterval;
+    status.sessionCount = (uint32_t)sessionStatus.sessions.size();
+    return append(RECORD_SESSION_STATUS, &status, sizeof(status), sessionStatus.sessions.data(),
+                  (uint32_t)(sessionStatus.sessions.size() * sizeof(SessionRecord)));
+}
+
+void BatchingJournal::reset()
+{
+    if (nullptr == mBase) {
+        return;
+    }
+
+    JournalHeader* header = (JournalHeader*)mBase;
+    if (JOURNAL_MAGIC != header->magic || JOURNAL_VERSION != header->version) {
+        header->magic = JOURNAL_MAGIC;
+        header->version = JOURNAL_VERSION;
+        header->generation = 0;
+    }
+    header->generation++;
+    header->dataSize = 0;
+    mUnsyncedStart = sizeof(JournalHeader);
+    sync();
+}
+
+void BatchingJournal::sync()
+{
+    if (nullptr == mBase) {
+        return;
+    }
+
+    JournalHeader* header = (JournalHeader*)mBase;
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = mUnsyncedStart & ~(pageSize - 1);
+    size_t end = sizeof(JournalHeader) + header->dataSize;
+    // records first, then the header which commits them
+    if (end > start && 0 != msync(mBase + start, end - start, MS_SYNC)) {
+        LOC_LOGw("msync failed, errno %d", errno);
+    }
+    msync(mBase, pageSize, MS_SYNC);
+    mUnsyncedStart = end;
+    mUnsyncedRecords = 0;
+    mSyncCount++;
+}
@@ -0,0 +1,111 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef BATCHING_JOURNAL_H
+#define BATCHING_JOURNAL_H
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <BatchedLocationStore.h>
+
+/* Append-only journal of the batched location reports pending delivery and of
+ * the batching sessions they are for, with their trip status, kept in a file
+ * of bounded size mapped in memory.
+ * Each record carries a checksum and the journal generation, so a record torn
+ * by a crash ends the recovery without corrupting what was committed before.
+ * Records are synced to storage every syncRecords records rather than each
+ * time; a crash of the process alone loses nothing, as the mapped pages stay
+ * in the page cache. When the journal is full, the owner resets it and writes
+ * back the state still pending. */
+class BatchingJournal {
+public:
+    struct SessionRecord {
+        uint32_t sessionId;
+        uint32_t batchingMode;
+        uint32_t minInterval;         // trip TBF interval of a trip session
+        uint32_t minDistance;         // trip distance of a trip session
+        // trip sessions only
+        uint32_t accumulatedDistanceOngoingBatch;
+        uint32_t accumulatedDistanceThisTrip;
+        uint32_t accumulatedDistanceOnTripRestart;
+        uint32_t reserved;
+    };
+    struct SessionStatus {
+        uint32_t ongoingTripDistance;
+        uint32_t ongoingTripTBFInterval;
+        std::vector<SessionRecord> sessions;
+        inline SessionStatus() : ongoingTripDistance(0), ongoingTripTBFInterval(0) {}
+    };
+
+    BatchingJournal();
+    ~BatchingJournal();
+
+    // Opens or creates the journal file of maxBytes size. The batches of a
+    // previous run which were not delivered, with the ids of the sessions they
+    // are for, and its last session status are returned in pending and
+    // sessionStatus, after which the journal is empty.
+    bool open(const char* path, size_t maxBytes, uint32_t syncRecords,
+              std::deque<BatchedLocationStore::Block>& pending, SessionStatus& sessionStatus);
+    inline bool isOpen() const { return nullptr != mBase; }
+
+    // all append functions return false if the record does not fit
+    bool appendBatch(const BatchedLocationStore::Block& block);
+    // the batch of sequence is delivered
+    bool appendDelivered(uint64_t sequence);
+    bool appendSessionStatus(const SessionStatus& sessionStatus);
+    void reset();
+    void sync();
+
+    inline uint64_t getRecoveryTimeUs() const { return mRecoveryTimeUs; }
+    inline uint32_t getSyncCount() const { return mSyncCount; }
+
+private:
+    enum RecordType {
+        RECORD_BATCH = 1,
+        RECORD_DELIVERED,
+        RECORD_SESSION_STATUS
+    };
+
+    int mFd;
+    uint8_t* mBase;
+    size_t mSize;
+    uint32_t mSyncRecords;
+    uint32_t mUnsyncedRecords;
+    size_t mUnsyncedStart;
+    uint64_t mRecoveryTimeUs;
+    uint32_t mSyncCount;
+
+    bool append(uint32_t type, const void* head, uint32_t headLength,
+                const void* data, uint32_t dataLength);
+    void recover(const uint8_t* base, size_t size,
+                 std::deque<BatchedLocationStore::Block>& pending, SessionStatus& sessionStatus);
+    void close();
+};
+
+#endif // BATCHING_JOURNAL_H
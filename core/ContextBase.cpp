@@ -36,6 +36,7 @@
 #include <loc_target.h>
 #include <loc_pla.h>
 #include <loc_log.h>
+#include <loc_misc_utils.h>
 
 namespace loc_core {
 
@@ -95,7 +96,10 @@ const loc_param_s_type ContextBase::mGps_conf_table[] =
            &mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED, NULL, 'n'},
   {"NMEA_TAG_BLOCK_GROUPING_ENABLED", &mGps_conf.NMEA_TAG_BLOCK_GROUPING_ENABLED, NULL, 'n'},
   {"NI_SUPL_DENY_ON_NFW_LOCKED",  &mGps_conf.NI_SUPL_DENY_ON_NFW_LOCKED, NULL, 'n'},
-  {"ENABLE_NMEA_PRINT",  &mGps_conf.ENABLE_NMEA_PRINT, NULL, 'n'}
+  {"ENABLE_NMEA_PRINT",  &mGps_conf.ENABLE_NMEA_PRINT, NULL, 'n'},
+  {"ODCPI_CACHE_MAX_AGE_MSEC",  &mGps_conf.ODCPI_CACHE_MAX_AGE_MSEC, NULL, 'n'},
+  {"ODCPI_CACHE_MAX_ACCURACY_METERS",
+           &mGps_conf.ODCPI_CACHE_MAX_ACCURACY_METERS, NULL, 'n'}
 };
 
 const loc_param_s_type ContextBase::mSap_conf_table[] =
@@ -199,6 +203,9 @@ void ContextBase::readConfig()
         mGps_conf.NI_SUPL_DENY_ON_NFW_LOCKED = 1;
         /* By default NMEA Printing is disabled */
         mGps_conf.ENABLE_NMEA_PRINT = 0;
+        /* By default ODCPI cache is disabled */
+        mGps_conf.ODCPI_CACHE_MAX_AGE_MSEC = 0;
+        mGps_conf.ODCPI_CACHE_MAX_ACCURACY_METERS = 200;
 
         UTIL_READ_CONF(LOC_PATH_GPS_CONF, mGps_conf_table);
         UTIL_READ_CONF(LOC_PATH_SAP_CONF, mSap_conf_table);
@@ -247,10 +254,10 @@ LBSProxyBase* ContextBase::getLBSProxy(const char* libName)
 {
     LBSProxyBase* proxy = NULL;
     LOC_LOGD("%s:%d]: getLBSProxy libname: %s\n", __func__, __LINE__, libName);
-    void* lib = dlopen(libName, RTLD_NOW);
+    void* lib = NULL;
+    getLBSProxy_t* getter = (getLBSProxy_t*)dlGetSymFromLib(lib, libName, "getLBSProxy");
 
     if ((void*)NULL != lib) {
-        getLBSProxy_t* getter = (getLBSProxy_t*)dlsym(lib, "getLBSProxy");
         if (NULL != getter) {
             proxy = (*getter)();
         }
@@ -281,9 +288,9 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
                 libname = SLL_LOC_API_LIB_NAME;
             }
 
-            if ((handle = dlopen(libname, RTLD_NOW)) != NULL) {
+            getLocApi_t* getter = (getLocApi_t*) dlGetSymFromLib(handle, libname, "getLocApi");
+            if (handle != NULL) {
                 LOC_LOGD("%s:%d]: %s is present", __func__, __LINE__, libname);
-                getLocApi_t* getter = (getLocApi_t*) dlsym(handle, "getLocApi");
                 if (getter != NULL) {
                     LOC_LOGD("%s:%d]: getter is not NULL of %s", __func__,
                             __LINE__, libname);
@@ -294,9 +301,9 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
             else {
                 LOC_LOGD("%s:%d]: libloc_api_v02.so is NOT present. Trying RPC",
                         __func__, __LINE__);
-                handle = dlopen("libloc_api-rpc-qc.so", RTLD_NOW);
+                getter = (getLocApi_t*) dlGetSymFromLib(handle, "libloc_api-rpc-qc.so",
+                                                        "getLocApi");
                 if (NULL != handle) {
-                    getLocApi_t* getter = (getLocApi_t*) dlsym(handle, "getLocApi");
                     if (NULL != getter) {
                         LOC_LOGD("%s:%d]: getter is not NULL in RPC", __func__,
                                 __LINE__);
@@ -83,6 +83,8 @@ typedef struct loc_gps_cfg_s
     uint32_t       NI_SUPL_DENY_ON_NFW_LOCKED;
     uint32_t       ENABLE_NMEA_PRINT;
     uint32_t       NMEA_TAG_BLOCK_GROUPING_ENABLED;
+    uint32_t       ODCPI_CACHE_MAX_AGE_MSEC;
+    uint32_t       ODCPI_CACHE_MAX_ACCURACY_METERS;
 } loc_gps_cfg_s_type;
 
 /* NOTE: the implementation of the parser casts number
@@ -168,7 +170,7 @@ public:
     static GnssNMEARptRate sNmeaReportRate;
     static LocationCapabilitiesMask sQwesFeatureMask;
 
-    void readConfig();
+    static void readConfig();
     static uint32_t getCarrierCapabilities();
     void setEngineCapabilities(uint64_t supportedMsgMask,
             uint8_t *featureList, bool gnssMeasurementSupported);
@@ -313,9 +315,11 @@ public:
 
 };
 
+// Responses are returned to the MsgTask they were created with, which is the
+// context MsgTask unless the owning adapter runs on its own worker.
 struct LocApiResponse: LocMsg {
     private:
-        ContextBase& mContext;
+        const MsgTask& mMsgTask;
         std::function<void (LocationError err)> mProcImpl;
         inline virtual void proc() const {
             mProcImpl(mLocationError);
@@ -325,17 +329,20 @@ struct LocApiResponse: LocMsg {
     public:
         inline LocApiResponse(ContextBase& context,
                               std::function<void (LocationError err)> procImpl ) :
-                              mContext(context), mProcImpl(procImpl) {}
+                              mMsgTask(*context.getMsgTask()), mProcImpl(procImpl) {}
+        inline LocApiResponse(const MsgTask& msgTask,
+                              std::function<void (LocationError err)> procImpl ) :
+                              mMsgTask(msgTask), mProcImpl(procImpl) {}
 
         void returnToSender(const LocationError err) {
             mLocationError = err;
-            mContext.sendMsg(this);
+            mMsgTask.sendMsg(this);
         }
 };
 
 struct LocApiCollectiveResponse: LocMsg {
     private:
-        ContextBase& mContext;
+        const MsgTask& mMsgTask;
         std::function<void (std::vector<LocationError> errs)> mProcImpl;
         inline virtual void proc() const {
             mProcImpl(mLocationErrors);
@@ -345,13 +352,16 @@ struct LocApiCollectiveResponse: LocMsg {
     public:
         inline LocApiCollectiveResponse(ContextBase& context,
                               std::function<void (std::vector<LocationError> errs)> procImpl ) :
-                              mContext(context), mProcImpl(procImpl) {}
+                              mMsgTask(*context.getMsgTask()), mProcImpl(procImpl) {}
+        inline LocApiCollectiveResponse(const MsgTask& msgTask,
+                              std::function<void (std::vector<LocationError> errs)> procImpl ) :
+                              mMsgTask(msgTask), mProcImpl(procImpl) {}
         inline virtual ~LocApiCollectiveResponse() {
         }
 
         void returnToSender(std::vector<LocationError>& errs) {
             mLocationErrors = errs;
-            mContext.sendMsg(this);
+            mMsgTask.sendMsg(this);
         }
 };
 
@@ -359,7 +369,7 @@ struct LocApiCollectiveResponse: LocMsg {
 template <typename DATA>
 struct LocApiResponseData: LocMsg {
     private:
-        ContextBase& mContext;
+        const MsgTask& mMsgTask;
         std::function<void (LocationError err, DATA data)> mProcImpl;
         inline virtual void proc() const {
             mProcImpl(mLocationError, mData);
@@ -370,12 +380,15 @@ struct LocApiResponseData: LocMsg {
     public:
         inline LocApiResponseData(ContextBase& context,
                               std::function<void (LocationError err, DATA data)> procImpl ) :
-                              mContext(context), mProcImpl(procImpl) {}
+                              mMsgTask(*context.getMsgTask()), mProcImpl(procImpl) {}
+        inline LocApiResponseData(const MsgTask& msgTask,
+                              std::function<void (LocationError err, DATA data)> procImpl ) :
+                              mMsgTask(msgTask), mProcImpl(procImpl) {}
 
         void returnToSender(const LocationError err, const DATA data) {
             mLocationError = err;
             mData = data;
-            mContext.sendMsg(this);
+            mMsgTask.sendMsg(this);
         }
 };
 
@@ -0,0 +1,192 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_EngineStateSnapshot"
+
+#include <EngineStateSnapshot.h>
+#include <loc_pla.h>
+#include <log_util.h>
+
+namespace loc_core {
+
+#define ENGINE_REPLAY_ROUND_TIMEOUT_MS 5000
+
+static const char* const sReplayPriorityNames[ENGINE_REPLAY_PRIORITY_COUNT] = {
+    "tracking", "geofence", "batching"
+};
+
+void EngineReplayTimer::timeOutCallback()
+{
+    mSnapshot.roundTimeout();
+}
+
+EngineStateSnapshot::EngineStateSnapshot() :
+    mCollecting(false),
+    mRoundOpen(false),
+    mExpectedMask(0),
+    mSubmittedMask(0),
+    mMsgTasks{},
+    mRoundTimer(*this),
+    mEngineUpTime(0),
+    mWaitingFirstFix(false),
+    mRounds(0)
+{
+}
+
+void EngineStateSnapshot::beginRound()
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (mRoundOpen) {
+        LOC_LOGw("round %u never completed, expected 0x%x submitted 0x%x",
+                 mRounds, mExpectedMask, mSubmittedMask);
+    }
+    mCollecting = true;
+    mRoundOpen = true;
+    mExpectedMask = 0;
+    mSubmittedMask = 0;
+    mEngineUpTime = uptimeMillis();
+    mWaitingFirstFix = true;
+    mRounds++;
+    mRoundTimer.stop();
+    mRoundTimer.start(ENGINE_REPLAY_ROUND_TIMEOUT_MS, false);
+}
+
+void EngineStateSnapshot::expect(EngineReplayPriority priority)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (mCollecting) {
+        mExpectedMask |= (1 << priority);
+    }
+}
+
+void EngineStateSnapshot::endRound()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCollecting = false;
+    LOC_LOGd("round %u expecting 0x%x submitted 0x%x",
+             mRounds, mExpectedMask, mSubmittedMask);
+    if (mRoundOpen && isCompleteLocked()) {
+        replay(lock);
+    }
+}
+
+void EngineStateSnapshot::submit(EngineReplayPriority priority, const MsgTask& msgTask,
+                                 std::vector<EngineReplayStep>&& steps)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    std::vector<EngineReplayStep>& pending = mSteps[priority];
+    pending.insert(pending.end(), std::make_move_iterator(steps.begin()),
+                   std::make_move_iterator(steps.end()));
+    mMsgTasks[priority] = &msgTask;
+    if (mRoundOpen) {
+        mSubmittedMask |= (1 << priority);
+        if (!isCompleteLocked()) {
+            LOC_LOGd("%s holding %zu steps for round %u",
+                     sReplayPriorityNames[priority], pending.size(), mRounds);
+            return;
+        }
+    }
+    replay(lock);
+}
+
+void EngineStateSnapshot::roundTimeout()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    // an expiry racing with the start of the next round leaves that round alone
+    if (!mRoundOpen || uptimeMillis() - mEngineUpTime < ENGINE_REPLAY_ROUND_TIMEOUT_MS) {
+        return;
+    }
+    LOC_LOGw("round %u timed out after %d ms, expected 0x%x submitted 0x%x, replaying",
+             mRounds, ENGINE_REPLAY_ROUND_TIMEOUT_MS, mExpectedMask, mSubmittedMask);
+    mCollecting = false;
+    replay(lock);
+}
+
+bool EngineStateSnapshot::isCompleteLocked() const
+{
+    return !mCollecting && (mSubmittedMask & mExpectedMask) == mExpectedMask;
+}
+
+void EngineStateSnapshot::replay(std::unique_lock<std::mutex>& lock)
+{
+    std::shared_ptr<Replay> replay = std::make_shared<Replay>();
+    for (int i = 0; i < ENGINE_REPLAY_PRIORITY_COUNT; i++) {
+        replay->steps[i].swap(mSteps[i]);
+        replay->msgTasks[i] = mMsgTasks[i];
+    }
+    replay->roundOpen = mRoundOpen;
+    replay->engineUpTime = mEngineUpTime;
+    if (mRoundOpen) {
+        mRoundOpen = false;
+        // no-op from the timer's own callback
+        mRoundTimer.stop();
+    }
+    lock.unlock();
+
+    replayFrom(replay, 0);
+}
+
+void EngineStateSnapshot::replayFrom(const std::shared_ptr<Replay>& replay, int priority)
+{
+    while (priority < ENGINE_REPLAY_PRIORITY_COUNT &&
+           (replay->steps[priority].empty() || nullptr == replay->msgTasks[priority])) {
+        priority++;
+    }
+    if (priority < ENGINE_REPLAY_PRIORITY_COUNT) {
+        // the steps only post to the LocApi thread, so running one priority to the end
+        // before posting the next keeps the calls in priority order
+        replay->msgTasks[priority]->sendMsg([replay, priority] () {
+            for (auto& step : replay->steps[priority]) {
+                step();
+            }
+            replayFrom(replay, priority + 1);
+        });
+    } else if (replay->roundOpen) {
+        LOC_LOGi("replayed %zu steps (tracking %zu geofence %zu batching %zu) %" PRId64
+                 " ms after engine up",
+                 replay->steps[ENGINE_REPLAY_PRIORITY_TRACKING].size() +
+                 replay->steps[ENGINE_REPLAY_PRIORITY_GEOFENCE].size() +
+                 replay->steps[ENGINE_REPLAY_PRIORITY_BATCHING].size(),
+                 replay->steps[ENGINE_REPLAY_PRIORITY_TRACKING].size(),
+                 replay->steps[ENGINE_REPLAY_PRIORITY_GEOFENCE].size(),
+                 replay->steps[ENGINE_REPLAY_PRIORITY_BATCHING].size(),
+                 uptimeMillis() - replay->engineUpTime);
+    }
+}
+
+void EngineStateSnapshot::reportFix()
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (mWaitingFirstFix) {
+        mWaitingFirstFix = false;
+        LOC_LOGi("time to first fix after engine up %" PRId64 " ms, round %u",
+                 uptimeMillis() - mEngineUpTime, mRounds);
+    }
+}
+
+} // namespace loc_core
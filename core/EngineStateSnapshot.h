@@ -0,0 +1,128 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ENGINE_STATE_SNAPSHOT_H
+#define ENGINE_STATE_SNAPSHOT_H
+
+#include <stdint.h>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <MsgTask.h>
+#include <LocTimer.h>
+
+using namespace loc_util;
+
+namespace loc_core {
+
+/* Order in which the adapters re-push their state to the engine after SSR */
+typedef enum {
+    ENGINE_REPLAY_PRIORITY_TRACKING = 0,
+    ENGINE_REPLAY_PRIORITY_GEOFENCE,
+    ENGINE_REPLAY_PRIORITY_BATCHING,
+    ENGINE_REPLAY_PRIORITY_COUNT
+} EngineReplayPriority;
+
+/* Re-pushes a piece of adapter state to the LocApi. It runs on the MsgTask of the
+   adapter that submitted it, so it reads the adapter state as it is at replay time. */
+typedef std::function<void()> EngineReplayStep;
+
+class EngineStateSnapshot;
+
+// replays what a round collected when an adapter never submits
+class EngineReplayTimer : public LocTimer {
+public:
+    inline EngineReplayTimer(EngineStateSnapshot& snapshot) :
+            LocTimer(), mSnapshot(snapshot) {}
+
+private:
+    // Override
+    virtual void timeOutCallback() override;
+
+    EngineStateSnapshot& mSnapshot;
+};
+
+/* Collects the state the adapters need to re-push after an engine restart and
+ * replays it to the LocApi in one pass, tracking first, then geofences, then
+ * batching, so that fixes come back before the rest of the state is restored.
+ *
+ * LocApiBase opens a round when the engine comes back up. Every adapter taking
+ * part calls expect() from its handleEngineUpEvent(), then submit() from its own
+ * thread. The round is replayed when the last expected adapter has submitted, or
+ * after ENGINE_REPLAY_ROUND_TIMEOUT_MS with what was collected. The steps of each
+ * priority are posted to the MsgTask they were submitted with, and the next
+ * priority is posted once they have run. Outside of a round a submit is replayed
+ * right away. */
+class EngineStateSnapshot {
+public:
+    EngineStateSnapshot();
+
+    // LocApi thread, around the engine up broadcast to the adapters
+    void beginRound();
+    void expect(EngineReplayPriority priority);
+    void endRound();
+
+    // any thread; steps may be empty when the adapter issued its calls itself
+    void submit(EngineReplayPriority priority, const MsgTask& msgTask,
+                std::vector<EngineReplayStep>&& steps);
+
+    // LocApi thread, logs the time to first fix once per round
+    void reportFix();
+
+    // LocTimer thread
+    void roundTimeout();
+
+private:
+    struct Replay {
+        std::vector<EngineReplayStep> steps[ENGINE_REPLAY_PRIORITY_COUNT];
+        const MsgTask* msgTasks[ENGINE_REPLAY_PRIORITY_COUNT];
+        bool roundOpen;
+        int64_t engineUpTime;
+    };
+
+    bool isCompleteLocked() const;
+    void replay(std::unique_lock<std::mutex>& lock);
+    static void replayFrom(const std::shared_ptr<Replay>& replay, int priority);
+
+    std::mutex mMutex;
+    bool mCollecting;
+    bool mRoundOpen;
+    uint32_t mExpectedMask;
+    uint32_t mSubmittedMask;
+    std::vector<EngineReplayStep> mSteps[ENGINE_REPLAY_PRIORITY_COUNT];
+    const MsgTask* mMsgTasks[ENGINE_REPLAY_PRIORITY_COUNT];
+    EngineReplayTimer mRoundTimer;
+    int64_t mEngineUpTime;
+    bool mWaitingFirstFix;
+    uint32_t mRounds;
+};
+
+} // namespace loc_core
+
+#endif //ENGINE_STATE_SNAPSHOT_H
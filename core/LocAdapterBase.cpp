@@ -33,6 +33,7 @@
 #include <LocAdapterBase.h>
 #include <loc_target.h>
 #include <log_util.h>
+#include <LocWorkAccounting.h>
 #include <LocAdapterProxyBase.h>
 
 namespace loc_core {
@@ -44,10 +45,10 @@ namespace loc_core {
 LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
                                ContextBase* context, bool isMaster,
                                LocAdapterProxyBase *adapterProxyBase,
-                               bool waitForDoneInit) :
+                               bool waitForDoneInit, const MsgTask* msgTask) :
     mIsMaster(isMaster), mEvtMask(mask), mContext(context),
     mLocApi(context->getLocApi()), mLocAdapterProxyBase(adapterProxyBase),
-    mMsgTask(context->getMsgTask()),
+    mMsgTask((NULL != msgTask) ? msgTask : context->getMsgTask()),
     mIsEngineCapabilitiesKnown(ContextBase::sIsEngineCapabilitiesKnown)
 {
     LOC_LOGd("waitForDoneInit: %d", waitForDoneInit);
@@ -59,14 +60,19 @@ LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
     }
 }
 
-uint32_t LocAdapterBase::mSessionIdCounter(1);
+std::atomic<uint32_t> LocAdapterBase::mSessionIdCounter(1);
 
 uint32_t LocAdapterBase::generateSessionId()
 {
-    if (++mSessionIdCounter == 0xFFFFFFFF)
-        mSessionIdCounter = 1;
+    // adapters on different workers may generate ids concurrently
+    uint32_t sessionId = ++mSessionIdCounter;
+    while (0xFFFFFFFF == sessionId || 0 == sessionId) {
+        uint32_t expected = sessionId;
+        mSessionIdCounter.compare_exchange_strong(expected, 1);
+        sessionId = ++mSessionIdCounter;
+    }
 
-     return mSessionIdCounter;
+    return sessionId;
 }
 
 void LocAdapterBase::handleEngineUpEvent()
@@ -255,6 +261,8 @@ LocAdapterBase::eraseClient(LocationAPI* client)
     auto it = mClientData.find(client);
     if (it != mClientData.end()) {
         mClientData.erase(it);
+        // the address may be reused by a later client
+        LocWorkAccounting::getInstance().removeClient(client);
     }
     updateClientsEventMask();
 }
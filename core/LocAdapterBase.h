@@ -33,6 +33,7 @@
 #include <ContextBase.h>
 #include <LocationAPI.h>
 #include <map>
+#include <atomic>
 
 #define MIN_TRACKING_INTERVAL (100) // 100 msec
 
@@ -60,7 +61,7 @@ class LocAdapterProxyBase;
 
 class LocAdapterBase {
 private:
-    static uint32_t mSessionIdCounter;
+    static std::atomic<uint32_t> mSessionIdCounter;
     const bool mIsMaster;
     bool mIsEngineCapabilitiesKnown = false;
 
@@ -101,10 +102,14 @@ public:
     // waitForDoneInit to *TRUE* to delay handleEngineUpEvent to get called
     // until when the child adapter finishes its initialization and notify
     // LocAdapterBase via doneInit method.
+    //
+    // msgTask is the worker the adapter msgs are processed on, the context
+    // MsgTask is used when it is not specified.
     LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
                    ContextBase* context, bool isMaster = false,
                    LocAdapterProxyBase *adapterProxyBase = NULL,
-                   bool waitForDoneInit = false);
+                   bool waitForDoneInit = false,
+                   const MsgTask* msgTask = NULL);
 
     inline void doneInit() {
         if (!mAdapterAdded) {
@@ -199,6 +204,7 @@ public:
                                       const LocInEmergency emergencyState);
     inline virtual bool isInSession() { return false; }
     ContextBase* getContext() const { return mContext; }
+    inline const MsgTask* getMsgTask() const { return mMsgTask; }
     virtual void reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurements,
                                                 int msInWeek);
     virtual bool reportWwanZppFix(LocGpsLocation &zppLoc);
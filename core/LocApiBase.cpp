@@ -30,13 +30,18 @@
 #define LOG_TAG "LocSvc_LocApiBase"
 
 #include <dlfcn.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <gps_extended_c.h>
 #include <LocApiBase.h>
 #include <LocAdapterBase.h>
 #include <log_util.h>
 #include <LocContext.h>
 #include <loc_misc_utils.h>
+#include <LocPluginRegistry.h>
 
 namespace loc_core {
 
@@ -306,8 +311,16 @@ void LocApiBase::updateNmeaMask(uint32_t mask)
 
 void LocApiBase::handleEngineUpEvent()
 {
+    loc_util::LocPluginRegistry& plugins = loc_util::LocPluginRegistry::getInstance();
+    if (plugins.markMilestone("engine up")) {
+        // plugin load times and failures, and the startup timeline so far
+        plugins.dump();
+    }
+    // adapters taking part in the replay register with the round while handling the event
+    mEngineStateSnapshot.beginRound();
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->handleEngineUpEvent());
+    mEngineStateSnapshot.endRound();
 }
 
 void LocApiBase::handleEngineDownEvent()
@@ -343,6 +356,10 @@ void LocApiBase::reportPosition(UlpLocation& location,
              locationExtended.gnss_sv_used_ids.gal_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.qzss_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.navic_sv_used_ids_mask);
+    if (LOC_SESS_SUCCESS == status &&
+            (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)) {
+        mEngineStateSnapshot.reportFix();
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(
         mLocAdapters[i]->reportPositionEvent(location, locationExtended,
@@ -990,11 +1007,13 @@ void ElapsedRealtimeEstimator::reset() {
 }
 
 int64_t ElapsedRealtimeEstimator::getElapsedRealtimeQtimer(int64_t qtimerTicksAtOrigin) {
-    struct timespec currentTime;
+    struct timespec sinceBootTime;
     int64_t sinceBootTimeNanos;
     int64_t elapsedRealTimeNanos;
 
-    if (getCurrentTime(currentTime, sinceBootTimeNanos)) {
+    // only BOOTTIME is needed here, no paired REALTIME reading
+    if (clock_gettime(CLOCK_BOOTTIME, &sinceBootTime) == 0) {
+       sinceBootTimeNanos = (int64_t)sinceBootTime.tv_sec * 1000000000 + sinceBootTime.tv_nsec;
        uint64_t qtimerDiff = 0;
        uint64_t qTimerTickCount = getQTimerTickCount();
        if (qTimerTickCount >= qtimerTicksAtOrigin) {
@@ -1010,7 +1029,8 @@ int64_t ElapsedRealtimeEstimator::getElapsedRealtimeQtimer(int64_t qtimerTicksAt
           Kona and will try to get Qtimer on modem side and on AP side and
           will adjust our difference accordingly */
        if (qTimerDiffNanos > 1000000000) {
-           uint64_t qtimerDelta = getQTimerDeltaNanos();
+           uint64_t qtimerDelta =
+                   ElapsedRealtimeClock::getInstance().getQTimerDeltaNanos(sinceBootTimeNanos);
            if (qTimerDiffNanos >= qtimerDelta) {
                qTimerDiffNanos -= qtimerDelta;
            }
@@ -1030,6 +1050,12 @@ int64_t ElapsedRealtimeEstimator::getElapsedRealtimeQtimer(int64_t qtimerTicksAt
 
 bool ElapsedRealtimeEstimator::getCurrentTime(
         struct timespec& currentTime, int64_t& sinceBootTimeNanos)
+{
+    return ElapsedRealtimeClock::getInstance().now(currentTime, sinceBootTimeNanos);
+}
+
+bool ElapsedRealtimeEstimator::sampleCurrentTime(
+        struct timespec& currentTime, int64_t& sinceBootTimeNanos)
 {
     struct timespec sinceBootTime;
     struct timespec sinceBootTimeTest;
@@ -1066,4 +1092,234 @@ bool ElapsedRealtimeEstimator::getCurrentTime(
     }
     return clockGetTimeSuccess;
 }
+
+#ifndef TFD_TIMER_CANCEL_ON_SET
+#define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#endif
+
+class ElapsedRealtimeSampler : public LocRunnable {
+    ElapsedRealtimeClock& mClock;
+public:
+    inline ElapsedRealtimeSampler(ElapsedRealtimeClock& clock) : mClock(clock) {}
+    virtual bool run() override { return mClock.sample(); }
+    virtual void interrupt() override {
+        mClock.mSamplerStopped = true;
+        mClock.wakeSampler();
+    }
+};
+
+ElapsedRealtimeClock& ElapsedRealtimeClock::getInstance() {
+    // never destroyed, the sampler thread holds on to it
+    static ElapsedRealtimeClock* sInstance = new ElapsedRealtimeClock();
+    return *sInstance;
+}
+
+ElapsedRealtimeClock::ElapsedRealtimeClock() :
+    mSeq(0), mRefBootNanos(0), mRefOffsetNanos(0), mDriftPpb(0),
+    mQTimerDeltaNanos(0), mNextQTimerRefreshNanos(0), mLastUseNanos(0),
+    mSamplerActive(false), mSamplerStopped(false),
+    mWakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+    mStepFd(timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK)),
+    mStats{0, 0, 0, 0, 0, 0}
+{
+    if (mWakeFd < 0) {
+        LOC_LOGe("eventfd failed, errno %d, every conversion reads both clocks", errno);
+        return;
+    }
+    armStepTimer();
+    mSamplerActive = true;
+    if (!mSamplerThread.start("Loc_clk_sampler",
+                              std::make_shared<ElapsedRealtimeSampler>(*this))) {
+        LOC_LOGe("failed to start the clock sampler, every conversion reads both clocks");
+        mSamplerActive = false;
+    }
+}
+
+void ElapsedRealtimeClock::armStepTimer() {
+    if (mStepFd < 0) {
+        return;
+    }
+    // the timer never expires, it is only there to be cancelled by a REALTIME set
+    struct itimerspec spec = {};
+    int ret = clock_gettime(CLOCK_REALTIME, &spec.it_value);
+    if (0 == ret) {
+        spec.it_value.tv_sec += 365 * 24 * 3600;
+        ret = timerfd_settime(mStepFd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET,
+                              &spec, NULL);
+    }
+    if (ret != 0) {
+        LOC_LOGw("REALTIME set detection unavailable, errno %d, steps are caught"
+                 " by the periodic refresh", errno);
+        close(mStepFd);
+        mStepFd = -1;
+    }
+}
+
+void ElapsedRealtimeClock::wakeSampler() {
+    // only the first conversion after the sampler went idle pays for the write
+    if (mWakeFd >= 0 && (mSamplerStopped || !mSamplerActive.exchange(true))) {
+        uint64_t one = 1;
+        if (write(mWakeFd, &one, sizeof(one)) < 0 && EAGAIN != errno) {
+            LOC_LOGw("failed to wake the clock sampler, errno %d", errno);
+        }
+    }
+}
+
+bool ElapsedRealtimeClock::sample() {
+    struct pollfd fds[2] = {{mWakeFd, POLLIN, 0}, {mStepFd, POLLIN, 0}};
+    int timeoutMsec = mSamplerActive ? (int)(REFRESH_PERIOD_NANOS / 1000000) : -1;
+    int ret = poll(fds, mStepFd >= 0 ? 2 : 1, timeoutMsec);
+    if (mSamplerStopped) {
+        return false;
+    }
+    if (ret < 0) {
+        if (EINTR == errno) {
+            return true;
+        }
+        LOC_LOGe("clock sampler poll failed, errno %d", errno);
+        mSamplerActive = false;
+        return false;
+    }
+
+    if (fds[0].revents & POLLIN) {
+        uint64_t count;
+        (void)read(mWakeFd, &count, sizeof(count));
+    }
+    bool realtimeSet = false;
+    if (mStepFd >= 0 && (fds[1].revents & POLLIN)) {
+        uint64_t expirations;
+        realtimeSet = read(mStepFd, &expirations, sizeof(expirations)) < 0 &&
+                ECANCELED == errno;
+        armStepTimer();
+    }
+    refresh(realtimeSet);
+
+    // go idle once conversions stopped; the next one wakes the sampler again
+    struct timespec sinceBootTime;
+    if (0 == clock_gettime(CLOCK_BOOTTIME, &sinceBootTime)) {
+        int64_t bootNanos = (int64_t)sinceBootTime.tv_sec * 1000000000 + sinceBootTime.tv_nsec;
+        if (bootNanos - mLastUseNanos.load(std::memory_order_relaxed) > STALE_NANOS) {
+            mSamplerActive = false;
+        }
+    }
+    return true;
+}
+
+bool ElapsedRealtimeClock::readModel(
+        int64_t& refBootNanos, int64_t& refOffsetNanos, int64_t& driftPpb) const {
+    uint32_t seq;
+    do {
+        seq = mSeq.load(std::memory_order_acquire);
+        refBootNanos = mRefBootNanos.load(std::memory_order_relaxed);
+        refOffsetNanos = mRefOffsetNanos.load(std::memory_order_relaxed);
+        driftPpb = mDriftPpb.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != mSeq.load(std::memory_order_relaxed));
+    // nothing published yet
+    return seq != 0;
+}
+
+void ElapsedRealtimeClock::refresh(bool realtimeSet) {
+    std::lock_guard<std::mutex> lock(mRefreshMutex);
+    if (realtimeSet) {
+        mStats.realtimeSets++;
+    }
+
+    struct timespec currentTime;
+    int64_t bootNanos;
+    if (!ElapsedRealtimeEstimator::sampleCurrentTime(currentTime, bootNanos)) {
+        return;
+    }
+    int64_t offsetNanos =
+            (int64_t)currentTime.tv_sec * 1000000000 + currentTime.tv_nsec - bootNanos;
+
+    int64_t refBootNanos, refOffsetNanos, driftPpb;
+    if (readModel(refBootNanos, refOffsetNanos, driftPpb)) {
+        int64_t elapsedNanos = bootNanos - refBootNanos;
+        int64_t predictedNanos = refOffsetNanos + (int64_t)((double)elapsedNanos * driftPpb * 1e-9);
+        int64_t errorNanos = offsetNanos - predictedNanos;
+        mStats.lastErrorNanos = errorNanos;
+        if (realtimeSet || llabs(errorNanos) > STEP_THRESHOLD_NANOS) {
+            // REALTIME was stepped, start the rate over from this reading
+            mStats.steps++;
+            driftPpb = 0;
+        } else {
+            if (llabs(errorNanos) > mStats.maxErrorNanos) {
+                mStats.maxErrorNanos = llabs(errorNanos);
+            }
+            if (elapsedNanos > 0) {
+                int64_t measuredPpb = (int64_t)((double)(offsetNanos - refOffsetNanos) * 1e9 /
+                                                elapsedNanos);
+                if (measuredPpb > MAX_DRIFT_PPB) {
+                    measuredPpb = MAX_DRIFT_PPB;
+                } else if (measuredPpb < -MAX_DRIFT_PPB) {
+                    measuredPpb = -MAX_DRIFT_PPB;
+                }
+                // smooth out the jitter of single readings
+                driftPpb += (measuredPpb - driftPpb) / 8;
+            }
+        }
+    }
+    mStats.samples++;
+    mStats.driftPpb = driftPpb;
+
+    uint32_t seq = mSeq.load(std::memory_order_relaxed);
+    mSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mRefBootNanos.store(bootNanos, std::memory_order_relaxed);
+    mRefOffsetNanos.store(offsetNanos, std::memory_order_relaxed);
+    mDriftPpb.store(driftPpb, std::memory_order_relaxed);
+    mSeq.store(seq + 2, std::memory_order_release);
+
+    LOC_LOGv("clock model: samples %u steps %u error %" PRIi64 " ns max %" PRIi64 " ns"
+             " drift %" PRIi64 " ppb realtime sets %u", mStats.samples, mStats.steps,
+             mStats.lastErrorNanos, mStats.maxErrorNanos, mStats.driftPpb, mStats.realtimeSets);
+}
+
+bool ElapsedRealtimeClock::now(struct timespec& currentTime, int64_t& sinceBootTimeNanos) {
+    struct timespec sinceBootTime;
+    if (clock_gettime(CLOCK_BOOTTIME, &sinceBootTime) != 0) {
+        return false;
+    }
+    sinceBootTimeNanos = (int64_t)sinceBootTime.tv_sec * 1000000000 + sinceBootTime.tv_nsec;
+    // keeps the sampler running; a quarter period is plenty to tell it is in use
+    if (sinceBootTimeNanos - mLastUseNanos.load(std::memory_order_relaxed) >
+            REFRESH_PERIOD_NANOS / 4) {
+        mLastUseNanos.store(sinceBootTimeNanos, std::memory_order_relaxed);
+    }
+
+    int64_t refBootNanos, refOffsetNanos, driftPpb;
+    if (!readModel(refBootNanos, refOffsetNanos, driftPpb) ||
+            sinceBootTimeNanos - refBootNanos > STALE_NANOS) {
+        // no model yet, or the sampler was idle; it refreshes the model for the next ones
+        wakeSampler();
+        return ElapsedRealtimeEstimator::sampleCurrentTime(currentTime, sinceBootTimeNanos);
+    }
+    int64_t currentTimeNanos = sinceBootTimeNanos + refOffsetNanos +
+            (int64_t)((double)(sinceBootTimeNanos - refBootNanos) * driftPpb * 1e-9);
+    currentTime.tv_sec = currentTimeNanos / 1000000000;
+    currentTime.tv_nsec = currentTimeNanos % 1000000000;
+    return true;
+}
+
+uint64_t ElapsedRealtimeClock::getQTimerDeltaNanos(int64_t sinceBootTimeNanos) {
+    if (sinceBootTimeNanos >= mNextQTimerRefreshNanos.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(mRefreshMutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            mQTimerDeltaNanos.store(::getQTimerDeltaNanos(), std::memory_order_relaxed);
+            mNextQTimerRefreshNanos.store(sinceBootTimeNanos + REFRESH_PERIOD_NANOS,
+                                          std::memory_order_release);
+        } else if (0 == mNextQTimerRefreshNanos.load(std::memory_order_acquire)) {
+            // never read yet and someone else holds the lock
+            return ::getQTimerDeltaNanos();
+        }
+    }
+    return mQTimerDeltaNanos.load(std::memory_order_relaxed);
+}
+
+ElapsedRealtimeClock::Stats ElapsedRealtimeClock::getStats() {
+    std::lock_guard<std::mutex> guard(mRefreshMutex);
+    return mStats;
+}
+
 } // namespace loc_core
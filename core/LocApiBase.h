@@ -34,8 +34,10 @@
 #include <gps_extended.h>
 #include <LocationAPI.h>
 #include <MsgTask.h>
+#include <LocThread.h>
 #include <LocSharedLock.h>
 #include <log_util.h>
+#include <EngineStateSnapshot.h>
 #ifdef NO_UNORDERED_SET_OR_MAP
     #include <map>
 #else
@@ -43,6 +45,8 @@
 #endif
 #include <inttypes.h>
 #include <functional>
+#include <atomic>
+#include <mutex>
 
 using namespace loc_util;
 
@@ -114,6 +118,7 @@ class LocApiBase {
     static MsgTask* mMsgTask;
     static volatile int32_t mMsgTaskRefCount;
     LocAdapterBase* mLocAdapters[MAX_ADAPTERS];
+    EngineStateSnapshot mEngineStateSnapshot;
 
 protected:
     ContextBase *mContext;
@@ -161,6 +166,7 @@ public:
 
     void addAdapter(LocAdapterBase* adapter);
     void removeAdapter(LocAdapterBase* adapter);
+    inline EngineStateSnapshot& getEngineStateSnapshot() { return mEngineStateSnapshot; }
 
     // upward calls
     void handleEngineUpEvent();
@@ -346,6 +352,59 @@ public:
                                         LocApiResponse* adapterResponse=nullptr);
 };
 
+/* REALTIME modelled as a linear function of BOOTTIME, offset plus drift rate.
+   Converting costs one BOOTTIME read and a multiply. The model is published
+   under a sequence counter, so readers never block on a refresh.
+   A sampler thread refreshes the model from a careful paired reading of both
+   clocks every REFRESH_PERIOD_NANOS while conversions are made, and sleeps
+   once they stop. A REALTIME step, e.g. the time being set, wakes it at once
+   through a CLOCK_REALTIME timerfd armed with TFD_TIMER_CANCEL_ON_SET; the
+   refresh then restarts the drift rate. A conversion which finds the model
+   older than STALE_NANOS, as the sampler slept, wakes it and uses a paired
+   reading itself. */
+class ElapsedRealtimeClock {
+    friend class ElapsedRealtimeSampler;
+public:
+    typedef GnssDebugClockStats Stats;
+
+    static ElapsedRealtimeClock& getInstance();
+    bool now(struct timespec& currentTime, int64_t& sinceBootTimeNanos);
+    // getQTimerDeltaNanos() reads sysfs, so it is refreshed with the model
+    uint64_t getQTimerDeltaNanos(int64_t sinceBootTimeNanos);
+    Stats getStats();
+
+private:
+    static const int64_t REFRESH_PERIOD_NANOS = 1000000000LL;
+    static const int64_t STALE_NANOS = 2 * REFRESH_PERIOD_NANOS;
+    static const int64_t STEP_THRESHOLD_NANOS = 1000000LL;
+    static const int64_t MAX_DRIFT_PPB = 500000LL;
+
+    std::atomic<uint32_t> mSeq;
+    std::atomic<int64_t> mRefBootNanos;
+    std::atomic<int64_t> mRefOffsetNanos;
+    std::atomic<int64_t> mDriftPpb;
+    std::atomic<uint64_t> mQTimerDeltaNanos;
+    std::atomic<int64_t> mNextQTimerRefreshNanos;
+    // BOOTTIME of a recent conversion, kept to within a quarter period
+    std::atomic<int64_t> mLastUseNanos;
+    std::atomic<bool> mSamplerActive;
+    std::atomic<bool> mSamplerStopped;
+    int mWakeFd;    // eventfd waking the sampler
+    int mStepFd;    // CLOCK_REALTIME timerfd, only touched by the sampler once it runs
+    loc_util::LocThread mSamplerThread;
+    // held by the refreshing sampler, guards mStats
+    std::mutex mRefreshMutex;
+    Stats mStats;
+
+    ElapsedRealtimeClock();
+    bool readModel(int64_t& refBootNanos, int64_t& refOffsetNanos, int64_t& driftPpb) const;
+    void refresh(bool realtimeSet);
+    void armStepTimer();
+    void wakeSampler();
+    // one round of the sampler thread, false once it is stopped
+    bool sample();
+};
+
 class ElapsedRealtimeEstimator {
 private:
     int64_t mCurrentClockDiff;
@@ -365,6 +424,8 @@ public:
 
     static int64_t getElapsedRealtimeQtimer(int64_t qtimerTicksAtOrigin);
     static bool getCurrentTime(struct timespec& currentTime, int64_t& sinceBootTimeNanos);
+    // the paired BOOTTIME / REALTIME reading ElapsedRealtimeClock refreshes from
+    static bool sampleCurrentTime(struct timespec& currentTime, int64_t& sinceBootTimeNanos);
 };
 
 typedef LocApiBase* (getLocApi_t)(LOC_API_ADAPTER_EVENT_MASK_T exMask,
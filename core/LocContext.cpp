@@ -35,13 +35,20 @@
 #include <msg_q.h>
 #include <log_util.h>
 #include <loc_log.h>
+#include <loc_misc_utils.h>
+#include <LocInitGraph.h>
+#include <LocPluginRegistry.h>
+#include <SystemStatus.h>
 
 namespace loc_core {
 
 const MsgTask* LocContext::mMsgTask = NULL;
 ContextBase* LocContext::mContext = NULL;
+std::map<std::string, const MsgTask*> LocContext::mAdapterMsgTasks;
 // the name must be shorter than 15 chars
 const char* LocContext::mLocationHalName = "Loc_hal_worker";
+const char* LocContext::mBatchingWorkerName = "Loc_batch_wrkr";
+const char* LocContext::mGeofenceWorkerName = "Loc_gf_worker";
 #ifndef USE_GLIB
 const char* LocContext::mLBSLibName = "liblbs_core.so";
 #else
@@ -50,14 +57,69 @@ const char* LocContext::mLBSLibName = "liblbs_core.so.1";
 
 pthread_mutex_t LocContext::mGetLocContextMutex = PTHREAD_MUTEX_INITIALIZER;
 
+static uint32_t sAdapterWorkerSharding = 0;
+static char sHalWorkerThreadName[LOC_MAX_PARAM_STRING];
+static char sBatchingWorkerThreadName[LOC_MAX_PARAM_STRING];
+static char sGeofenceWorkerThreadName[LOC_MAX_PARAM_STRING];
+static const loc_param_s_type workerConfParamTable[] =
+{
+    {"ADAPTER_WORKER_SHARDING",      &sAdapterWorkerSharding,    NULL, 'n'},
+    {"HAL_WORKER_THREAD_NAME",       &sHalWorkerThreadName,      NULL, 's'},
+    {"BATCHING_WORKER_THREAD_NAME",  &sBatchingWorkerThreadName, NULL, 's'},
+    {"GEOFENCE_WORKER_THREAD_NAME",  &sGeofenceWorkerThreadName, NULL, 's'}
+};
+
+void LocContext::readWorkerConfig()
+{
+    // function-local static init is thread safe, the conf is read exactly once
+    static const bool confReadDone = []() {
+        UTIL_READ_CONF(LOC_PATH_GPS_CONF, workerConfParamTable);
+        LOC_LOGd("ADAPTER_WORKER_SHARDING %u", sAdapterWorkerSharding);
+        return true;
+    }();
+    (void)confReadDone;
+}
+
 const MsgTask* LocContext::getMsgTask(const char* name)
 {
     if (NULL == mMsgTask) {
+        readWorkerConfig();
+        if (0 != sHalWorkerThreadName[0]) {
+            name = sHalWorkerThreadName;
+        }
         mMsgTask = new MsgTask(name);
     }
     return mMsgTask;
 }
 
+// Creates the context with the start-up steps that do not depend on each other
+// running side by side. Reading gps.conf and sap.conf and creating the
+// SystemStatus observer the adapters subscribe through overlap with loading the
+// LBS proxy library. The context, whose LocApi is picked by the configured
+// GNSS_DEPLOYMENT and resolved through that proxy, waits for the first two.
+ContextBase* LocContext::createContext(const MsgTask* msgTask)
+{
+    ContextBase* context = NULL;
+    loc_util::LocInitGraph graph("location context");
+    size_t config = graph.add("read gps.conf and sap.conf", []() {
+        ContextBase::readConfig();
+    });
+    size_t lbsProxy = graph.add("load LBS proxy", []() {
+        void* handle = nullptr;
+        dlGetSymFromLib(handle, mLBSLibName, "getLBSProxy");
+    });
+    graph.add("create SystemStatus", [msgTask]() {
+        SystemStatus::getInstance(msgTask);
+    });
+    graph.add("create LocApi", [msgTask, &context]() {
+        context = new LocContext(msgTask);
+    }, {config, lbsProxy});
+    graph.run();
+
+    loc_util::LocPluginRegistry::getInstance().markMilestone("location context created");
+    return context;
+}
+
 ContextBase* LocContext::getLocContext(const char* name)
 {
     pthread_mutex_lock(&LocContext::mGetLocContextMutex);
@@ -65,13 +127,41 @@ ContextBase* LocContext::getLocContext(const char* name)
     if (NULL == mContext) {
         LOC_LOGD("%s:%d]: creating msgTask with tCreator", __func__, __LINE__);
         const MsgTask* msgTask = getMsgTask(name);
-        mContext = new LocContext(msgTask);
+        mContext = createContext(msgTask);
     }
     pthread_mutex_unlock(&LocContext::mGetLocContextMutex);
 
     return mContext;
 }
 
+const MsgTask* LocContext::getAdapterMsgTask(const char* name)
+{
+    ContextBase* context = getLocContext(mLocationHalName);
+    const MsgTask* msgTask = context->getMsgTask();
+
+    pthread_mutex_lock(&LocContext::mGetLocContextMutex);
+    if (0 != sAdapterWorkerSharding && nullptr != name) {
+        auto it = mAdapterMsgTasks.find(name);
+        if (mAdapterMsgTasks.end() != it) {
+            msgTask = it->second;
+        } else {
+            const char* threadName = name;
+            if (0 == strcmp(name, mBatchingWorkerName) && 0 != sBatchingWorkerThreadName[0]) {
+                threadName = sBatchingWorkerThreadName;
+            } else if (0 == strcmp(name, mGeofenceWorkerName) &&
+                       0 != sGeofenceWorkerThreadName[0]) {
+                threadName = sGeofenceWorkerThreadName;
+            }
+            LOC_LOGi("creating dedicated adapter worker %s", threadName);
+            msgTask = new MsgTask(threadName);
+            mAdapterMsgTasks[name] = msgTask;
+        }
+    }
+    pthread_mutex_unlock(&LocContext::mGetLocContextMutex);
+
+    return msgTask;
+}
+
 void LocContext :: injectFeatureConfig(ContextBase *curContext)
 {
     LOC_LOGD("%s:%d]: Calling LBSProxy (%p) to inject feature config",
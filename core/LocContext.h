@@ -32,6 +32,8 @@
 #include <stdbool.h>
 #include <ctype.h>
 #include <dlfcn.h>
+#include <map>
+#include <string>
 #include <ContextBase.h>
 
 namespace loc_core {
@@ -41,6 +43,9 @@ class LocContext : public ContextBase {
     static ContextBase* mContext;
     static const MsgTask* getMsgTask(const char* name);
     static pthread_mutex_t mGetLocContextMutex;
+    static std::map<std::string, const MsgTask*> mAdapterMsgTasks;
+    static void readWorkerConfig();
+    static ContextBase* createContext(const MsgTask* msgTask);
 
 protected:
     LocContext(const MsgTask* msgTask);
@@ -49,9 +54,20 @@ protected:
 public:
     static const char* mLBSLibName;
     static const char* mLocationHalName;
+    static const char* mBatchingWorkerName;
+    static const char* mGeofenceWorkerName;
 
     static ContextBase* getLocContext(const char* name);
 
+    // Returns the worker MsgTask for the adapter of the given worker name.
+    // With ADAPTER_WORKER_SHARDING enabled in gps.conf, each worker name gets
+    // its own MsgTask, otherwise all adapters share the context MsgTask.
+    // The context MsgTask remains the owner of the state shared across
+    // adapters (ODCPI, engine lock, SystemStatus consumers in GnssAdapter),
+    // an adapter on a dedicated worker must reach that state only through
+    // ContextBase::sendMsg().
+    static const MsgTask* getAdapterMsgTask(const char* name);
+
     static void injectFeatureConfig(ContextBase *context);
 };
 
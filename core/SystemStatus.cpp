@@ -1288,10 +1288,15 @@ void SystemStatus::destroyInstance()
 }
 
 void SystemStatus::resetNetworkInfo() {
-    for (int i=0; i<mCache.mNetworkInfo.size(); ++i) {
+    std::vector<SystemStatusNetworkInfo> networkInfo;
+    pthread_rwlock_rdlock(&mReportLocks[REPORT_LOCK_DATAITEM]);
+    mCache.mNetworkInfo.copyLast(networkInfo, mCache.mNetworkInfo.capacity());
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_DATAITEM]);
+
+    for (size_t i=0; i<networkInfo.size(); ++i) {
         // Reset all the cached NetworkInfo Items as disconnected
-        eventConnectionStatus(false, mCache.mNetworkInfo[i].mType, mCache.mNetworkInfo[i].mRoaming,
-                mCache.mNetworkInfo[i].mNetworkHandle, mCache.mNetworkInfo[i].mApn);
+        eventConnectionStatus(false, networkInfo[i].mType, networkInfo[i].mRoaming,
+                networkInfo[i].mNetworkHandle, networkInfo[i].mApn);
     }
 }
 
@@ -1301,10 +1306,14 @@ IOsObserver* SystemStatus::getOsObserver()
 }
 
 SystemStatus::SystemStatus(const MsgTask* msgTask) :
-    mSysStatusObsvr(this, msgTask)
+    mSysStatusObsvr(this, msgTask),
+    mPowerConnectState(-1)
 {
     int result = 0;
     ENTRY_LOG ();
+    for (int i = 0; i < REPORT_LOCK_MAX; i++) {
+        pthread_rwlock_init(&mReportLocks[i], nullptr);
+    }
     mCache.mLocation.clear();
 
     mCache.mTimeAndClock.clear();
@@ -1348,6 +1357,13 @@ SystemStatus::SystemStatus(const MsgTask* msgTask) :
     EXIT_LOG_WITH_ERROR ("%d",result);
 }
 
+SystemStatus::~SystemStatus()
+{
+    for (int i = 0; i < REPORT_LOCK_MAX; i++) {
+        pthread_rwlock_destroy(&mReportLocks[i]);
+    }
+}
+
 /******************************************************************************
  SystemStatus - storing dataitems
 ******************************************************************************/
@@ -1363,11 +1379,8 @@ bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
         return false;
     }
 
-    // first event or updated
+    // first event or updated, the ring drops the oldest entry once full
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
     return true;
 }
 
@@ -1375,17 +1388,18 @@ template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
 {
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
-void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const
+void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c,
+                                   bool isLatestOnly) const
 {
-    reportout.clear();
-    if (c.size() >= 1) {
-        reportout.push_back(c.back());
+    if (!isLatestOnly) {
+        c.copyLast(reportout, c.capacity());
+        return;
+    }
+    c.copyLast(reportout, 1);
+    if (!reportout.empty()) {
         reportout.back().dump();
     }
 }
@@ -1407,7 +1421,7 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
     char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1] = { 0 };
     strlcpy(buf, data, sizeof(buf));
 
-    pthread_mutex_lock(&mMutexSystemStatus);
+    pthread_rwlock_wrlock(&mReportLocks[REPORT_LOCK_NMEA]);
 
     // parse the received nmea strings here
     if (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
@@ -1453,7 +1467,7 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
         // do nothing
     }
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_NMEA]);
     return true;
 }
 
@@ -1468,7 +1482,7 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
                                  const GpsLocationExtended& locationEx)
 {
     bool ret = false;
-    pthread_mutex_lock(&mMutexSystemStatus);
+    pthread_rwlock_wrlock(&mReportLocks[REPORT_LOCK_POSITION]);
 
     ret = setIteminReport(mCache.mLocation, SystemStatusLocation(location, locationEx));
     LOC_LOGV("eventPosition - lat=%f lon=%f alt=%f speed=%f",
@@ -1477,7 +1491,7 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
              location.gpsLocation.altitude,
              location.gpsLocation.speed);
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_POSITION]);
     return ret;
 }
 
@@ -1491,7 +1505,7 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
 bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 {
     bool ret = false;
-    pthread_mutex_lock(&mMutexSystemStatus);
+    pthread_rwlock_wrlock(&mReportLocks[REPORT_LOCK_DATAITEM]);
     switch(dataitem->getId())
     {
         case AIRPLANEMODE_DATA_ITEM_ID:
@@ -1585,7 +1599,7 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
         default:
             break;
     }
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_DATAITEM]);
     LOC_LOGv("DataItemId: %d, whether to record dateitem in cache: %d", dataitem->getId(), ret);
     return ret;
 }
@@ -1600,96 +1614,56 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 ******************************************************************************/
 bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) const
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
-
-    if (isLatestOnly) {
-        // push back only the latest report and return it
-        getIteminReport(report.mLocation, mCache.mLocation);
-
-        getIteminReport(report.mTimeAndClock, mCache.mTimeAndClock);
-        getIteminReport(report.mXoState, mCache.mXoState);
-        getIteminReport(report.mRfAndParams, mCache.mRfAndParams);
-        getIteminReport(report.mErrRecovery, mCache.mErrRecovery);
-
-        getIteminReport(report.mInjectedPosition, mCache.mInjectedPosition);
-        getIteminReport(report.mBestPosition, mCache.mBestPosition);
-        getIteminReport(report.mXtra, mCache.mXtra);
-        getIteminReport(report.mEphemeris, mCache.mEphemeris);
-        getIteminReport(report.mSvHealth, mCache.mSvHealth);
-        getIteminReport(report.mPdr, mCache.mPdr);
-        getIteminReport(report.mNavData, mCache.mNavData);
-
-        getIteminReport(report.mPositionFailure, mCache.mPositionFailure);
-
-        getIteminReport(report.mAirplaneMode, mCache.mAirplaneMode);
-        getIteminReport(report.mENH, mCache.mENH);
-        getIteminReport(report.mGPSState, mCache.mGPSState);
-        getIteminReport(report.mNLPStatus, mCache.mNLPStatus);
-        getIteminReport(report.mWifiHardwareState, mCache.mWifiHardwareState);
-        getIteminReport(report.mNetworkInfo, mCache.mNetworkInfo);
-        getIteminReport(report.mRilServiceInfo, mCache.mRilServiceInfo);
-        getIteminReport(report.mRilCellInfo, mCache.mRilCellInfo);
-        getIteminReport(report.mServiceStatus, mCache.mServiceStatus);
-        getIteminReport(report.mModel, mCache.mModel);
-        getIteminReport(report.mManufacturer, mCache.mManufacturer);
-        getIteminReport(report.mAssistedGps, mCache.mAssistedGps);
-        getIteminReport(report.mScreenState, mCache.mScreenState);
-        getIteminReport(report.mPowerConnectState, mCache.mPowerConnectState);
-        getIteminReport(report.mTimeZoneChange, mCache.mTimeZoneChange);
-        getIteminReport(report.mTimeChange, mCache.mTimeChange);
-        getIteminReport(report.mWifiSupplicantStatus, mCache.mWifiSupplicantStatus);
-        getIteminReport(report.mShutdownState, mCache.mShutdownState);
-        getIteminReport(report.mTac, mCache.mTac);
-        getIteminReport(report.mMccMnc, mCache.mMccMnc);
-        getIteminReport(report.mBtDeviceScanDetail, mCache.mBtDeviceScanDetail);
-        getIteminReport(report.mBtLeDeviceScanDetail, mCache.mBtLeDeviceScanDetail);
-    }
-    else {
-        // copy entire reports and return them
-        report.mLocation.clear();
-
-        report.mTimeAndClock.clear();
-        report.mXoState.clear();
-        report.mRfAndParams.clear();
-        report.mErrRecovery.clear();
-
-        report.mInjectedPosition.clear();
-        report.mBestPosition.clear();
-        report.mXtra.clear();
-        report.mEphemeris.clear();
-        report.mSvHealth.clear();
-        report.mPdr.clear();
-        report.mNavData.clear();
-
-        report.mPositionFailure.clear();
-
-        report.mAirplaneMode.clear();
-        report.mENH.clear();
-        report.mGPSState.clear();
-        report.mNLPStatus.clear();
-        report.mWifiHardwareState.clear();
-        report.mNetworkInfo.clear();
-        report.mRilServiceInfo.clear();
-        report.mRilCellInfo.clear();
-        report.mServiceStatus.clear();
-        report.mModel.clear();
-        report.mManufacturer.clear();
-        report.mAssistedGps.clear();
-        report.mScreenState.clear();
-        report.mPowerConnectState.clear();
-        report.mTimeZoneChange.clear();
-        report.mTimeChange.clear();
-        report.mWifiSupplicantStatus.clear();
-        report.mShutdownState.clear();
-        report.mTac.clear();
-        report.mMccMnc.clear();
-        report.mBtDeviceScanDetail.clear();
-        report.mBtLeDeviceScanDetail.clear();
-
-        report = mCache;
-    }
-
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    // either only the latest entry of each history or the whole of it. Each
+    // source is copied under its own read lock, so the snapshot is consistent
+    // per source and writers of the other sources carry on meanwhile.
+    pthread_rwlock_rdlock(&mReportLocks[REPORT_LOCK_POSITION]);
+    getIteminReport(report.mLocation, mCache.mLocation, isLatestOnly);
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_POSITION]);
+
+    pthread_rwlock_rdlock(&mReportLocks[REPORT_LOCK_NMEA]);
+    getIteminReport(report.mTimeAndClock, mCache.mTimeAndClock, isLatestOnly);
+    getIteminReport(report.mXoState, mCache.mXoState, isLatestOnly);
+    getIteminReport(report.mRfAndParams, mCache.mRfAndParams, isLatestOnly);
+    getIteminReport(report.mErrRecovery, mCache.mErrRecovery, isLatestOnly);
+
+    getIteminReport(report.mInjectedPosition, mCache.mInjectedPosition, isLatestOnly);
+    getIteminReport(report.mBestPosition, mCache.mBestPosition, isLatestOnly);
+    getIteminReport(report.mXtra, mCache.mXtra, isLatestOnly);
+    getIteminReport(report.mEphemeris, mCache.mEphemeris, isLatestOnly);
+    getIteminReport(report.mSvHealth, mCache.mSvHealth, isLatestOnly);
+    getIteminReport(report.mPdr, mCache.mPdr, isLatestOnly);
+    getIteminReport(report.mNavData, mCache.mNavData, isLatestOnly);
+
+    getIteminReport(report.mPositionFailure, mCache.mPositionFailure, isLatestOnly);
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_NMEA]);
+
+    pthread_rwlock_rdlock(&mReportLocks[REPORT_LOCK_DATAITEM]);
+    getIteminReport(report.mAirplaneMode, mCache.mAirplaneMode, isLatestOnly);
+    getIteminReport(report.mENH, mCache.mENH, isLatestOnly);
+    getIteminReport(report.mGPSState, mCache.mGPSState, isLatestOnly);
+    getIteminReport(report.mNLPStatus, mCache.mNLPStatus, isLatestOnly);
+    getIteminReport(report.mWifiHardwareState, mCache.mWifiHardwareState, isLatestOnly);
+    getIteminReport(report.mNetworkInfo, mCache.mNetworkInfo, isLatestOnly);
+    getIteminReport(report.mRilServiceInfo, mCache.mRilServiceInfo, isLatestOnly);
+    getIteminReport(report.mRilCellInfo, mCache.mRilCellInfo, isLatestOnly);
+    getIteminReport(report.mServiceStatus, mCache.mServiceStatus, isLatestOnly);
+    getIteminReport(report.mModel, mCache.mModel, isLatestOnly);
+    getIteminReport(report.mManufacturer, mCache.mManufacturer, isLatestOnly);
+    getIteminReport(report.mAssistedGps, mCache.mAssistedGps, isLatestOnly);
+    getIteminReport(report.mScreenState, mCache.mScreenState, isLatestOnly);
+    getIteminReport(report.mPowerConnectState, mCache.mPowerConnectState, isLatestOnly);
+    getIteminReport(report.mTimeZoneChange, mCache.mTimeZoneChange, isLatestOnly);
+    getIteminReport(report.mTimeChange, mCache.mTimeChange, isLatestOnly);
+    getIteminReport(report.mWifiSupplicantStatus, mCache.mWifiSupplicantStatus,
+            isLatestOnly);
+    getIteminReport(report.mShutdownState, mCache.mShutdownState, isLatestOnly);
+    getIteminReport(report.mTac, mCache.mTac, isLatestOnly);
+    getIteminReport(report.mMccMnc, mCache.mMccMnc, isLatestOnly);
+    getIteminReport(report.mBtDeviceScanDetail, mCache.mBtDeviceScanDetail, isLatestOnly);
+    getIteminReport(report.mBtLeDeviceScanDetail, mCache.mBtLeDeviceScanDetail,
+            isLatestOnly);
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_DATAITEM]);
     return true;
 }
 
@@ -1702,10 +1676,11 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
 ******************************************************************************/
 bool SystemStatus::setDefaultGnssEngineStates(void)
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
-
+    pthread_rwlock_wrlock(&mReportLocks[REPORT_LOCK_POSITION]);
     setDefaultIteminReport(mCache.mLocation, SystemStatusLocation());
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_POSITION]);
 
+    pthread_rwlock_wrlock(&mReportLocks[REPORT_LOCK_NMEA]);
     setDefaultIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock());
     setDefaultIteminReport(mCache.mXoState, SystemStatusXoState());
     setDefaultIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams());
@@ -1720,8 +1695,8 @@ bool SystemStatus::setDefaultGnssEngineStates(void)
     setDefaultIteminReport(mCache.mNavData, SystemStatusNavData());
 
     setDefaultIteminReport(mCache.mPositionFailure, SystemStatusPositionFailure());
+    pthread_rwlock_unlock(&mReportLocks[REPORT_LOCK_NMEA]);
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
 }
 
@@ -1753,6 +1728,11 @@ bool SystemStatus::eventConnectionStatus(bool connected, int8_t type,
 ******************************************************************************/
 bool SystemStatus::updatePowerConnectState(bool charging)
 {
+    // only edges are passed on, repeats would be dropped by the observer anyway
+    if (mPowerConnectState.exchange(charging ? 1 : 0) == (charging ? 1 : 0)) {
+        LOC_LOGv("power connect state unchanged: %d", charging);
+        return true;
+    }
     SystemStatusPowerConnectState s(charging);
     mSysStatusObsvr.notify({&s});
     return true;
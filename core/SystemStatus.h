@@ -32,11 +32,13 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <vector>
+#include <atomic>
 #include <algorithm>
 #include <iterator>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <MsgTask.h>
+#include <LocRingBuffer.h>
 #include <IDataItemCore.h>
 #include <IOsObserver.h>
 #include <DataItemConcreteTypesBase.h>
@@ -826,54 +828,68 @@ public:
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
-class SystemStatusReports
+// Depth of the history kept for one kind of item, see SystemStatusItemBase::maxItem.
+// An item type may shadow maxItem to keep a longer or shorter history.
+template <typename TYPE_ITEM>
+using SystemStatusRing = loc_util::LocRingBuffer<TYPE_ITEM, TYPE_ITEM::maxItem>;
+
+template <typename TYPE_ITEM>
+using SystemStatusVector = std::vector<TYPE_ITEM>;
+
+template <template <typename> class HISTORY>
+class SystemStatusReportsBase
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    HISTORY<SystemStatusLocation>        mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    HISTORY<SystemStatusTimeAndClock>    mTimeAndClock;
+    HISTORY<SystemStatusXoState>         mXoState;
+    HISTORY<SystemStatusRfAndParams>     mRfAndParams;
+    HISTORY<SystemStatusErrRecovery>     mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    HISTORY<SystemStatusInjectedPosition> mInjectedPosition;
+    HISTORY<SystemStatusBestPosition>    mBestPosition;
+    HISTORY<SystemStatusXtra>            mXtra;
+    HISTORY<SystemStatusEphemeris>       mEphemeris;
+    HISTORY<SystemStatusSvHealth>        mSvHealth;
+    HISTORY<SystemStatusPdr>             mPdr;
+    HISTORY<SystemStatusNavData>         mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    HISTORY<SystemStatusPositionFailure> mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusAirplaneMode>     mAirplaneMode;
-    std::vector<SystemStatusENH>              mENH;
-    std::vector<SystemStatusGpsState>         mGPSState;
-    std::vector<SystemStatusNLPStatus>        mNLPStatus;
-    std::vector<SystemStatusWifiHardwareState> mWifiHardwareState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusServiceInfo>      mRilServiceInfo;
-    std::vector<SystemStatusRilCellInfo>      mRilCellInfo;
-    std::vector<SystemStatusServiceStatus>    mServiceStatus;
-    std::vector<SystemStatusModel>            mModel;
-    std::vector<SystemStatusManufacturer>     mManufacturer;
-    std::vector<SystemStatusAssistedGps>      mAssistedGps;
-    std::vector<SystemStatusScreenState>      mScreenState;
-    std::vector<SystemStatusPowerConnectState> mPowerConnectState;
-    std::vector<SystemStatusTimeZoneChange>   mTimeZoneChange;
-    std::vector<SystemStatusTimeChange>       mTimeChange;
-    std::vector<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
-    std::vector<SystemStatusShutdownState>    mShutdownState;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
-    std::vector<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
-    std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
-};
+    HISTORY<SystemStatusAirplaneMode>    mAirplaneMode;
+    HISTORY<SystemStatusENH>             mENH;
+    HISTORY<SystemStatusGpsState>        mGPSState;
+    HISTORY<SystemStatusNLPStatus>       mNLPStatus;
+    HISTORY<SystemStatusWifiHardwareState> mWifiHardwareState;
+    HISTORY<SystemStatusNetworkInfo>     mNetworkInfo;
+    HISTORY<SystemStatusServiceInfo>     mRilServiceInfo;
+    HISTORY<SystemStatusRilCellInfo>     mRilCellInfo;
+    HISTORY<SystemStatusServiceStatus>   mServiceStatus;
+    HISTORY<SystemStatusModel>           mModel;
+    HISTORY<SystemStatusManufacturer>    mManufacturer;
+    HISTORY<SystemStatusAssistedGps>     mAssistedGps;
+    HISTORY<SystemStatusScreenState>     mScreenState;
+    HISTORY<SystemStatusPowerConnectState> mPowerConnectState;
+    HISTORY<SystemStatusTimeZoneChange>  mTimeZoneChange;
+    HISTORY<SystemStatusTimeChange>      mTimeChange;
+    HISTORY<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
+    HISTORY<SystemStatusShutdownState>   mShutdownState;
+    HISTORY<SystemStatusTac>             mTac;
+    HISTORY<SystemStatusMccMnc>          mMccMnc;
+    HISTORY<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
+    HISTORY<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+};
+
+// what getReport() hands out to clients
+typedef SystemStatusReportsBase<SystemStatusVector> SystemStatusReports;
+// what SystemStatus keeps internally, bounded and updated in place
+typedef SystemStatusReportsBase<SystemStatusRing> SystemStatusHistory;
 
 /******************************************************************************
  SystemStatus
@@ -883,14 +899,28 @@ class SystemStatus
 private:
     static SystemStatus                       *mInstance;
     SystemStatusOsObserver                    mSysStatusObsvr;
+    // last charging state passed to mSysStatusObsvr, -1 before the first one
+    std::atomic<int>                          mPowerConnectState;
     // ctor
     SystemStatus(const MsgTask* msgTask);
     // dtor
-    inline ~SystemStatus() {}
+    ~SystemStatus();
 
     // Data members
     static pthread_mutex_t                    mMutexSystemStatus;
-    SystemStatusReports mCache;
+    SystemStatusHistory mCache;
+
+    // mCache is guarded per report source rather than by one mutex, so the
+    // position, engine NMEA and OS dataitem writers, which run on different
+    // threads, never wait on each other and a reader only holds up the
+    // source it is copying at that moment.
+    enum ReportLock {
+        REPORT_LOCK_POSITION = 0,   // mLocation
+        REPORT_LOCK_NMEA,           // ME, PE and SM debug NMEA reports
+        REPORT_LOCK_DATAITEM,       // reports from the dataitems observer
+        REPORT_LOCK_MAX
+    };
+    mutable pthread_rwlock_t                  mReportLocks[REPORT_LOCK_MAX];
 
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     bool setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s);
@@ -900,7 +930,7 @@ private:
     void setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s);
 
     template <typename TYPE_REPORT, typename TYPE_ITEM>
-    void getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const;
+    void getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c, bool isLatestOnly) const;
 
 public:
     // Static methods
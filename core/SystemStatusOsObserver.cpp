@@ -36,27 +36,41 @@
 
 namespace loc_core
 {
-template <typename CINT, typename COUT>
-COUT SystemStatusOsObserver::containerTransfer(CINT& inContainer) {
-    COUT outContainer = {};
-    for (auto item : inContainer) {
-        outContainer.insert(outContainer.begin(), item);
+DataItemIdMask dataItemIdMask(const list<DataItemId>& l) {
+    DataItemIdMask mask = 0;
+    for (auto id : l) {
+        mask |= dataItemIdBit(id);
     }
-    return outContainer;
+    return mask;
 }
 
-SystemStatusOsObserver::~SystemStatusOsObserver() {
-    // Close data-item library handle
-    DataItemsFactoryProxy::closeDataItemLibraryHandle();
+list<DataItemId> dataItemIdList(DataItemIdMask mask) {
+    list<DataItemId> l;
+    forEachDataItemId(mask, [&l](DataItemId id) { l.push_back(id); });
+    return l;
+}
 
-    // Destroy cache
-    for (auto each : mDataItemCache) {
-        if (nullptr != each.second) {
-            delete each.second;
+SystemStatusOsObserver::~SystemStatusOsObserver() {
+    // Destroy cache and spare items while the data-item library that
+    // implements them is still loaded
+    for (auto& each : mDataItemCache) {
+        if (nullptr != each) {
+            delete each;
+            each = nullptr;
+        }
+    }
+    for (auto& spares : mSpareDataItems) {
+        for (auto each : spares) {
+            delete each;
         }
+        spares.clear();
     }
+    LOC_LOGd("%u data item updates, %u data item allocations",
+             mDataItemUpdates, mDataItemAllocations);
+    pthread_mutex_destroy(&mSpareDataItemsLock);
 
-    mDataItemCache.clear();
+    // Close data-item library handle
+    DataItemsFactoryProxy::closeDataItemLibraryHandle();
 }
 
 void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscriptionObj)
@@ -70,10 +84,8 @@ void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscript
             LOC_LOGi("SetSubsObj::enter");
             mContext.mSubscriptionObj = mSubsObj;
 
-            if (!mContext.mSSObserver->mDataItemToClients.empty()) {
-                list<DataItemId> dis(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                mContext.mSSObserver->mDataItemToClients.getKeys()));
+            if (0 != mContext.mSSObserver->mSubscribedDataItems) {
+                list<DataItemId> dis(dataItemIdList(mContext.mSSObserver->mSubscribedDataItems));
                 mContext.mSubscriptionObj->subscribe(dis, mContext.mSSObserver);
                 mContext.mSubscriptionObj->requestData(dis, mContext.mSSObserver);
             }
@@ -96,37 +108,33 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
 {
     struct HandleSubscribeReq : public LocMsg {
         inline HandleSubscribeReq(SystemStatusOsObserver* parent,
-                list<DataItemId>& l, IDataItemObserver* client, bool requestData) :
+                const list<DataItemId>& l, IDataItemObserver* client, bool requestData) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)),
+                mDataItems(dataItemIdMask(l)),
                 diItemlist(l),
                 mToRequestData(requestData) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            mParent->mDataItemToClients.add(mDataItemSet, {mClient}, &dataItemsToSubscribe);
-            mParent->mClientToDataItems.add(mClient, mDataItemSet);
+            DataItemIdMask dataItemsToSubscribe = mParent->addDataItems(mClient, mDataItems);
 
-            mParent->sendCachedDataItems(mDataItemSet, mClient);
+            mParent->sendCachedDataItems(mDataItems, mClient);
 
             // Send subscription set to framework
             if (nullptr != mParent->mContext.mSubscriptionObj) {
                 if (mToRequestData) {
                     LOC_LOGD("Request Data sent to framework for the following");
                     mParent->mContext.mSubscriptionObj->requestData(diItemlist, mParent);
-                } else if (!dataItemsToSubscribe.empty()) {
+                } else if (0 != dataItemsToSubscribe) {
                     LOC_LOGD("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToSubscribe)),
-                            mParent);
+                            dataItemIdList(dataItemsToSubscribe), mParent);
                 }
             }
         }
         mutable SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        const unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdMask mDataItems;
         const list<DataItemId> diItemlist;
         bool mToRequestData;
     };
@@ -134,8 +142,7 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
     if (l.empty() || nullptr == client) {
         LOC_LOGw("Data item set is empty or client is nullptr");
     } else {
-        mContext.mMsgTask->sendMsg(
-                new HandleSubscribeReq(this, (list<DataItemId>&)l, client, toRequestData));
+        mContext.mMsgTask->sendMsg(new HandleSubscribeReq(this, l, client, toRequestData));
     }
 }
 
@@ -144,70 +151,52 @@ void SystemStatusOsObserver::updateSubscription(
 {
     struct HandleUpdateSubscriptionReq : public LocMsg {
         HandleUpdateSubscriptionReq(SystemStatusOsObserver* parent,
-                                    list<DataItemId>& l, IDataItemObserver* client) :
-                mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                                    const list<DataItemId>& l, IDataItemObserver* client) :
+                mParent(parent), mClient(client), mDataItems(dataItemIdMask(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
-            unordered_set<IDataItemObserver*> clients({mClient});
-            // below removes clients from all entries keyed with the return of the
-            // mClientToDataItems.update() call. If leaving an empty set of clients as the
-            // result, the entire entry will be removed. dataItemsToUnsubscribe will be
-            // populated to keep the keys of the removed entries.
-            mParent->mDataItemToClients.trimOrRemove(
-                    // this call updates <IDataItemObserver*, DataItemId> map; removes
-                    // the DataItemId's that are not new to the clietn from mDataItemSet;
-                    // and returns a set of mDataItemSet's that are no longer used by client.
-                    // This unused set of mDataItemSet's is passed to trimOrRemove method of
-                    // <DataItemId, IDataItemObserver*> map to remove the client from the
-                    // corresponding entries, and gets a set of the entries that are
-                    // removed from the <DataItemId, IDataItemObserver*> map as a result.
-                    mParent->mClientToDataItems.update(mClient,
-                                                       (unordered_set<DataItemId>&)mDataItemSet),
-                    clients, &dataItemsToUnsubscribe, nullptr);
-            // below adds mClient to <DataItemId, IDataItemObserver*> map, and populates
-            // new keys added to that map, which are DataItemIds to be subscribed.
-            mParent->mDataItemToClients.add(mDataItemSet, clients, &dataItemsToSubscribe);
+            // the client ends up subscribed to exactly mDataItems; only the ids new
+            // to it get the cached values, and ids it dropped are unsubscribed from
+            // the framework once no other client uses them
+            DataItemClient* entry = mParent->findClient(mClient);
+            DataItemIdMask current = (nullptr != entry) ? entry->mDataItems : 0;
+            DataItemIdMask added = mDataItems & ~current;
+            DataItemIdMask dataItemsToUnsubscribe =
+                    mParent->removeDataItems(mClient, current & ~mDataItems);
+            DataItemIdMask dataItemsToSubscribe = mParent->addDataItems(mClient, added);
 
             // Send First Response
-            mParent->sendCachedDataItems(mDataItemSet, mClient);
+            mParent->sendCachedDataItems(added, mClient);
 
             if (nullptr != mParent->mContext.mSubscriptionObj) {
                 // Send subscription set to framework
-                if (!dataItemsToSubscribe.empty()) {
+                if (0 != dataItemsToSubscribe) {
                     LOC_LOGD("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
 
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToSubscribe)),
-                            mParent);
+                            dataItemIdList(dataItemsToSubscribe), mParent);
                 }
 
                 // Send unsubscribe to framework
-                if (!dataItemsToUnsubscribe.empty()) {
+                if (0 != dataItemsToUnsubscribe) {
                     LOC_LOGD("Unsubscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToUnsubscribe);
 
                     mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToUnsubscribe)),
-                            mParent);
+                            dataItemIdList(dataItemsToUnsubscribe), mParent);
                 }
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        DataItemIdMask mDataItems;
     };
 
     if (l.empty() || nullptr == client) {
         LOC_LOGw("Data item set is empty or client is nullptr");
     } else {
-        mContext.mMsgTask->sendMsg(
-                new HandleUpdateSubscriptionReq(this, (list<DataItemId>&)l, client));
+        mContext.mMsgTask->sendMsg(new HandleUpdateSubscriptionReq(this, l, client));
     }
 }
 
@@ -216,39 +205,31 @@ void SystemStatusOsObserver::unsubscribe(
 {
     struct HandleUnsubscribeReq : public LocMsg {
         HandleUnsubscribeReq(SystemStatusOsObserver* parent,
-                list<DataItemId>& l, IDataItemObserver* client) :
-                mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                const list<DataItemId>& l, IDataItemObserver* client) :
+                mParent(parent), mClient(client), mDataItems(dataItemIdMask(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsUnusedByClient = {};
-            unordered_set<IDataItemObserver*> clientToRemove = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
-            mParent->mClientToDataItems.trimOrRemove({mClient}, mDataItemSet,  &clientToRemove,
-                                                     &dataItemsUnusedByClient);
-            mParent->mDataItemToClients.trimOrRemove(dataItemsUnusedByClient, {mClient},
-                                                     &dataItemsToUnsubscribe, nullptr);
-
-            if (nullptr != mParent->mContext.mSubscriptionObj && !dataItemsToUnsubscribe.empty()) {
+            DataItemIdMask dataItemsToUnsubscribe =
+                    mParent->removeDataItems(mClient, mDataItems);
+
+            if (nullptr != mParent->mContext.mSubscriptionObj && 0 != dataItemsToUnsubscribe) {
                 LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
                 mParent->logMe(dataItemsToUnsubscribe);
 
                 // Send unsubscribe to framework
                 mParent->mContext.mSubscriptionObj->unsubscribe(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                  std::move(dataItemsToUnsubscribe)),
-                        mParent);
+                        dataItemIdList(dataItemsToUnsubscribe), mParent);
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        DataItemIdMask mDataItems;
     };
 
     if (l.empty() || nullptr == client) {
         LOC_LOGw("Data item set is empty or client is nullptr");
     } else {
-        mContext.mMsgTask->sendMsg(new HandleUnsubscribeReq(this, (list<DataItemId>&)l, client));
+        mContext.mMsgTask->sendMsg(new HandleUnsubscribeReq(this, l, client));
     }
 }
 
@@ -260,15 +241,13 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
                 mParent(parent), mClient(client) {}
 
         void proc() const {
-            unordered_set<DataItemId> diByClient = mParent->mClientToDataItems.getValSet(mClient);
+            DataItemClient* entry = mParent->findClient(mClient);
 
-            if (!diByClient.empty()) {
-                unordered_set<DataItemId> dataItemsToUnsubscribe;
-                mParent->mClientToDataItems.remove(mClient);
-                mParent->mDataItemToClients.trimOrRemove(diByClient, {mClient},
-                                                         &dataItemsToUnsubscribe, nullptr);
+            if (nullptr != entry) {
+                DataItemIdMask dataItemsToUnsubscribe =
+                        mParent->removeDataItems(mClient, entry->mDataItems);
 
-                if (!dataItemsToUnsubscribe.empty() &&
+                if (0 != dataItemsToUnsubscribe &&
                     nullptr != mParent->mContext.mSubscriptionObj) {
 
                     LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
@@ -276,9 +255,7 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
 
                     // Send unsubscribe to framework
                     mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToUnsubscribe)),
-                            mParent);
+                            dataItemIdList(dataItemsToUnsubscribe), mParent);
                 }
             }
         }
@@ -304,42 +281,29 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
 
         inline virtual ~HandleNotify() {
             for (auto item : mDiVec) {
-                delete item;
+                mParent->releaseDataItem(item);
             }
         }
 
         void proc() const {
-            // Update Cache with received data items and prepare
-            // list of data items to be sent.
-            unordered_set<DataItemId> dataItemIdsToBeSent = {};
+            // Update Cache with received data items and collect the ids
+            // of the ones that changed.
+            DataItemIdMask dataItemIdsToBeSent = 0;
             for (auto item : mDiVec) {
                 if (mParent->updateCache(item)) {
-                    dataItemIdsToBeSent.insert(item->getId());
+                    dataItemIdsToBeSent |= dataItemIdBit(item->getId());
                 }
             }
 
-            // Send data item to all subscribed clients
-            unordered_set<IDataItemObserver*> clientSet = {};
-            for (auto each : dataItemIdsToBeSent) {
-                auto clients = mParent->mDataItemToClients.getValSetPtr(each);
-                if (nullptr != clients) {
-                    clientSet.insert(clients->begin(), clients->end());
-                }
-            }
-
-            for (auto client : clientSet) {
-                unordered_set<DataItemId> dataItemIdsForThisClient(
-                        mParent->mClientToDataItems.getValSet(client));
-                for (auto itr = dataItemIdsForThisClient.begin();
-                        itr != dataItemIdsForThisClient.end(); ) {
-                    if (dataItemIdsToBeSent.find(*itr) == dataItemIdsToBeSent.end()) {
-                        itr = dataItemIdsForThisClient.erase(itr);
-                    } else {
-                        itr++;
+            // Send each subscribed client the changed items it is subscribed to
+            if (0 != dataItemIdsToBeSent) {
+                for (auto& each : mParent->mClients) {
+                    DataItemIdMask dataItemIdsForThisClient =
+                            each.mDataItems & dataItemIdsToBeSent;
+                    if (0 != dataItemIdsForThisClient) {
+                        mParent->sendCachedDataItems(dataItemIdsForThisClient, each.mClient);
                     }
                 }
-
-                mParent->sendCachedDataItems(dataItemIdsForThisClient, client);
             }
         }
         SystemStatusOsObserver* mParent;
@@ -347,19 +311,18 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
     };
 
     if (!dlist.empty()) {
-        vector<IDataItemCore*> dataItemVec(dlist.size());
+        vector<IDataItemCore*> dataItemVec;
+        dataItemVec.reserve(dlist.size());
 
         for (auto each : dlist) {
 
-            IDataItemCore* di = DataItemsFactoryProxy::createNewDataItem(each->getId());
+            // Copy contents into a spare or newly created data item
+            IDataItemCore* di = acquireDataItem(each);
             if (nullptr == di) {
                 LOC_LOGw("Unable to create dataitem:%d", each->getId());
                 continue;
             }
 
-            // Copy contents into the newly created data item
-            di->copy(each);
-
             // add this dataitem if updated from last one
             dataItemVec.push_back(di);
             IF_LOC_LOGD {
@@ -384,14 +347,15 @@ void SystemStatusOsObserver::turnOn(DataItemId dit, int timeOut)
         LOC_LOGE("%s:%d]: Framework action request object is NULL", __func__, __LINE__);
         return;
     }
+    if (!isValidDataItemId(dit)) {
+        LOC_LOGw("Invalid data item:%d", dit);
+        return;
+    }
 
-    // Check if data item exists in mActiveRequestCount
-    DataItemIdToInt::iterator citer = mActiveRequestCount.find(dit);
-    if (citer == mActiveRequestCount.end()) {
-        // Data item not found in map
-        // Add reference count as 1 and add dataitem to map
-        pair<DataItemId, int> cpair(dit, 1);
-        mActiveRequestCount.insert(cpair);
+    // Check if data item is already turned on
+    if (0 == mActiveRequestCount[dit]) {
+        // First request, take the reference and turn the dataitem on
+        mActiveRequestCount[dit] = 1;
         LOC_LOGD("Sending turnOn request");
 
         // Send action turn on to framework
@@ -411,9 +375,9 @@ void SystemStatusOsObserver::turnOn(DataItemId dit, int timeOut)
                 new (nothrow) HandleTurnOnMsg(mContext.mFrameworkActionReqObj, dit, timeOut));
     }
     else {
-        // Found in map, update reference count
-        citer->second++;
-        LOC_LOGD("turnOn - Data item:%d Num_refs:%d", dit, citer->second);
+        // Already on, update reference count
+        mActiveRequestCount[dit]++;
+        LOC_LOGD("turnOn - Data item:%d Num_refs:%d", dit, mActiveRequestCount[dit]);
     }
 }
 
@@ -423,16 +387,18 @@ void SystemStatusOsObserver::turnOff(DataItemId dit)
         LOC_LOGE("%s:%d]: Framework action request object is NULL", __func__, __LINE__);
         return;
     }
+    if (!isValidDataItemId(dit)) {
+        LOC_LOGw("Invalid data item:%d", dit);
+        return;
+    }
 
-    // Check if data item exists in mActiveRequestCount
-    DataItemIdToInt::iterator citer = mActiveRequestCount.find(dit);
-    if (citer != mActiveRequestCount.end()) {
+    // Check if data item is turned on
+    if (mActiveRequestCount[dit] > 0) {
         // found
-        citer->second--;
-        LOC_LOGD("turnOff - Data item:%d Remaining:%d", dit, citer->second);
-        if(citer->second == 0) {
-            // if this was last reference, remove item from map and turn off module
-            mActiveRequestCount.erase(citer);
+        mActiveRequestCount[dit]--;
+        LOC_LOGD("turnOff - Data item:%d Remaining:%d", dit, mActiveRequestCount[dit]);
+        if(mActiveRequestCount[dit] == 0) {
+            // if this was last reference, turn off module
 
             // Send action turn off to framework
             struct HandleTurnOffMsg : public LocMsg {
@@ -527,23 +493,131 @@ bool SystemStatusOsObserver::disconnectBackhaul(const string& clientName)
 /******************************************************************************
  Helpers
 ******************************************************************************/
-void SystemStatusOsObserver::sendCachedDataItems(
-        const unordered_set<DataItemId>& s, IDataItemObserver* to)
+DataItemClient* SystemStatusOsObserver::findClient(IDataItemObserver* client)
+{
+    for (auto& each : mClients) {
+        if (each.mClient == client) {
+            return &each;
+        }
+    }
+    return nullptr;
+}
+
+DataItemIdMask SystemStatusOsObserver::addDataItems(
+        IDataItemObserver* client, DataItemIdMask mask)
+{
+    DataItemClient* entry = findClient(client);
+    if (nullptr == entry) {
+        if (0 == mask) {
+            return 0;
+        }
+        mClients.push_back({client, 0});
+        entry = &mClients.back();
+    }
+
+    DataItemIdMask added = mask & ~entry->mDataItems;
+    entry->mDataItems |= added;
+    forEachDataItemId(added, [this](DataItemId id) { mSubscriberCount[id]++; });
+
+    DataItemIdMask firstSubscribed = added & ~mSubscribedDataItems;
+    mSubscribedDataItems |= firstSubscribed;
+    return firstSubscribed;
+}
+
+DataItemIdMask SystemStatusOsObserver::removeDataItems(
+        IDataItemObserver* client, DataItemIdMask mask)
+{
+    DataItemClient* entry = findClient(client);
+    if (nullptr == entry) {
+        return 0;
+    }
+
+    DataItemIdMask removed = mask & entry->mDataItems;
+    DataItemIdMask lastUnsubscribed = 0;
+    entry->mDataItems &= ~removed;
+    forEachDataItemId(removed, [this, &lastUnsubscribed](DataItemId id) {
+        if (0 == --mSubscriberCount[id]) {
+            lastUnsubscribed |= dataItemIdBit(id);
+        }
+    });
+    mSubscribedDataItems &= ~lastUnsubscribed;
+
+    if (0 == entry->mDataItems) {
+        // order of the clients does not matter, move the last one into the hole
+        *entry = mClients.back();
+        mClients.pop_back();
+    }
+    return lastUnsubscribed;
+}
+
+IDataItemCore* SystemStatusOsObserver::acquireDataItem(IDataItemCore* src)
+{
+    DataItemId id = src->getId();
+    IDataItemCore* di = nullptr;
+
+    pthread_mutex_lock(&mSpareDataItemsLock);
+    mDataItemUpdates++;
+    if (isValidDataItemId(id) && !mSpareDataItems[id].empty()) {
+        di = mSpareDataItems[id].back();
+        mSpareDataItems[id].pop_back();
+    } else {
+        mDataItemAllocations++;
+        LOC_LOGv("DataItem:%d allocated, %u allocations over %u updates",
+                 id, mDataItemAllocations, mDataItemUpdates);
+    }
+    pthread_mutex_unlock(&mSpareDataItemsLock);
+
+    if (nullptr == di) {
+        di = DataItemsFactoryProxy::createNewDataItem(id);
+    }
+    if (nullptr != di) {
+        di->copy(src);
+    }
+    return di;
+}
+
+void SystemStatusOsObserver::releaseDataItem(IDataItemCore* d)
+{
+    if (nullptr == d) {
+        return;
+    }
+    DataItemId id = d->getId();
+    bool kept = false;
+
+    pthread_mutex_lock(&mSpareDataItemsLock);
+    if (isValidDataItemId(id) && mSpareDataItems[id].size() < MAX_SPARE_DATA_ITEMS) {
+        mSpareDataItems[id].push_back(d);
+        kept = true;
+    }
+    pthread_mutex_unlock(&mSpareDataItemsLock);
+
+    if (!kept) {
+        delete d;
+    }
+}
+
+void SystemStatusOsObserver::sendCachedDataItems(DataItemIdMask mask, IDataItemObserver* to)
 {
     if (nullptr == to) {
         LOC_LOGv("client pointer is NULL.");
     } else {
-        string clientName;
-        to->getName(clientName);
         list<IDataItemCore*> dataItems = {};
 
-        for (auto each : s) {
-            auto citer = mDataItemCache.find(each);
-            if (citer != mDataItemCache.end()) {
+        forEachDataItemId(mask, [this, &dataItems](DataItemId id) {
+            IDataItemCore* cached = mDataItemCache[id];
+            if (nullptr != cached) {
+                dataItems.push_front(cached);
+            }
+        });
+
+        // the values are only turned into strings when they will be logged
+        IF_LOC_LOGI {
+            string clientName;
+            to->getName(clientName);
+            for (auto each : dataItems) {
                 string dv;
-                citer->second->stringify(dv);
+                each->stringify(dv);
                 LOC_LOGI("DataItem: %s >> %s", dv.c_str(), clientName.c_str());
-                dataItems.push_front(citer->second);
             }
         }
 
@@ -563,21 +637,21 @@ bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
     // if the return is false, it means that SystemStatus is not
     // handling it, so SystemStatusOsObserver also doesn't.
     // So it has to be true to proceed.
-    if (nullptr != d && mSystemStatus->eventDataItemNotify(d)) {
-        auto citer = mDataItemCache.find(d->getId());
-        if (citer == mDataItemCache.end()) {
+    if (nullptr != d && isValidDataItemId(d->getId()) && mSystemStatus->eventDataItemNotify(d)) {
+        IDataItemCore*& cached = mDataItemCache[d->getId()];
+        if (nullptr == cached) {
             // New data item; not found in cache
             IDataItemCore* dataitem = DataItemsFactoryProxy::createNewDataItem(d->getId());
             if (nullptr != dataitem) {
                 // Copy the contents of the data item
                 dataitem->copy(d);
                 // Insert in mDataItemCache
-                mDataItemCache.insert(std::make_pair(d->getId(), dataitem));
+                cached = dataitem;
                 dataItemUpdated = true;
             }
         } else {
             // Found in cache; Update cache if necessary
-            citer->second->copy(d, &dataItemUpdated);
+            cached->copy(d, &dataItemUpdated);
         }
 
         if (dataItemUpdated) {
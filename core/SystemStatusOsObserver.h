@@ -35,13 +35,13 @@
 #include <map>
 #include <new>
 #include <vector>
+#include <unordered_set>
 
 #include <MsgTask.h>
 #include <DataItemId.h>
 #include <IOsObserver.h>
 #include <loc_pla.h>
 #include <log_util.h>
-#include <LocUnorderedSetMap.h>
 
 namespace loc_core
 {
@@ -56,10 +56,35 @@ class IDataItemCore;
 class SystemStatus;
 class SystemStatusOsObserver;
 typedef map<IDataItemObserver*, list<DataItemId>> ObserverReqCache;
-typedef LocUnorderedSetMap<IDataItemObserver*, DataItemId> ClientToDataItems;
-typedef LocUnorderedSetMap<DataItemId, IDataItemObserver*> DataItemToClients;
-typedef unordered_map<DataItemId, IDataItemCore*> DataItemIdToCore;
-typedef unordered_map<DataItemId, int> DataItemIdToInt;
+
+// DataItemId is a small dense enum, so a set of ids is one bit mask and
+// per id state lives in arrays indexed by the id.
+typedef uint64_t DataItemIdMask;
+static_assert(MAX_DATA_ITEM_ID_1_1 <= 64, "DataItemIdMask is too narrow for DataItemId");
+
+inline bool isValidDataItemId(DataItemId id) {
+    return id > INVALID_DATA_ITEM_ID && id < MAX_DATA_ITEM_ID_1_1;
+}
+inline DataItemIdMask dataItemIdBit(DataItemId id) {
+    return isValidDataItemId(id) ? (1ULL << id) : 0;
+}
+// calls f on every id in mask, lowest id first
+template <typename F>
+inline void forEachDataItemId(DataItemIdMask mask, F f) {
+    while (0 != mask) {
+        f((DataItemId)__builtin_ctzll(mask));
+        mask &= mask - 1;
+    }
+}
+DataItemIdMask dataItemIdMask(const list<DataItemId>& l);
+list<DataItemId> dataItemIdList(DataItemIdMask mask);
+
+// one entry per subscribed client with the ids it is subscribed to
+struct DataItemClient {
+    IDataItemObserver* mClient;
+    DataItemIdMask mDataItems;
+};
+typedef vector<DataItemClient> DataItemClients;
 #ifdef USE_GLIB
 // Cache details of backhaul client requests
 typedef unordered_set<string> ClientBackhaulReqCache;
@@ -86,19 +111,15 @@ public:
     // ctor
     inline SystemStatusOsObserver(SystemStatus* systemstatus, const MsgTask* msgTask) :
             mSystemStatus(systemstatus), mContext(msgTask, this),
-            mAddress("SystemStatusOsObserver"),
-            mClientToDataItems(MAX_DATA_ITEM_ID), mDataItemToClients(MAX_DATA_ITEM_ID) {}
+            mAddress("SystemStatusOsObserver"), mSubscribedDataItems(0),
+            mSubscriberCount(), mDataItemCache(), mActiveRequestCount(),
+            mDataItemUpdates(0), mDataItemAllocations(0) {
+        pthread_mutex_init(&mSpareDataItemsLock, nullptr);
+    }
 
     // dtor
     ~SystemStatusOsObserver();
 
-    template <typename CINT, typename COUT>
-    static COUT containerTransfer(CINT& s);
-    template <typename CINT, typename COUT>
-    inline static COUT containerTransfer(CINT&& s) {
-        return containerTransfer<CINT, COUT>(s);
-    }
-
     // To set the subscription object
     virtual void setSubscriptionObj(IDataItemSubscription* subscriptionObj);
 
@@ -148,10 +169,22 @@ private:
     SystemStatus*                                    mSystemStatus;
     ObserverContext                                  mContext;
     const string                                     mAddress;
-    ClientToDataItems                                mClientToDataItems;
-    DataItemToClients                                mDataItemToClients;
-    DataItemIdToCore                                 mDataItemCache;
-    DataItemIdToInt                                  mActiveRequestCount;
+    DataItemClients                                  mClients;
+    // ids with at least one subscriber, i.e. subscribed with the framework
+    DataItemIdMask                                   mSubscribedDataItems;
+    uint32_t                                         mSubscriberCount[MAX_DATA_ITEM_ID_1_1];
+    IDataItemCore*                                   mDataItemCache[MAX_DATA_ITEM_ID_1_1];
+    int                                              mActiveRequestCount[MAX_DATA_ITEM_ID_1_1];
+
+    // notify() may be called on any thread and passes its copies of the
+    // incoming items on to the msg task. Once handled those copies are kept
+    // here, per DataItemId, and copied into in place on the next update
+    // rather than created through the factory and deleted every time.
+    static const size_t                              MAX_SPARE_DATA_ITEMS = 4;
+    pthread_mutex_t                                  mSpareDataItemsLock;
+    vector<IDataItemCore*>                           mSpareDataItems[MAX_DATA_ITEM_ID_1_1];
+    uint32_t                                         mDataItemUpdates;
+    uint32_t                                         mDataItemAllocations;
 
     // Cache the subscribe and requestData till subscription obj is obtained
     void cacheObserverRequest(ObserverReqCache& reqCache,
@@ -164,13 +197,18 @@ private:
     void subscribe(const list<DataItemId>& l, IDataItemObserver* client, bool toRequestData);
 
     // Helpers
-    void sendCachedDataItems(const unordered_set<DataItemId>& s, IDataItemObserver* to);
+    DataItemClient* findClient(IDataItemObserver* client);
+    // both return the ids whose subscriber count went from 0 to 1 or from 1 to 0,
+    // which are the ones the framework has to be told about
+    DataItemIdMask addDataItems(IDataItemObserver* client, DataItemIdMask mask);
+    DataItemIdMask removeDataItems(IDataItemObserver* client, DataItemIdMask mask);
+    IDataItemCore* acquireDataItem(IDataItemCore* src);
+    void releaseDataItem(IDataItemCore* d);
+    void sendCachedDataItems(DataItemIdMask mask, IDataItemObserver* to);
     bool updateCache(IDataItemCore* d);
-    inline void logMe(const unordered_set<DataItemId>& l) {
+    inline void logMe(DataItemIdMask mask) {
         IF_LOC_LOGD {
-            for (auto id : l) {
-                LOC_LOGD("DataItem %d", id);
-            }
+            forEachDataItemId(mask, [](DataItemId id) { LOC_LOGD("DataItem %d", id); });
         }
     }
 };
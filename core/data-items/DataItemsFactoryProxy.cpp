@@ -71,10 +71,9 @@ IDataItemCore* DataItemsFactoryProxy::createNewDataItem(DataItemId id)
 
 void DataItemsFactoryProxy::closeDataItemLibraryHandle()
 {
-    if (NULL != dataItemLibHandle) {
-        dlclose(dataItemLibHandle);
-        dataItemLibHandle = NULL;
-    }
+    // the library is owned by the plugin registry behind dlGetSymFromLib and
+    // stays loaded, so there is only the handle to forget
+    dataItemLibHandle = NULL;
 }
 
 } // namespace loc_core
@@ -31,17 +31,51 @@
 #include <GeofenceAdapter.h>
 #include "loc_log.h"
 #include <log_util.h>
+#include <loc_cfg.h>
+#include <loc_pla.h>
+#include <LocWorkAccounting.h>
+#include <algorithm>
+#include <math.h>
+#include <memory>
 #include <string>
 
+#define GEOFENCE_RESIDENCY_HYSTERESIS_METERS_DEFAULT 200
+#define GEOFENCE_RESIDENCY_UPDATE_METERS_DEFAULT     500
+#define GEOFENCE_RESIDENCY_SWAP_TIMEOUT_MSEC_DEFAULT 10000
+#define GEOFENCE_RESIDENCY_POSITION_TIMEOUT_SEC_DEFAULT 600
+
 using namespace loc_core;
 
 GeofenceAdapter::GeofenceAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
-                   true /*isMaster*/, nullptr, true)
+                   true /*isMaster*/, nullptr, true,
+                   LocContext::getAdapterMsgTask(LocContext::mGeofenceWorkerName)),
+    mReplayPending(false),
+    mResidentMax(0),
+    mResidencyHysteresisMeters(GEOFENCE_RESIDENCY_HYSTERESIS_METERS_DEFAULT),
+    mResidencyUpdateMeters(GEOFENCE_RESIDENCY_UPDATE_METERS_DEFAULT),
+    mResidencySwapTimeoutMs(GEOFENCE_RESIDENCY_SWAP_TIMEOUT_MSEC_DEFAULT),
+    mResidencyPositionTimeoutMs(GEOFENCE_RESIDENCY_POSITION_TIMEOUT_SEC_DEFAULT * 1000),
+    mParkedIndexIdCounter(0),
+    mPendingResidentAdds(0),
+    mResidencySwapInsInFlight(0),
+    mResidencySwapsInFlight(0),
+    mResidencyEpoch(0),
+    mEngineUpCount(0),
+    mResidencySwapRoundTime(0),
+    mResidencyPositionTime(0),
+    mResidencySwapTimer(this),
+    mResidencyPositionTimer(this),
+    mResidencyPositionValid(false),
+    mResidencyLatitude(0),
+    mResidencyLongitude(0),
+    mResidencyStats{}
 {
     LOC_LOGD("%s]: Constructor", __func__);
 
+    readResidencyConfig();
+
     // at last step, let us inform adapater base that we are done
     // with initialization, e.g.: ready to process handleEngineUpEvent
     doneInit();
@@ -58,13 +92,23 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
         GeofenceKey key(it->first);
         if (client == key.client) {
             it = mGeofenceIds.erase(it);
+            if (mReplayPending) {
+                // not in the engine since it restarted, and no longer replayed
+                mGeofences.erase(hwId);
+                mSpatialIndex.remove(hwId);
+                mGeofenceRoutes.erase(hwId);
+                continue;
+            }
             mLocApi->removeGeofence(hwId, key.id,
-                    new LocApiResponse(*getContext(),
+                    new LocApiResponse(*getMsgTask(),
                     [this, hwId] (LocationError err) {
                 if (LOCATION_ERROR_SUCCESS == err) {
                     auto it2 = mGeofences.find(hwId);
                     if (it2 != mGeofences.end()) {
                         mGeofences.erase(it2);
+                        mSpatialIndex.remove(hwId);
+                        mGeofenceRoutes.erase(hwId);
+                        mSwappedInInside.erase(hwId);
                     } else {
                         LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
                     }
@@ -75,6 +119,16 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
         ++it; // increment only when not erasing an iterator
     }
 
+    for (auto it = mParkedGeofences.begin(); it != mParkedGeofences.end();) {
+        if (client == it->first.client) {
+            mParkedIndex.remove(it->second.indexId);
+            mParkedIndexKeys.erase(it->second.indexId);
+            mParkedInside.erase(it->first);
+            it = mParkedGeofences.erase(it);
+            continue;
+        }
+        ++it;
+    }
 }
 
 void
@@ -108,9 +162,9 @@ GeofenceAdapter::getHwIdFromClient(LocationAPI* client, uint32_t clientId, uint3
 LocationError
 GeofenceAdapter::getGeofenceKeyFromHwId(uint32_t hwId, GeofenceKey& key)
 {
-    auto it = mGeofences.find(hwId);
-    if (it != mGeofences.end()) {
-        key = it->second.key;
+    auto it = mGeofenceRoutes.find(hwId);
+    if (it != mGeofenceRoutes.end()) {
+        key = it->second;
         return LOCATION_ERROR_SUCCESS;
     }
     return LOCATION_ERROR_ID_UNKNOWN;
@@ -135,19 +189,35 @@ GeofenceAdapter::handleEngineUpEvent()
         }
     };
 
+    mLocApi->getEngineStateSnapshot().expect(ENGINE_REPLAY_PRIORITY_GEOFENCE);
     sendMsg(new MsgSSREvent(*this));
 }
 
 void
 GeofenceAdapter::restartGeofences()
 {
-    if (mGeofences.empty()) {
-        return;
-    }
+    // residency swaps in flight went down with the engine, their responses may never come
+    mEngineUpCount++;
+    resetResidencySwaps();
+    mSwappedInInside.clear();
+
+    // the adds are replayed by the engine state snapshot on this thread, after tracking
+    // is restarted; until then the fences are kept and the client commands wait, as the
+    // hwIds they would use are gone with the engine
+    mReplayPending = true;
+    mLocApi->getEngineStateSnapshot().submit(ENGINE_REPLAY_PRIORITY_GEOFENCE, *getMsgTask(),
+                                             {[this] () { replayGeofences(); }});
+}
 
-    GeofencesMap oldGeofences(mGeofences);
-    mGeofences.clear();
+void
+GeofenceAdapter::replayGeofences()
+{
+    GeofencesMap oldGeofences;
+    oldGeofences.swap(mGeofences);
     mGeofenceIds.clear();
+    mSpatialIndex.clear();
+    mGeofenceRoutes.clear();
+    mReplayPending = false;
 
     for (auto it = oldGeofences.begin(); it != oldGeofences.end(); it++) {
         GeofenceObject object = it->second;
@@ -162,17 +232,28 @@ GeofenceAdapter::restartGeofences()
         mLocApi->addGeofence(object.key.id,
                               options,
                               info,
-                              new LocApiResponseData<LocApiGeofenceData>(*getContext(),
+                              new LocApiResponseData<LocApiGeofenceData>(*getMsgTask(),
                 [this, object, options, info] (LocationError err, LocApiGeofenceData data) {
             if (LOCATION_ERROR_SUCCESS == err) {
                 if (true == object.paused) {
                     mLocApi->pauseGeofence(data.hwId, object.key.id,
-                            new LocApiResponse(*getContext(), [] (LocationError err ) {}));
+                            new LocApiResponse(*getMsgTask(), [] (LocationError err ) {}));
                 }
                 saveGeofenceItem(object.key.client, object.key.id, data.hwId, options, info);
+                if (true == object.paused) {
+                    pauseGeofenceItem(data.hwId);
+                }
             }
         }));
     }
+    LOC_LOGD("%s]: replayed %zu geofences, releasing %zu commands",
+             __func__, oldGeofences.size(), mPendingMsgs.size());
+
+    // the adds above are queued to the LocApi ahead of the held commands
+    for (auto msg: mPendingMsgs) {
+        sendMsg(msg);
+    }
+    mPendingMsgs.clear();
 }
 
 void
@@ -233,24 +314,49 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
             mOptions(options),
             mInfos(infos) {}
         inline virtual void proc() const {
+            if (mAdapter.isReplayPending()) {
+                mAdapter.mPendingMsgs.push_back(new MsgAddGeofences(*this));
+                return;
+            }
             LocationError* errs = new LocationError[mCount];
             if (nullptr == errs) {
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            // items complete out of order, parked ones right away and resident ones
+            // when the engine responds; the response goes out with the last of them
+            std::shared_ptr<size_t> remaining = std::make_shared<size_t>(mCount);
             for (size_t i=0; i < mCount; ++i) {
                 if (NULL == mIds || NULL == mOptions || NULL == mInfos) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
                 } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
                             mOptions = mOptions, mInfos = mInfos, mIds = mIds, &mApi = mApi,
-                            errs, i] (LocationError err ) {
+                            errs, remaining, i] (LocationError err ) {
+                        // no free modem slot, keep the fence on AP until it is near enough
+                        if (mAdapter.isResidencyFull()) {
+                            mAdapter.parkGeofenceItem(mClient, mIds[i], mOptions[i], mInfos[i],
+                                                      false);
+                            errs[i] = LOCATION_ERROR_SUCCESS;
+
+                            // Send aggregated response on last item and cleanup
+                            if (0 == --(*remaining)) {
+                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                                delete[] errs;
+                                delete[] mIds;
+                                delete[] mOptions;
+                                delete[] mInfos;
+                            }
+                            return;
+                        }
+                        mAdapter.addPendingResidentAdd();
                         mApi.addGeofence(mIds[i], mOptions[i], mInfos[i],
-                        new LocApiResponseData<LocApiGeofenceData>(*mAdapter.getContext(),
+                        new LocApiResponseData<LocApiGeofenceData>(*mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mOptions = mOptions, mClient = mClient,
-                        mCount = mCount, mIds = mIds, mInfos = mInfos, errs, i]
+                        mCount = mCount, mIds = mIds, mInfos = mInfos, errs, remaining, i]
                         (LocationError err, LocApiGeofenceData data) {
+                            mAdapter.removePendingResidentAdd();
                             if (LOCATION_ERROR_SUCCESS == err) {
                                 mAdapter.saveGeofenceItem(mClient,
                                 mIds[i],
@@ -261,7 +367,7 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
                             errs[i] = err;
 
                             // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
+                            if (0 == --(*remaining)) {
                                 mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                 delete[] errs;
                                 delete[] mIds;
@@ -338,29 +444,46 @@ GeofenceAdapter::removeGeofencesCommand(LocationAPI* client, size_t count, uint3
             mCount(count),
             mIds(ids) {}
         inline virtual void proc() const  {
+            if (mAdapter.isReplayPending()) {
+                mAdapter.mPendingMsgs.push_back(new MsgRemoveGeofences(*this));
+                return;
+            }
             LocationError* errs = new LocationError[mCount];
             if (nullptr == errs) {
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            std::shared_ptr<size_t> remaining = std::make_shared<size_t>(mCount);
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
+                        &mApi = mApi, errs, remaining, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
+                    if (LOCATION_ERROR_SUCCESS != errs[i] &&
+                            mAdapter.removeParkedGeofenceItem(mClient, mIds[i])) {
+                        errs[i] = LOCATION_ERROR_SUCCESS;
+                        // Send aggregated response on last item and cleanup
+                        if (0 == --(*remaining)) {
+                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                            delete[] errs;
+                            delete[] mIds;
+                        }
+                    } else if (LOCATION_ERROR_SUCCESS == errs[i]) {
                         mApi.removeGeofence(hwId, mIds[i],
-                        new LocApiResponse(*mAdapter.getContext(),
+                        new LocApiResponse(*mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
+                        hwId, errs, remaining, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
                                 mAdapter.removeGeofenceItem(hwId);
+                            } else if (mAdapter.removeParkedGeofenceItem(mClient, mIds[i])) {
+                                // swapped out while the remove was queued
+                                err = LOCATION_ERROR_SUCCESS;
                             }
                             errs[i] = err;
 
                             // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
+                            if (0 == --(*remaining)) {
                                 mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                 delete[] errs;
                                 delete[] mIds;
@@ -368,7 +491,7 @@ GeofenceAdapter::removeGeofencesCommand(LocationAPI* client, size_t count, uint3
                         }));
                     } else {
                         // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
+                        if (0 == --(*remaining)) {
                             mAdapter.reportResponse(mClient, mCount, errs, mIds);
                             delete[] errs;
                             delete[] mIds;
@@ -414,28 +537,44 @@ GeofenceAdapter::pauseGeofencesCommand(LocationAPI* client, size_t count, uint32
             mCount(count),
             mIds(ids) {}
         inline virtual void proc() const  {
+            if (mAdapter.isReplayPending()) {
+                mAdapter.mPendingMsgs.push_back(new MsgPauseGeofences(*this));
+                return;
+            }
             LocationError* errs = new LocationError[mCount];
             if (nullptr == errs) {
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            std::shared_ptr<size_t> remaining = std::make_shared<size_t>(mCount);
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
+                        &mApi = mApi, errs, remaining, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.pauseGeofence(hwId, mIds[i], new LocApiResponse(*mAdapter.getContext(),
+                    if (LOCATION_ERROR_SUCCESS != errs[i] &&
+                            mAdapter.pauseParkedGeofenceItem(mClient, mIds[i], true)) {
+                        errs[i] = LOCATION_ERROR_SUCCESS;
+                        // Send aggregated response on last item and cleanup
+                        if (0 == --(*remaining)) {
+                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                            delete[] errs;
+                            delete[] mIds;
+                        }
+                    } else if (LOCATION_ERROR_SUCCESS == errs[i]) {
+                        mApi.pauseGeofence(hwId, mIds[i], new LocApiResponse(*mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
+                        hwId, errs, remaining, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
                                 mAdapter.pauseGeofenceItem(hwId);
+                            } else if (mAdapter.pauseParkedGeofenceItem(mClient, mIds[i], true)) {
+                                err = LOCATION_ERROR_SUCCESS;
                             }
                             errs[i] = err;
 
                             // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
+                            if (0 == --(*remaining)) {
                                 mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                 delete[] errs;
                                 delete[] mIds;
@@ -443,7 +582,7 @@ GeofenceAdapter::pauseGeofencesCommand(LocationAPI* client, size_t count, uint32
                         }));
                     } else {
                         // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
+                        if (0 == --(*remaining)) {
                             mAdapter.reportResponse(mClient, mCount, errs, mIds);
                             delete[] errs;
                             delete[] mIds;
@@ -489,28 +628,47 @@ GeofenceAdapter::resumeGeofencesCommand(LocationAPI* client, size_t count, uint3
             mCount(count),
             mIds(ids) {}
         inline virtual void proc() const  {
+            if (mAdapter.isReplayPending()) {
+                mAdapter.mPendingMsgs.push_back(new MsgResumeGeofences(*this));
+                return;
+            }
             LocationError* errs = new LocationError[mCount];
             if (nullptr == errs) {
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            std::shared_ptr<size_t> remaining = std::make_shared<size_t>(mCount);
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
+                        &mApi = mApi, errs, remaining, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
+                    if (LOCATION_ERROR_SUCCESS != errs[i] &&
+                            mAdapter.pauseParkedGeofenceItem(mClient, mIds[i], false)) {
+                        errs[i] = LOCATION_ERROR_SUCCESS;
+                        // Send aggregated response on last item and cleanup
+                        if (0 == --(*remaining)) {
+                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                            delete[] errs;
+                            delete[] mIds;
+                        }
+                    } else if (LOCATION_ERROR_SUCCESS == errs[i]) {
                         mApi.resumeGeofence(hwId, mIds[i],
-                                new LocApiResponse(*mAdapter.getContext(),
+                                new LocApiResponse(*mAdapter.getMsgTask(),
                                 [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, hwId,
-                                errs, mIds = mIds, i] (LocationError err ) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                errs[i] = err;
-
+                                errs, remaining, mIds = mIds, i] (LocationError err ) {
+                            bool resumed = (LOCATION_ERROR_SUCCESS == err);
+                            if (!resumed) {
+                                resumed = mAdapter.pauseParkedGeofenceItem(mClient, mIds[i], false);
+                            } else {
                                 mAdapter.resumeGeofenceItem(hwId);
+                            }
+                            if (resumed) {
+                                errs[i] = LOCATION_ERROR_SUCCESS;
+
                                 // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
+                                if (0 == --(*remaining)) {
                                     mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                     delete[] errs;
                                     delete[] mIds;
@@ -519,7 +677,7 @@ GeofenceAdapter::resumeGeofencesCommand(LocationAPI* client, size_t count, uint3
                         }));
                     } else {
                         // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
+                        if (0 == --(*remaining)) {
                             mAdapter.reportResponse(mClient, mCount, errs, mIds);
                             delete[] errs;
                             delete[] mIds;
@@ -569,33 +727,52 @@ GeofenceAdapter::modifyGeofencesCommand(LocationAPI* client, size_t count, uint3
             mIds(ids),
             mOptions(options) {}
         inline virtual void proc() const  {
+            if (mAdapter.isReplayPending()) {
+                mAdapter.mPendingMsgs.push_back(new MsgModifyGeofences(*this));
+                return;
+            }
             LocationError* errs = new LocationError[mCount];
             if (nullptr == errs) {
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            std::shared_ptr<size_t> remaining = std::make_shared<size_t>(mCount);
             for (size_t i=0; i < mCount; ++i) {
                 if (NULL == mIds || NULL == mOptions) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
                 } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                            &mApi = mApi, mOptions = mOptions, errs, i] (LocationError err ) {
+                            &mApi = mApi, mOptions = mOptions, errs, remaining, i]
+                            (LocationError err ) {
                         uint32_t hwId = 0;
                         errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                        if (LOCATION_ERROR_SUCCESS == errs[i]) {
+                        if (LOCATION_ERROR_SUCCESS != errs[i] &&
+                                mAdapter.modifyParkedGeofenceItem(mClient, mIds[i], mOptions[i])) {
+                            errs[i] = LOCATION_ERROR_SUCCESS;
+                            // Send aggregated response on last item and cleanup
+                            if (0 == --(*remaining)) {
+                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                                delete[] errs;
+                                delete[] mIds;
+                                delete[] mOptions;
+                            }
+                        } else if (LOCATION_ERROR_SUCCESS == errs[i]) {
                             mApi.modifyGeofence(hwId, mIds[i], mOptions[i],
-                                    new LocApiResponse(*mAdapter.getContext(),
+                                    new LocApiResponse(*mAdapter.getMsgTask(),
                                     [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
-                                    mIds = mIds, mOptions = mOptions, hwId, errs, i]
+                                    mIds = mIds, mOptions = mOptions, hwId, errs, remaining, i]
                                     (LocationError err ) {
                                 if (LOCATION_ERROR_SUCCESS == err) {
                                     errs[i] = err;
 
                                     mAdapter.modifyGeofenceItem(hwId, mOptions[i]);
+                                } else if (mAdapter.modifyParkedGeofenceItem(mClient, mIds[i],
+                                                                             mOptions[i])) {
+                                    errs[i] = LOCATION_ERROR_SUCCESS;
                                 }
                                 // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
+                                if (0 == --(*remaining)) {
                                     mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                     delete[] errs;
                                     delete[] mIds;
@@ -604,7 +781,7 @@ GeofenceAdapter::modifyGeofencesCommand(LocationAPI* client, size_t count, uint3
                             }));
                         } else {
                             // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
+                            if (0 == --(*remaining)) {
                                 mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                 delete[] errs;
                                 delete[] mIds;
@@ -657,6 +834,8 @@ GeofenceAdapter::saveGeofenceItem(LocationAPI* client, uint32_t clientId, uint32
                              false};
     mGeofences[hwId] = object;
     mGeofenceIds[key] = hwId;
+    mSpatialIndex.insert(hwId, info.latitude, info.longitude, info.radius);
+    mGeofenceRoutes[hwId] = key;
     dump();
 }
 
@@ -675,6 +854,9 @@ GeofenceAdapter::removeGeofenceItem(uint32_t hwId)
             auto it2 = mGeofences.find(hwId);
             if (it2 != mGeofences.end()) {
                 mGeofences.erase(it2);
+                mSpatialIndex.remove(hwId);
+                mGeofenceRoutes.erase(hwId);
+                mSwappedInInside.erase(hwId);
                 dump();
             } else {
                 LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
@@ -691,6 +873,7 @@ GeofenceAdapter::pauseGeofenceItem(uint32_t hwId)
     auto it = mGeofences.find(hwId);
     if (it != mGeofences.end()) {
         it->second.paused = true;
+        mSwappedInInside.erase(hwId);
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to pause not found. hwId %u", __func__, hwId);
@@ -723,6 +906,596 @@ GeofenceAdapter::modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options
     }
 }
 
+void
+GeofenceAdapter::readResidencyConfig()
+{
+    uint32_t residentMax = 0;
+    uint32_t hysteresisMeters = GEOFENCE_RESIDENCY_HYSTERESIS_METERS_DEFAULT;
+    uint32_t updateMeters = GEOFENCE_RESIDENCY_UPDATE_METERS_DEFAULT;
+    uint32_t swapTimeoutMsec = GEOFENCE_RESIDENCY_SWAP_TIMEOUT_MSEC_DEFAULT;
+    uint32_t positionTimeoutSec = GEOFENCE_RESIDENCY_POSITION_TIMEOUT_SEC_DEFAULT;
+    const loc_param_s_type gps_conf_param_table[] =
+    {
+        {"GEOFENCE_RESIDENT_MAX", &residentMax, NULL, 'n'},
+        {"GEOFENCE_RESIDENCY_HYSTERESIS_METERS", &hysteresisMeters, NULL, 'n'},
+        {"GEOFENCE_RESIDENCY_UPDATE_METERS", &updateMeters, NULL, 'n'},
+        {"GEOFENCE_RESIDENCY_SWAP_TIMEOUT_MSEC", &swapTimeoutMsec, NULL, 'n'},
+        {"GEOFENCE_RESIDENCY_POSITION_TIMEOUT_SEC", &positionTimeoutSec, NULL, 'n'},
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, gps_conf_param_table);
+
+    mResidentMax = residentMax;
+    mResidencyHysteresisMeters = hysteresisMeters;
+    mResidencyUpdateMeters = updateMeters;
+    // a swap round is always given up on eventually, or one lost response stops residency
+    mResidencySwapTimeoutMs = (0 == swapTimeoutMsec) ?
+            GEOFENCE_RESIDENCY_SWAP_TIMEOUT_MSEC_DEFAULT : swapTimeoutMsec;
+    mResidencyPositionTimeoutMs = positionTimeoutSec * 1000;
+    LOC_LOGD("%s]: residentMax %u hysteresisMeters %u updateMeters %u "
+             "swapTimeoutMs %u positionTimeoutMs %u",
+             __func__, mResidentMax, mResidencyHysteresisMeters, mResidencyUpdateMeters,
+             mResidencySwapTimeoutMs, mResidencyPositionTimeoutMs);
+}
+
+void
+GeofenceAdapter::parkGeofenceItem(LocationAPI* client, uint32_t clientId,
+        const GeofenceOption& options, const GeofenceInfo& info, bool paused)
+{
+    GeofenceObject object = {GeofenceKey(client, clientId),
+                             options.breachTypeMask,
+                             options.responsiveness,
+                             options.dwellTime,
+                             info.latitude,
+                             info.longitude,
+                             info.radius,
+                             paused};
+    parkGeofenceObject(object);
+}
+
+void
+GeofenceAdapter::parkGeofenceObject(const GeofenceObject& object)
+{
+    LOC_LOGD("%s]: client %p clientId %u parked, %zu resident",
+             __func__, object.key.client, object.key.id, mGeofences.size());
+    auto it = mParkedGeofences.find(object.key);
+    if (it != mParkedGeofences.end()) {
+        it->second.object = object;
+        return;
+    }
+    uint32_t indexId = ++mParkedIndexIdCounter;
+    mParkedGeofences[object.key] = {object, indexId, false};
+    mParkedIndexKeys[indexId] = object.key;
+    mParkedIndex.insert(indexId, object.latitude, object.longitude, object.radius);
+    if (0 != mResidencyPositionTimeoutMs) {
+        // no-op while armed
+        mResidencyPositionTimer.start(mResidencyPositionTimeoutMs, false);
+    }
+}
+
+bool
+GeofenceAdapter::removeParkedGeofenceItem(LocationAPI* client, uint32_t clientId)
+{
+    auto it = mParkedGeofences.find(GeofenceKey(client, clientId));
+    if (it == mParkedGeofences.end()) {
+        return false;
+    }
+    mParkedIndex.remove(it->second.indexId);
+    mParkedIndexKeys.erase(it->second.indexId);
+    mParkedInside.erase(it->first);
+    mParkedGeofences.erase(it);
+    return true;
+}
+
+bool
+GeofenceAdapter::pauseParkedGeofenceItem(LocationAPI* client, uint32_t clientId, bool paused)
+{
+    auto it = mParkedGeofences.find(GeofenceKey(client, clientId));
+    if (it == mParkedGeofences.end()) {
+        return false;
+    }
+    it->second.object.paused = paused;
+    if (paused) {
+        // a resumed fence reports ENTER again if the device is still inside
+        it->second.inside = false;
+        mParkedInside.erase(it->first);
+    }
+    return true;
+}
+
+bool
+GeofenceAdapter::modifyParkedGeofenceItem(LocationAPI* client, uint32_t clientId,
+        const GeofenceOption& options)
+{
+    auto it = mParkedGeofences.find(GeofenceKey(client, clientId));
+    if (it == mParkedGeofences.end()) {
+        return false;
+    }
+    it->second.object.breachMask = options.breachTypeMask;
+    it->second.object.responsiveness = options.responsiveness;
+    it->second.object.dwellTime = options.dwellTime;
+    return true;
+}
+
+void
+GeofenceAdapter::reportPositionEvent(const UlpLocation& location,
+                                     const GpsLocationExtended& locationExtended,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask loc_technology_mask,
+                                     GnssDataNotification* pDataNotify,
+                                     int msInWeek)
+{
+    LocAdapterBase::reportPositionEvent(location, locationExtended, status,
+                                        loc_technology_mask, pDataNotify, msInWeek);
+
+    // mResidentMax is only written in the constructor
+    if (0 == mResidentMax || LOC_SESS_FAILURE == status ||
+            !(location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)) {
+        return;
+    }
+
+    struct MsgUpdateResidency : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        Location mLocation;
+        inline MsgUpdateResidency(GeofenceAdapter& adapter,
+                                  const Location& location) :
+            LocMsg(),
+            mAdapter(adapter),
+            mLocation(location) {}
+        inline virtual void proc() const {
+            mAdapter.updateResidency(mLocation);
+        }
+    };
+
+    Location residencyLocation;
+    memset(&residencyLocation, 0, sizeof(Location));
+    residencyLocation.size = sizeof(Location);
+    residencyLocation.flags = LOCATION_HAS_LAT_LONG_BIT;
+    residencyLocation.timestamp = location.gpsLocation.timestamp;
+    residencyLocation.latitude = location.gpsLocation.latitude;
+    residencyLocation.longitude = location.gpsLocation.longitude;
+    if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ACCURACY) {
+        residencyLocation.flags |= LOCATION_HAS_ACCURACY_BIT;
+        residencyLocation.accuracy = location.gpsLocation.accuracy;
+    }
+    sendMsg(new MsgUpdateResidency(*this, residencyLocation));
+}
+
+bool
+GeofenceAdapter::reportParkedBreaches(const Location& location)
+{
+    bool contained = false;
+
+    // exits, the set is small: only fences the device is in
+    mBreachKeys.clear();
+    for (auto it = mParkedInside.begin(); it != mParkedInside.end();) {
+        auto itParked = mParkedGeofences.find(*it);
+        if (itParked == mParkedGeofences.end()) {
+            it = mParkedInside.erase(it);
+            continue;
+        }
+        const GeofenceObject& object = itParked->second.object;
+        if (GeofenceSpatialIndex::distanceToFence(location.latitude, location.longitude,
+                object.latitude, object.longitude, object.radius) > 0) {
+            itParked->second.inside = false;
+            if (object.breachMask & GEOFENCE_BREACH_EXIT_BIT) {
+                mBreachKeys.push_back(*it);
+            }
+            it = mParkedInside.erase(it);
+            continue;
+        }
+        ++it;
+    }
+    if (!mBreachKeys.empty()) {
+        mResidencyStats.parkedBreaches += (uint32_t)mBreachKeys.size();
+        reportBreachKeys(location, GEOFENCE_BREACH_EXIT, location.timestamp);
+    }
+
+    // enters
+    mBreachKeys.clear();
+    mResidencyScratch.clear();
+    mParkedIndex.getContaining(location.latitude, location.longitude, mResidencyScratch);
+    for (uint32_t indexId : mResidencyScratch) {
+        auto itKey = mParkedIndexKeys.find(indexId);
+        if (itKey == mParkedIndexKeys.end()) {
+            continue;
+        }
+        auto itParked = mParkedGeofences.find(itKey->second);
+        if (itParked == mParkedGeofences.end() || itParked->second.object.paused) {
+            continue;
+        }
+        mResidencyStats.parkedContainHits++;
+        contained = true;
+        if (!itParked->second.inside) {
+            itParked->second.inside = true;
+            mParkedInside.insert(itKey->second);
+            if (itParked->second.object.breachMask & GEOFENCE_BREACH_ENTER_BIT) {
+                mBreachKeys.push_back(itKey->second);
+            }
+        }
+    }
+    if (!mBreachKeys.empty()) {
+        mResidencyStats.parkedBreaches += (uint32_t)mBreachKeys.size();
+        reportBreachKeys(location, GEOFENCE_BREACH_ENTER, location.timestamp);
+    }
+    return contained;
+}
+
+void
+GeofenceAdapter::updateResidency(const Location& location)
+{
+    if (0 == mResidentMax) {
+        return;
+    }
+    double latitude = location.latitude;
+    double longitude = location.longitude;
+    mResidencyPositionTime = uptimeMillis();
+    if (!mParkedGeofences.empty() && 0 != mResidencyPositionTimeoutMs) {
+        // no-op while armed
+        mResidencyPositionTimer.start(mResidencyPositionTimeoutMs, false);
+    }
+
+    // parked fences breach on AP until the modem has them; a position inside one also
+    // asks for it to be swapped in
+    bool force = reportParkedBreaches(location);
+    if (0 != mResidencySwapsInFlight || mReplayPending) {
+        return;
+    }
+    size_t used = mGeofences.size() + mPendingResidentAdds + mResidencySwapInsInFlight;
+    if ((!mParkedGeofences.empty() && used < mResidentMax) || used > mResidentMax) {
+        force = true;
+    }
+    if (!force && mResidencyPositionValid &&
+            GeofenceSpatialIndex::distanceToFence(latitude, longitude, mResidencyLatitude,
+                                                  mResidencyLongitude, 0) <
+            mResidencyUpdateMeters) {
+        return;
+    }
+    mResidencyPositionValid = true;
+    mResidencyLatitude = latitude;
+    mResidencyLongitude = longitude;
+    if (mParkedGeofences.empty() && used <= mResidentMax) {
+        return;
+    }
+    mResidencyStats.evaluations++;
+
+    // nearest parked fences, closest first
+    std::vector<std::pair<double, GeofenceKey>> parked;
+    mResidencyScratch.clear();
+    mParkedIndex.getNearest(latitude, longitude, mResidentMax, mResidencyScratch);
+    for (uint32_t indexId : mResidencyScratch) {
+        auto it = mParkedIndexKeys.find(indexId);
+        if (it == mParkedIndexKeys.end()) {
+            continue;
+        }
+        const GeofenceObject& object = mParkedGeofences[it->second].object;
+        if (!object.paused) {
+            parked.push_back(std::make_pair(GeofenceSpatialIndex::distanceToFence(
+                    latitude, longitude, object.latitude, object.longitude, object.radius),
+                    it->second));
+        }
+    }
+
+    // resident fences, farthest first; paused ones are the first to give up their slot
+    std::vector<std::pair<double, uint32_t>> resident;
+    resident.reserve(mGeofences.size());
+    for (auto it = mGeofences.begin(); it != mGeofences.end(); ++it) {
+        const GeofenceObject& object = it->second;
+        double distance = object.paused ? HUGE_VAL : GeofenceSpatialIndex::distanceToFence(
+                latitude, longitude, object.latitude, object.longitude, object.radius);
+        resident.push_back(std::make_pair(distance, it->first));
+    }
+    std::sort(resident.begin(), resident.end(),
+              [] (const std::pair<double, uint32_t>& a, const std::pair<double, uint32_t>& b) {
+                  return a.first > b.first;
+              });
+
+    // back under the cap after all fences were swapped in for lack of a position;
+    // fences the device is in stay with the modem
+    size_t swapOuts = 0;
+    while (used - swapOuts > mResidentMax && swapOuts < resident.size() &&
+           resident[swapOuts].first > 0) {
+        swapOuts++;
+    }
+    size_t freeSlots = used < mResidentMax ? mResidentMax - used : 0;
+    size_t swapIns = 0;
+    for (auto& candidate : parked) {
+        // a fence the device is in takes the slot of any fence it is not in
+        double hysteresis = (0 == candidate.first) ? 0 : mResidencyHysteresisMeters;
+        if (freeSlots > 0) {
+            freeSlots--;
+        } else if (swapOuts < resident.size() &&
+                   candidate.first + hysteresis < resident[swapOuts].first) {
+            swapOuts++;
+        } else {
+            break;
+        }
+        swapIns++;
+    }
+
+    // all removes are queued ahead of the adds so the slots are free when the adds run
+    for (size_t i = 0; i < swapOuts; ++i) {
+        swapOutGeofence(resident[i].second);
+    }
+    for (size_t i = 0; i < swapIns; ++i) {
+        swapInGeofence(parked[i].second);
+    }
+    if (0 != mResidencySwapsInFlight) {
+        mResidencySwapRoundTime = uptimeMillis();
+        mResidencySwapTimer.start(mResidencySwapTimeoutMs, false);
+    }
+    LOC_LOGD("%s]: evaluation %u swapping in %zu out %zu, %zu resident %zu parked",
+             __func__, mResidencyStats.evaluations, swapIns, swapOuts,
+             mGeofences.size(), mParkedGeofences.size());
+}
+
+void
+GeofenceAdapter::swapInAllParked()
+{
+    if (0 == mResidentMax || 0 != mResidencySwapsInFlight || mReplayPending) {
+        return;
+    }
+    mResidencyStats.positionTimeouts++;
+    // without a position there is no telling which fences are near; the modem watches
+    // them all and the next position brings the set back under GEOFENCE_RESIDENT_MAX
+    size_t swapIns = 0;
+    for (auto it = mParkedGeofences.begin(); it != mParkedGeofences.end(); ++it) {
+        if (!it->second.object.paused) {
+            swapInGeofence(it->first);
+            swapIns++;
+        }
+    }
+    if (0 != mResidencySwapsInFlight) {
+        mResidencySwapRoundTime = uptimeMillis();
+        mResidencySwapTimer.start(mResidencySwapTimeoutMs, false);
+    }
+    LOC_LOGD("%s]: swapping in %zu, %zu resident %zu parked",
+             __func__, swapIns, mGeofences.size(), mParkedGeofences.size());
+}
+
+void
+GeofenceAdapter::swapOutGeofence(uint32_t hwId)
+{
+    auto it = mGeofences.find(hwId);
+    if (it == mGeofences.end()) {
+        return;
+    }
+    uint32_t epoch = mResidencyEpoch;
+    uint32_t engineUpCount = mEngineUpCount;
+    mResidencySwapsInFlight++;
+    mLocApi->removeGeofence(hwId, it->second.key.id,
+            new LocApiResponse(*getMsgTask(),
+            [this, hwId, epoch, engineUpCount] (LocationError err) {
+        if (engineUpCount != mEngineUpCount) {
+            // the engine restarted since, hwId no longer names the same fence
+            return;
+        }
+        if (LOCATION_ERROR_SUCCESS == err) {
+            auto it = mGeofences.find(hwId);
+            if (it != mGeofences.end()) {
+                GeofenceObject object = it->second;
+                auto itId = mGeofenceIds.find(object.key);
+                if (itId != mGeofenceIds.end() && itId->second == hwId) {
+                    removeGeofenceItem(hwId);
+                    parkGeofenceObject(object);
+                    mResidencyStats.swapOuts++;
+                    // the modem reported the ENTER already, AP reports the EXIT
+                    auto itParked = mParkedGeofences.find(object.key);
+                    if (mResidencyPositionValid && !object.paused &&
+                            itParked != mParkedGeofences.end() &&
+                            0 == GeofenceSpatialIndex::distanceToFence(
+                                mResidencyLatitude, mResidencyLongitude,
+                                object.latitude, object.longitude, object.radius)) {
+                        itParked->second.inside = true;
+                        mParkedInside.insert(object.key);
+                    }
+                } else {
+                    // client went away while the remove was queued
+                    mGeofences.erase(it);
+                    mSpatialIndex.remove(hwId);
+                    mGeofenceRoutes.erase(hwId);
+                    mSwappedInInside.erase(hwId);
+                }
+            }
+        } else {
+            LOC_LOGE("%s]: failed to swap out hwId %u err %u", __func__, hwId, err);
+        }
+        residencySwapDone(epoch);
+    }));
+}
+
+void
+GeofenceAdapter::swapInGeofence(const GeofenceKey& key)
+{
+    auto it = mParkedGeofences.find(key);
+    if (it == mParkedGeofences.end()) {
+        return;
+    }
+    const GeofenceObject& object = it->second.object;
+    GeofenceOption options = {sizeof(GeofenceOption),
+                              object.breachMask,
+                              object.responsiveness,
+                              object.dwellTime};
+    GeofenceInfo info = {sizeof(GeofenceInfo),
+                         object.latitude,
+                         object.longitude,
+                         object.radius};
+    uint64_t startTime = uptimeMillis();
+    uint32_t epoch = mResidencyEpoch;
+    uint32_t engineUpCount = mEngineUpCount;
+    mResidencySwapsInFlight++;
+    mResidencySwapInsInFlight++;
+    // the fence stays parked until the modem accepts it
+    mLocApi->addGeofence(key.id, options, info,
+            new LocApiResponseData<LocApiGeofenceData>(*getMsgTask(),
+            [this, key, options, info, startTime, epoch, engineUpCount]
+            (LocationError err, LocApiGeofenceData data) {
+        if (engineUpCount != mEngineUpCount) {
+            // the engine restarted since and lost the fence, it is still parked
+            return;
+        }
+        if (epoch == mResidencyEpoch && mResidencySwapInsInFlight > 0) {
+            mResidencySwapInsInFlight--;
+        }
+        if (LOCATION_ERROR_SUCCESS == err) {
+            auto it = mParkedGeofences.find(key);
+            if (it == mParkedGeofences.end()) {
+                // removed by the client while the add was queued
+                mLocApi->removeGeofence(data.hwId, key.id,
+                        new LocApiResponse(*getMsgTask(), [] (LocationError err) {}));
+            } else {
+                GeofenceObject object = it->second.object;
+                bool inside = it->second.inside;
+                removeParkedGeofenceItem(key.client, key.id);
+                saveGeofenceItem(key.client, key.id, data.hwId, options, info);
+                if (inside) {
+                    // AP reported the ENTER while the fence was parked
+                    mSwappedInInside.insert(data.hwId);
+                }
+                if (object.breachMask != options.breachTypeMask ||
+                        object.responsiveness != options.responsiveness ||
+                        object.dwellTime != options.dwellTime) {
+                    GeofenceOption newOptions = {sizeof(GeofenceOption),
+                                                 object.breachMask,
+                                                 object.responsiveness,
+                                                 object.dwellTime};
+                    mLocApi->modifyGeofence(data.hwId, key.id, newOptions,
+                            new LocApiResponse(*getMsgTask(), [] (LocationError err) {}));
+                    modifyGeofenceItem(data.hwId, newOptions);
+                }
+                if (object.paused) {
+                    mLocApi->pauseGeofence(data.hwId, key.id,
+                            new LocApiResponse(*getMsgTask(), [] (LocationError err) {}));
+                    pauseGeofenceItem(data.hwId);
+                }
+                uint64_t latency = uptimeMillis() - startTime;
+                mResidencyStats.swapIns++;
+                mResidencyStats.swapInLatencyTotalMs += latency;
+                if (latency > mResidencyStats.swapInLatencyMaxMs) {
+                    mResidencyStats.swapInLatencyMaxMs = latency;
+                }
+            }
+        } else {
+            LOC_LOGE("%s]: failed to swap in client %p clientId %u err %u",
+                     __func__, key.client, key.id, err);
+        }
+        residencySwapDone(epoch);
+    }));
+}
+
+void
+GeofenceAdapter::residencySwapDone(uint32_t epoch)
+{
+    // a late response of a round given up on leaves the current round's count alone
+    if (epoch != mResidencyEpoch) {
+        return;
+    }
+    if (mResidencySwapsInFlight > 0 && 0 == --mResidencySwapsInFlight) {
+        mResidencySwapTimer.stop();
+        LOC_LOGD("%s]: evaluations %u swapIns %u swapOuts %u parkedContainHits %u "
+                 "parkedBreaches %u swapTimeouts %u positionTimeouts %u "
+                 "swapInLatency avg %" PRIu64 " max %" PRIu64 " ms, %zu resident %zu parked",
+                 __func__, mResidencyStats.evaluations, mResidencyStats.swapIns,
+                 mResidencyStats.swapOuts, mResidencyStats.parkedContainHits,
+                 mResidencyStats.parkedBreaches, mResidencyStats.swapTimeouts,
+                 mResidencyStats.positionTimeouts,
+                 0 == mResidencyStats.swapIns ? 0 :
+                 mResidencyStats.swapInLatencyTotalMs / mResidencyStats.swapIns,
+                 mResidencyStats.swapInLatencyMaxMs,
+                 mGeofences.size(), mParkedGeofences.size());
+    }
+}
+
+void
+GeofenceAdapter::resetResidencySwaps()
+{
+    mResidencyEpoch++;
+    mResidencySwapsInFlight = 0;
+    mResidencySwapInsInFlight = 0;
+    mResidencySwapTimer.stop();
+}
+
+void
+GeofenceAdapter::residencySwapTimeout()
+{
+    if (0 == mResidencySwapsInFlight) {
+        return;
+    }
+    // a stale expiry of an earlier round does not cut the current one short
+    int64_t age = uptimeMillis() - mResidencySwapRoundTime;
+    if (age < mResidencySwapTimeoutMs) {
+        mResidencySwapTimer.start(mResidencySwapTimeoutMs - age, false);
+        return;
+    }
+    mResidencyStats.swapTimeouts++;
+    LOC_LOGW("%s]: %u swaps without a response after %u ms, giving up on them",
+             __func__, mResidencySwapsInFlight, mResidencySwapTimeoutMs);
+    resetResidencySwaps();
+}
+
+void
+GeofenceAdapter::residencyPositionTimeout()
+{
+    if (mParkedGeofences.empty() || 0 == mResidencyPositionTimeoutMs) {
+        return;
+    }
+    int64_t age = uptimeMillis() - mResidencyPositionTime;
+    if (0 != mResidencyPositionTime && age < mResidencyPositionTimeoutMs) {
+        mResidencyPositionTimer.start(mResidencyPositionTimeoutMs - age, false);
+        return;
+    }
+    LOC_LOGD("%s]: no position for %u ms", __func__, mResidencyPositionTimeoutMs);
+    swapInAllParked();
+}
+
+void
+ResidencySwapTimer::timeOutCallback()
+{
+    if (nullptr != mAdapter) {
+        mAdapter->residencySwapTimeoutEvent();
+    }
+}
+
+// Called in the context of LocTimer thread
+void
+GeofenceAdapter::residencySwapTimeoutEvent()
+{
+    struct MsgResidencySwapTimeout : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        inline MsgResidencySwapTimeout(GeofenceAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.residencySwapTimeout();
+        }
+    };
+
+    sendMsg(new MsgResidencySwapTimeout(*this));
+}
+
+void
+ResidencyPositionTimer::timeOutCallback()
+{
+    if (nullptr != mAdapter) {
+        mAdapter->residencyPositionTimeoutEvent();
+    }
+}
+
+// Called in the context of LocTimer thread
+void
+GeofenceAdapter::residencyPositionTimeoutEvent()
+{
+    struct MsgResidencyPositionTimeout : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        inline MsgResidencyPositionTimeout(GeofenceAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.residencyPositionTimeout();
+        }
+    };
+
+    sendMsg(new MsgResidencyPositionTimeout(*this));
+}
 
 void
 GeofenceAdapter::geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& location,
@@ -787,33 +1560,68 @@ void
 GeofenceAdapter::geofenceBreach(size_t count, uint32_t* hwIds, const Location& location,
         GeofenceBreachType breachType, uint64_t timestamp)
 {
+    if (location.flags & LOCATION_HAS_LAT_LONG_BIT) {
+        updateResidency(location);
+    }
 
-    for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
-        uint32_t* clientIds = new uint32_t[count];
-        if (nullptr == clientIds) {
-            return;
-        }
-        uint32_t index = 0;
-        for (size_t i=0; i < count; ++i) {
-            GeofenceKey key;
-            LocationError err = getGeofenceKeyFromHwId(hwIds[i], key);
-            if (LOCATION_ERROR_SUCCESS == err) {
-                if (key.client == it->first) {
-                    clientIds[index++] = key.id;
-                }
+    // resolve every hwId once
+    mBreachKeys.clear();
+    for (size_t i=0; i < count; ++i) {
+        if (!mSwappedInInside.empty()) {
+            // the ENTER of a fence swapped in while the device was in it went out from AP
+            if (GEOFENCE_BREACH_ENTER == breachType &&
+                    mSwappedInInside.erase(hwIds[i]) > 0) {
+                continue;
             }
+            if (GEOFENCE_BREACH_EXIT == breachType) {
+                mSwappedInInside.erase(hwIds[i]);
+            }
+        }
+        auto it = mGeofenceRoutes.find(hwIds[i]);
+        if (it != mGeofenceRoutes.end()) {
+            mBreachKeys.push_back(it->second);
+        }
+    }
+    reportBreachKeys(location, breachType, timestamp);
+}
+
+void
+GeofenceAdapter::reportBreachKeys(const Location& location, GeofenceBreachType breachType,
+        uint64_t timestamp)
+{
+    if (mBreachKeys.empty()) {
+        return;
+    }
+    // group by client, keeping the report order per client
+    std::stable_sort(mBreachKeys.begin(), mBreachKeys.end(),
+                     [] (const GeofenceKey& left, const GeofenceKey& right) {
+                         return left.client < right.client;
+                     });
+    mBreachClientIds.resize(mBreachKeys.size());
+    for (size_t i=0; i < mBreachKeys.size(); ++i) {
+        mBreachClientIds[i] = mBreachKeys[i].id;
+    }
+
+    size_t start = 0;
+    while (start < mBreachKeys.size()) {
+        LocationAPI* client = mBreachKeys[start].client;
+        size_t end = start + 1;
+        while (end < mBreachKeys.size() && mBreachKeys[end].client == client) {
+            ++end;
         }
-        if (index > 0 && it->second.geofenceBreachCb != nullptr) {
+        auto it = mClientData.find(client);
+        if (it != mClientData.end() && it->second.geofenceBreachCb != nullptr) {
             GeofenceBreachNotification notify = {sizeof(GeofenceBreachNotification),
-                                                 index,
-                                                 clientIds,
+                                                 (uint32_t)(end - start),
+                                                 &mBreachClientIds[start],
                                                  location,
                                                  breachType,
                                                  timestamp};
 
+            LocWorkAccounting::ClientCallbackScope accounting(client);
             it->second.geofenceBreachCb(notify);
         }
-        delete[] clientIds;
+        start = end;
     }
 }
 
@@ -846,6 +1654,7 @@ GeofenceAdapter::geofenceStatus(GeofenceStatusAvailable available)
             GeofenceStatusNotification notify = {sizeof(GeofenceStatusNotification),
                                                  available,
                                                  LOCATION_TECHNOLOGY_TYPE_GNSS};
+            LocWorkAccounting::ClientCallbackScope accounting(it->first);
             it->second.geofenceStatusCb(notify);
         }
     }
@@ -32,7 +32,16 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
+#include <GeofenceSpatialIndex.h>
+#include <LocTimer.h>
 #include <map>
+#include <set>
+#include <vector>
+#ifdef NO_UNORDERED_SET_OR_MAP
+    #include <map>
+#else
+    #include <unordered_map>
+#endif
 
 using namespace loc_core;
 
@@ -73,12 +82,106 @@ typedef struct {
 } GeofenceObject;
 typedef std::map<uint32_t, GeofenceObject> GeofencesMap; //map of hwId to GeofenceObject
 typedef std::map<GeofenceKey, uint32_t> GeofenceIdMap; //map of GeofenceKey to hwId
+typedef std::unordered_map<uint32_t, GeofenceKey> GeofenceRouteMap; //map of hwId to GeofenceKey
+typedef struct {
+    GeofenceObject object;
+    uint32_t indexId; // id of the fence in the spatial index of parked fences
+    bool inside;      // last position was inside, breaches of parked fences are reported on AP
+} ParkedGeofence;
+typedef std::map<GeofenceKey, ParkedGeofence> ParkedGeofencesMap;
+typedef struct {
+    uint32_t evaluations;       // residency evaluations run
+    uint32_t swapIns;           // fences made resident in the modem
+    uint32_t swapOuts;          // fences parked on AP to make room
+    uint32_t parkedContainHits; // positions found inside a parked fence
+    uint32_t parkedBreaches;    // breaches of parked fences reported on AP
+    uint32_t swapTimeouts;      // swap rounds given up on for lack of a response
+    uint32_t positionTimeouts;  // all parked fences swapped in for lack of a position
+    uint64_t swapInLatencyTotalMs;
+    uint64_t swapInLatencyMaxMs;
+} GeofenceResidencyStats;
+
+class GeofenceAdapter;
+
+// ends the wait for the responses of a residency swap round
+class ResidencySwapTimer : public LocTimer {
+public:
+    inline ResidencySwapTimer(GeofenceAdapter* adapter) :
+            LocTimer(), mAdapter(adapter) {}
+
+private:
+    // Override
+    virtual void timeOutCallback() override;
+
+    GeofenceAdapter* mAdapter;
+};
+
+// fires when no position has been seen for GEOFENCE_RESIDENCY_POSITION_TIMEOUT_SEC
+class ResidencyPositionTimer : public LocTimer {
+public:
+    inline ResidencyPositionTimer(GeofenceAdapter* adapter) :
+            LocTimer(), mAdapter(adapter) {}
+
+private:
+    // Override
+    virtual void timeOutCallback() override;
+
+    GeofenceAdapter* mAdapter;
+};
 
 class GeofenceAdapter : public LocAdapterBase {
 
     /* ==== GEOFENCES ====================================================================== */
     GeofencesMap mGeofences; //map hwId to GeofenceObject
     GeofenceIdMap mGeofenceIds; //map of GeofenceKey to hwId
+    GeofenceSpatialIndex mSpatialIndex; //hwIds by location, in sync with mGeofences
+    GeofenceRouteMap mGeofenceRoutes; //breach routing, in sync with mGeofences
+    std::vector<GeofenceKey> mBreachKeys; //scratch for geofenceBreach
+    std::vector<uint32_t> mBreachClientIds; //scratch for geofenceBreach
+    bool mReplayPending; //engine restarted, the fences are not re-added yet
+
+    /* ==== RESIDENCY ====================================================================== */
+    // With GEOFENCE_RESIDENT_MAX set, at most that many fences are added to the modem,
+    // the nearest ones to the last position; the others are parked on AP and swapped
+    // in as the device gets near them.
+    uint32_t mResidentMax;
+    uint32_t mResidencyHysteresisMeters;
+    uint32_t mResidencyUpdateMeters;
+    uint32_t mResidencySwapTimeoutMs;
+    uint32_t mResidencyPositionTimeoutMs;
+    ParkedGeofencesMap mParkedGeofences;
+    std::map<uint32_t, GeofenceKey> mParkedIndexKeys; //map of parked index id to GeofenceKey
+    GeofenceSpatialIndex mParkedIndex;
+    uint32_t mParkedIndexIdCounter;
+    uint32_t mPendingResidentAdds;
+    uint32_t mResidencySwapInsInFlight;
+    uint32_t mResidencySwapsInFlight;
+    // bumped when the swaps in flight are given up on; older responses are stale
+    uint32_t mResidencyEpoch;
+    // bumped on engine restart; older responses describe a modem state that is gone
+    uint32_t mEngineUpCount;
+    int64_t mResidencySwapRoundTime;
+    int64_t mResidencyPositionTime;
+    ResidencySwapTimer mResidencySwapTimer;
+    ResidencyPositionTimer mResidencyPositionTimer;
+    std::set<GeofenceKey> mParkedInside; //parked fences the last position was inside
+    std::set<uint32_t> mSwappedInInside; //hwIds whose first modem ENTER was reported on AP
+    bool mResidencyPositionValid;
+    double mResidencyLatitude;
+    double mResidencyLongitude;
+    GeofenceResidencyStats mResidencyStats;
+    std::vector<uint32_t> mResidencyScratch;
+    void readResidencyConfig();
+    void parkGeofenceObject(const GeofenceObject& object);
+    void swapInGeofence(const GeofenceKey& key);
+    void swapOutGeofence(uint32_t hwId);
+    void residencySwapDone(uint32_t epoch);
+    void resetResidencySwaps();
+    void residencySwapTimeout();
+    void residencyPositionTimeout();
+    bool reportParkedBreaches(const Location& location);
+    void reportBreachKeys(const Location& location, GeofenceBreachType breachType,
+                          uint64_t timestamp);
 
 protected:
 
@@ -91,11 +194,23 @@ public:
     GeofenceAdapter();
     virtual ~GeofenceAdapter() {}
 
+    /* ==== POSITION ======================================================================= */
+    /* ======== EVENTS ====(Called from QMI Thread)========================================= */
+    using LocAdapterBase::reportPositionEvent;
+    virtual void reportPositionEvent(const UlpLocation& location,
+                                     const GpsLocationExtended& locationExtended,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask loc_technology_mask,
+                                     GnssDataNotification* pDataNotify = nullptr,
+                                     int msInWeek = -1);
+
     /* ==== SSR ============================================================================ */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
     virtual void handleEngineUpEvent();
     /* ======== UTILITIES ================================================================== */
     void restartGeofences();
+    void replayGeofences();
+    inline bool isReplayPending() const { return mReplayPending; }
 
     /* ==== GEOFENCES ====================================================================== */
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
@@ -120,7 +235,39 @@ public:
     void modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options);
     LocationError getHwIdFromClient(LocationAPI* client, uint32_t clientId, uint32_t& hwId);
     LocationError getGeofenceKeyFromHwId(uint32_t hwId, GeofenceKey& key);
+    inline void getContainingGeofences(double latitude, double longitude,
+                                       std::vector<uint32_t>& hwIds) {
+        mSpatialIndex.getContaining(latitude, longitude, hwIds);
+    }
+    inline void getNearestGeofences(double latitude, double longitude, size_t count,
+                                    std::vector<uint32_t>& hwIds) {
+        mSpatialIndex.getNearest(latitude, longitude, count, hwIds);
+    }
     void dump();
+    /* ======== RESIDENCY ================================================================== */
+    inline bool isResidencyFull() const {
+        return 0 != mResidentMax &&
+               mGeofences.size() + mPendingResidentAdds + mResidencySwapInsInFlight >=
+               mResidentMax;
+    }
+    inline void addPendingResidentAdd() { mPendingResidentAdds++; }
+    inline void removePendingResidentAdd() {
+        if (mPendingResidentAdds > 0) {
+            mPendingResidentAdds--;
+        }
+    }
+    void parkGeofenceItem(LocationAPI* client, uint32_t clientId,
+                          const GeofenceOption& options, const GeofenceInfo& info,
+                          bool paused);
+    bool removeParkedGeofenceItem(LocationAPI* client, uint32_t clientId);
+    bool pauseParkedGeofenceItem(LocationAPI* client, uint32_t clientId, bool paused);
+    bool modifyParkedGeofenceItem(LocationAPI* client, uint32_t clientId,
+                                  const GeofenceOption& options);
+    void updateResidency(const Location& location);
+    void swapInAllParked();
+    /* ======== EVENTS ====(Called from LocTimer Thread)=================================== */
+    void residencySwapTimeoutEvent();
+    void residencyPositionTimeoutEvent();
 
     /* ==== REPORTS ======================================================================== */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
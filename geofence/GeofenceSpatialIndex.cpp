@@ -0,0 +1,254 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_GeofenceSpatialIndex"
+
+#include <math.h>
+#include <algorithm>
+#include <log_util.h>
+#include <GeofenceSpatialIndex.h>
+
+#define EARTH_RADIUS_METERS      6371000.0
+#define METERS_PER_DEGREE        (EARTH_RADIUS_METERS * M_PI / 180.0)
+// a fence spanning more cells than this is not listed in the cells
+#define MAX_CELLS_PER_FENCE      64
+// below this number of fences a scan of all fences is cheaper than the cells
+#define MAX_FENCES_FOR_SCAN      256
+
+GeofenceSpatialIndex::GeofenceSpatialIndex(double cellDegrees) :
+    mCellDegrees(cellDegrees),
+    mCellsX((int32_t)ceil(360.0 / cellDegrees)),
+    mMinX(INT32_MAX),
+    mMinY(INT32_MAX),
+    mMaxX(INT32_MIN),
+    mMaxY(INT32_MIN),
+    mQueryStamp(0)
+{
+}
+
+double GeofenceSpatialIndex::distanceToFence(double latitude, double longitude,
+                                             double fenceLatitude, double fenceLongitude,
+                                             double fenceRadius)
+{
+    double lat1 = latitude * M_PI / 180.0;
+    double lat2 = fenceLatitude * M_PI / 180.0;
+    double sinDLat = sin((lat2 - lat1) / 2);
+    double sinDLon = sin((fenceLongitude - longitude) * M_PI / 360.0);
+    double a = sinDLat * sinDLat + cos(lat1) * cos(lat2) * sinDLon * sinDLon;
+    double distance = 2 * EARTH_RADIUS_METERS * asin(sqrt(std::min(1.0, a)));
+    return (distance > fenceRadius) ? distance - fenceRadius : 0.0;
+}
+
+void GeofenceSpatialIndex::insert(uint32_t hwId, double latitude, double longitude,
+                                  double radius)
+{
+    remove(hwId);
+
+    Fence fence = {latitude, longitude, radius, 0, 0, 0, 0, false, mQueryStamp};
+    double dLat = radius / METERS_PER_DEGREE;
+    double cosLat = cos(latitude * M_PI / 180.0);
+    if (latitude - dLat < -90.0 || latitude + dLat > 90.0 || cosLat < 0.01) {
+        fence.large = true;
+    } else {
+        double dLon = dLat / cosLat;
+        if (longitude - dLon < -180.0 || longitude + dLon >= 180.0) {
+            fence.large = true;
+        } else {
+            fence.minX = cellX(longitude - dLon);
+            fence.maxX = cellX(longitude + dLon);
+            fence.minY = cellY(latitude - dLat);
+            fence.maxY = cellY(latitude + dLat);
+            fence.large = (int64_t)(fence.maxX - fence.minX + 1) *
+                    (fence.maxY - fence.minY + 1) > MAX_CELLS_PER_FENCE;
+        }
+    }
+
+    if (fence.large) {
+        mLargeFences.push_back(hwId);
+    } else {
+        for (int32_t y = fence.minY; y <= fence.maxY; y++) {
+            for (int32_t x = fence.minX; x <= fence.maxX; x++) {
+                mCells[cellKey(x, y)].push_back(hwId);
+            }
+        }
+        mMinX = std::min(mMinX, fence.minX);
+        mMinY = std::min(mMinY, fence.minY);
+        mMaxX = std::max(mMaxX, fence.maxX);
+        mMaxY = std::max(mMaxY, fence.maxY);
+    }
+    mFences[hwId] = fence;
+}
+
+void GeofenceSpatialIndex::remove(uint32_t hwId)
+{
+    auto it = mFences.find(hwId);
+    if (mFences.end() == it) {
+        return;
+    }
+
+    const Fence& fence = it->second;
+    if (fence.large) {
+        mLargeFences.erase(std::remove(mLargeFences.begin(), mLargeFences.end(), hwId),
+                           mLargeFences.end());
+    } else {
+        for (int32_t y = fence.minY; y <= fence.maxY; y++) {
+            for (int32_t x = fence.minX; x <= fence.maxX; x++) {
+                auto cell = mCells.find(cellKey(x, y));
+                if (mCells.end() != cell) {
+                    std::vector<uint32_t>& ids = cell->second;
+                    auto id = std::find(ids.begin(), ids.end(), hwId);
+                    if (ids.end() != id) {
+                        *id = ids.back();
+                        ids.pop_back();
+                    }
+                    if (ids.empty()) {
+                        mCells.erase(cell);
+                    }
+                }
+            }
+        }
+    }
+    mFences.erase(it);
+}
+
+void GeofenceSpatialIndex::clear()
+{
+    mFences.clear();
+    mCells.clear();
+    mLargeFences.clear();
+    mMinX = mMinY = INT32_MAX;
+    mMaxX = mMaxY = INT32_MIN;
+}
+
+void GeofenceSpatialIndex::visitFence(uint32_t hwId, Fence& fence,
+                                      double latitude, double longitude)
+{
+    if (fence.queryStamp != mQueryStamp) {
+        fence.queryStamp = mQueryStamp;
+        mCandidates.emplace_back(distanceToFence(latitude, longitude, fence.latitude,
+                                                 fence.longitude, fence.radius), hwId);
+    }
+}
+
+void GeofenceSpatialIndex::visitCell(int32_t x, int32_t y, double latitude, double longitude)
+{
+    auto cell = mCells.find(cellKey(wrapX(x), y));
+    if (mCells.end() != cell) {
+        for (uint32_t hwId : cell->second) {
+            visitFence(hwId, mFences[hwId], latitude, longitude);
+        }
+    }
+}
+
+void GeofenceSpatialIndex::getContaining(double latitude, double longitude,
+                                         std::vector<uint32_t>& hwIds)
+{
+    hwIds.clear();
+    mCandidates.clear();
+    mQueryStamp++;
+
+    visitCell(cellX(longitude), cellY(latitude), latitude, longitude);
+    for (uint32_t hwId : mLargeFences) {
+        visitFence(hwId, mFences[hwId], latitude, longitude);
+    }
+    for (auto& candidate : mCandidates) {
+        if (0.0 == candidate.first) {
+            hwIds.push_back(candidate.second);
+        }
+    }
+}
+
+void GeofenceSpatialIndex::getNearest(double latitude, double longitude, size_t count,
+                                      std::vector<uint32_t>& hwIds)
+{
+    hwIds.clear();
+    mCandidates.clear();
+    if (0 == count || mFences.empty()) {
+        return;
+    }
+    mQueryStamp++;
+
+    int32_t cx = cellX(longitude);
+    int32_t cy = cellY(latitude);
+    int32_t maxRing = -1;
+    if (mFences.size() <= MAX_FENCES_FOR_SCAN) {
+        for (auto& fence : mFences) {
+            visitFence(fence.first, fence.second, latitude, longitude);
+        }
+    } else {
+        for (uint32_t hwId : mLargeFences) {
+            visitFence(hwId, mFences[hwId], latitude, longitude);
+        }
+        // going around the antimeridian, no cell is more than half a circle away
+        maxRing = std::max(std::min(std::max(cx - mMinX, mMaxX - cx), mCellsX / 2),
+                           std::max(cy - mMinY, mMaxY - cy));
+    }
+
+    // visit the rings of cells around the point, until the nearest count fences
+    // are closer than any fence of the next ring could be. Once the rings would
+    // take more cells than there are fences, a scan of all fences is cheaper.
+    size_t visitedCells = 0;
+    for (int32_t ring = 0; ring <= maxRing; ring++) {
+        if (mCandidates.size() >= count && ring > 1) {
+            // the points of a ring are at least ring - 1 cells away from the point
+            double ringLatitude = std::min(90.0, fabs(latitude) + (ring + 1) * mCellDegrees);
+            double ringDistance = (ring - 1) * mCellDegrees * METERS_PER_DEGREE *
+                    cos(ringLatitude * M_PI / 180.0);
+            std::nth_element(mCandidates.begin(), mCandidates.begin() + (count - 1),
+                             mCandidates.end());
+            if (mCandidates[count - 1].first <= ringDistance) {
+                break;
+            }
+        }
+        visitedCells += (0 == ring) ? 1 : 8 * (size_t)ring;
+        if (visitedCells > mFences.size()) {
+            for (auto& fence : mFences) {
+                visitFence(fence.first, fence.second, latitude, longitude);
+            }
+            break;
+        }
+        if (0 == ring) {
+            visitCell(cx, cy, latitude, longitude);
+            continue;
+        }
+        for (int32_t x = cx - ring; x <= cx + ring; x++) {
+            visitCell(x, cy - ring, latitude, longitude);
+            visitCell(x, cy + ring, latitude, longitude);
+        }
+        for (int32_t y = cy - ring + 1; y <= cy + ring - 1; y++) {
+            visitCell(cx - ring, y, latitude, longitude);
+            visitCell(cx + ring, y, latitude, longitude);
+        }
+    }
+
+    size_t found = std::min(count, mCandidates.size());
+    std::partial_sort(mCandidates.begin(), mCandidates.begin() + found, mCandidates.end());
+    for (size_t i = 0; i < found; i++) {
+        hwIds.push_back(mCandidates[i].second);
+    }
+}
@@ -0,0 +1,100 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef GEOFENCE_SPATIAL_INDEX_H
+#define GEOFENCE_SPATIAL_INDEX_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Grid index of the geofences over latitude/longitude cells. A fence is listed
+ * in every cell its bounding box overlaps, so the fences whose area is within
+ * a distance of a point are all found in the cells within that distance. The
+ * fences whose bounding box would span too many cells, or the antimeridian or
+ * a pole, are kept aside and checked by every query. */
+class GeofenceSpatialIndex {
+public:
+    GeofenceSpatialIndex(double cellDegrees = 0.01);
+
+    void insert(uint32_t hwId, double latitude, double longitude, double radius);
+    void remove(uint32_t hwId);
+    void clear();
+    inline size_t size() const { return mFences.size(); }
+
+    // distance in meters from the point to the area of the fence, 0 if inside
+    static double distanceToFence(double latitude, double longitude,
+                                  double fenceLatitude, double fenceLongitude,
+                                  double fenceRadius);
+
+    // fences containing the point
+    void getContaining(double latitude, double longitude, std::vector<uint32_t>& hwIds);
+    // up to count fences closest to the point, closest first
+    void getNearest(double latitude, double longitude, size_t count,
+                    std::vector<uint32_t>& hwIds);
+
+private:
+    struct Fence {
+        double latitude;
+        double longitude;
+        double radius;
+        int32_t minX, minY, maxX, maxY;  // cells of the bounding box
+        bool large;
+        uint32_t queryStamp;             // last query which visited the fence
+    };
+
+    double mCellDegrees;
+    int32_t mCellsX;                     // cells around a circle of latitude
+    std::unordered_map<uint32_t, Fence> mFences;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> mCells;
+    std::vector<uint32_t> mLargeFences;
+    // extent of the cells ever used, bounds the ring search of getNearest
+    int32_t mMinX, mMinY, mMaxX, mMaxY;
+    uint32_t mQueryStamp;
+    std::vector<std::pair<double, uint32_t>> mCandidates;
+
+    static inline uint64_t cellKey(int32_t x, int32_t y) {
+        return ((uint64_t)(uint32_t)y << 32) | (uint32_t)x;
+    }
+    inline int32_t cellX(double longitude) const {
+        return (int32_t)((longitude + 180.0) / mCellDegrees);
+    }
+    inline int32_t cellY(double latitude) const {
+        return (int32_t)((latitude + 90.0) / mCellDegrees);
+    }
+    // the cells wrap around at the antimeridian
+    inline int32_t wrapX(int32_t x) const {
+        x %= mCellsX;
+        return (x < 0) ? x + mCellsX : x;
+    }
+    void visitCell(int32_t x, int32_t y, double latitude, double longitude);
+    void visitFence(uint32_t hwId, Fence& fence, double latitude, double longitude);
+};
+
+#endif // GEOFENCE_SPATIAL_INDEX_H
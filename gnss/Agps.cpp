@@ -38,248 +38,208 @@
 /* --------------------------------------------------------------------
  *   AGPS State Machine Methods
  * -------------------------------------------------------------------*/
+/* Transition table, indexed [state][event]. A NULL cell is a legal event
+ * that needs no action in that state. */
+const AgpsStateMachine::TransitionHandler
+AgpsStateMachine::sTransitionTable[AGPS_STATE_RELEASING + 1][AGPS_EVENT_DENIED + 1] = {
+    /* AGPS_STATE_INVALID */
+    { NULL, NULL, NULL, NULL, NULL, NULL },
+    /* AGPS_STATE_RELEASED */
+    { NULL,
+      &AgpsStateMachine::onSubscribeInReleased,         /* SUBSCRIBE */
+      &AgpsStateMachine::onUnsubscribeInReleased,       /* UNSUBSCRIBE */
+      &AgpsStateMachine::onUnexpectedEvent,             /* GRANTED */
+      &AgpsStateMachine::onReleasedInReleased,          /* RELEASED */
+      &AgpsStateMachine::onUnexpectedEvent },           /* DENIED */
+    /* AGPS_STATE_PENDING */
+    { NULL,
+      &AgpsStateMachine::onSubscribeQueued,             /* SUBSCRIBE */
+      &AgpsStateMachine::onUnsubscribeInPendingOrAcquired, /* UNSUBSCRIBE */
+      &AgpsStateMachine::onGrantedInPending,            /* GRANTED */
+      NULL,                                             /* RELEASED */
+      &AgpsStateMachine::onDeniedInPending },           /* DENIED */
+    /* AGPS_STATE_ACQUIRED */
+    { NULL,
+      &AgpsStateMachine::onSubscribeInAcquired,         /* SUBSCRIBE */
+      &AgpsStateMachine::onUnsubscribeInPendingOrAcquired, /* UNSUBSCRIBE */
+      &AgpsStateMachine::onUnexpectedEvent,             /* GRANTED */
+      &AgpsStateMachine::onReleasedInAcquired,          /* RELEASED */
+      NULL },                                           /* DENIED */
+    /* AGPS_STATE_RELEASING */
+    { NULL,
+      &AgpsStateMachine::onSubscribeQueued,             /* SUBSCRIBE */
+      &AgpsStateMachine::onUnsubscribeInReleasing,      /* UNSUBSCRIBE */
+      &AgpsStateMachine::onUnexpectedEvent,             /* GRANTED */
+      &AgpsStateMachine::onReleasedOrDeniedInReleasing, /* RELEASED */
+      &AgpsStateMachine::onReleasedOrDeniedInReleasing } /* DENIED */
+};
+
 void AgpsStateMachine::processAgpsEvent(AgpsEvent event){
 
     LOC_LOGD("processAgpsEvent(): SM %p, Event %d, State %d",
                this, event, mState);
 
-    switch (event) {
+    if (event <= AGPS_EVENT_INVALID || event > AGPS_EVENT_DENIED) {
+        LOC_LOGE("Invalid Loc Agps Event");
+        return;
+    }
+    if (mState <= AGPS_STATE_INVALID || mState > AGPS_STATE_RELEASING) {
+        LOC_LOGE("Invalid state: %d", mState);
+        return;
+    }
 
-        case AGPS_EVENT_SUBSCRIBE:
-            processAgpsEventSubscribe();
-            break;
+    /* A new subscriber that does not fit in the table is denied right
+     * away, without disturbing the subscribers already queued */
+    if (AGPS_EVENT_SUBSCRIBE == event &&
+            mSubscriberCount >= MAX_AGPS_SUBSCRIBERS &&
+            NULL == getSubscriber(mCurrentSubscriber->mConnHandle)) {
+        LOC_LOGE("Subscriber table full, denying connHandle %d",
+                 mCurrentSubscriber->mConnHandle);
+        notifyEventToSubscriber(AGPS_EVENT_DENIED, mCurrentSubscriber, false);
+        return;
+    }
 
-        case AGPS_EVENT_UNSUBSCRIBE:
-            processAgpsEventUnsubscribe();
-            break;
+    TransitionHandler handler = sTransitionTable[mState][event];
+    if (NULL != handler) {
+        (this->*handler)(event);
+    }
+}
 
-        case AGPS_EVENT_GRANTED:
-            processAgpsEventGranted();
-            break;
+void AgpsStateMachine::onSubscribeInReleased(AgpsEvent /*event*/){
 
-        case AGPS_EVENT_RELEASED:
-            processAgpsEventReleased();
-            break;
+    /* Add subscriber to list
+     * No notifications until we get RSRC_GRANTED */
+    addSubscriber(mCurrentSubscriber);
+    requestOrReleaseDataConn(true);
+    transitionState(AGPS_STATE_PENDING);
+}
 
-        case AGPS_EVENT_DENIED:
-            processAgpsEventDenied();
-            break;
+void AgpsStateMachine::onSubscribeQueued(AgpsEvent /*event*/){
 
-        default:
-            LOC_LOGE("Invalid Loc Agps Event");
-    }
+    /* PENDING: already requested for data connection, do nothing until
+     * we get RSRC_GRANTED event.
+     * RELEASING: the subscriber is served once the release completes.
+     * Just add this subscriber to the list, for notifications */
+    addSubscriber(mCurrentSubscriber);
 }
 
-void AgpsStateMachine::processAgpsEventSubscribe(){
+void AgpsStateMachine::onSubscribeInAcquired(AgpsEvent /*event*/){
 
-    switch (mState) {
+    /* We already have the data connection setup,
+     * Notify current subscriber with GRANTED event,
+     * And add it to the subscriber list for further notifications. */
+    notifyEventToSubscriber(AGPS_EVENT_GRANTED, mCurrentSubscriber, false);
+    addSubscriber(mCurrentSubscriber);
+}
 
-        case AGPS_STATE_RELEASED:
-            /* Add subscriber to list
-             * No notifications until we get RSRC_GRANTED */
-            addSubscriber(mCurrentSubscriber);
-            requestOrReleaseDataConn(true);
-            transitionState(AGPS_STATE_PENDING);
-            break;
+void AgpsStateMachine::onUnsubscribeInReleased(AgpsEvent /*event*/){
 
-        case AGPS_STATE_PENDING:
-            /* Already requested for data connection,
-             * do nothing until we get RSRC_GRANTED event;
-             * Just add this subscriber to the list, for notifications */
-            addSubscriber(mCurrentSubscriber);
-            break;
+    notifyEventToSubscriber(
+            AGPS_EVENT_UNSUBSCRIBE, mCurrentSubscriber, false);
+}
 
-        case AGPS_STATE_ACQUIRED:
-            /* We already have the data connection setup,
-             * Notify current subscriber with GRANTED event,
-             * And add it to the subscriber list for further notifications. */
-            notifyEventToSubscriber(AGPS_EVENT_GRANTED, mCurrentSubscriber, false);
-            addSubscriber(mCurrentSubscriber);
-            break;
+void AgpsStateMachine::unsubscribeCurrentSubscriber(){
 
-        case AGPS_STATE_RELEASING:
-            addSubscriber(mCurrentSubscriber);
-            break;
-
-        default:
-            LOC_LOGE("Invalid state: %d", mState);
+    /* If the subscriber wishes to wait for connection close,
+     * before being removed from list, move to inactive state
+     * and notify */
+    if (mCurrentSubscriber->mWaitForCloseComplete) {
+        mCurrentSubscriber->mIsInactive = true;
+    }
+    else {
+        /* Notify only current subscriber and then delete it from
+         * subscriberList */
+        notifyEventToSubscriber(
+                AGPS_EVENT_UNSUBSCRIBE, mCurrentSubscriber, true);
     }
 }
 
-void AgpsStateMachine::processAgpsEventUnsubscribe(){
-
-    switch (mState) {
-
-        case AGPS_STATE_RELEASED:
-            notifyEventToSubscriber(
-                    AGPS_EVENT_UNSUBSCRIBE, mCurrentSubscriber, false);
-            break;
+void AgpsStateMachine::onUnsubscribeInPendingOrAcquired(AgpsEvent /*event*/){
 
-        case AGPS_STATE_PENDING:
-        case AGPS_STATE_ACQUIRED:
-            /* If the subscriber wishes to wait for connection close,
-             * before being removed from list, move to inactive state
-             * and notify */
-            if (mCurrentSubscriber->mWaitForCloseComplete) {
-                mCurrentSubscriber->mIsInactive = true;
-            }
-            else {
-                /* Notify only current subscriber and then delete it from
-                 * subscriberList */
-                notifyEventToSubscriber(
-                        AGPS_EVENT_UNSUBSCRIBE, mCurrentSubscriber, true);
-            }
+    unsubscribeCurrentSubscriber();
 
-            /* If no subscribers in list, release data connection */
-            if (mSubscriberList.empty()) {
-                transitionState(AGPS_STATE_RELEASED);
-                requestOrReleaseDataConn(false);
-            }
-            /* Some subscribers in list, but all inactive;
-             * Release data connection */
-            else if(!anyActiveSubscribers()) {
-                transitionState(AGPS_STATE_RELEASING);
-                requestOrReleaseDataConn(false);
-            }
-            break;
+    /* If no subscribers in list, release data connection */
+    if (0 == mSubscriberCount) {
+        transitionState(AGPS_STATE_RELEASED);
+        requestOrReleaseDataConn(false);
+    }
+    /* Some subscribers in list, but all inactive;
+     * Release data connection */
+    else if(!anyActiveSubscribers()) {
+        transitionState(AGPS_STATE_RELEASING);
+        requestOrReleaseDataConn(false);
+    }
+}
 
-        case AGPS_STATE_RELEASING:
-            /* If the subscriber wishes to wait for connection close,
-             * before being removed from list, move to inactive state
-             * and notify */
-            if (mCurrentSubscriber->mWaitForCloseComplete) {
-                mCurrentSubscriber->mIsInactive = true;
-            }
-            else {
-                /* Notify only current subscriber and then delete it from
-                 * subscriberList */
-                notifyEventToSubscriber(
-                        AGPS_EVENT_UNSUBSCRIBE, mCurrentSubscriber, true);
-            }
+void AgpsStateMachine::onUnsubscribeInReleasing(AgpsEvent /*event*/){
 
-            /* If no subscribers in list, just move the state.
-             * Request for releasing data connection should already have been
-             * sent */
-            if (mSubscriberList.empty()) {
-                transitionState(AGPS_STATE_RELEASED);
-            }
-            break;
+    unsubscribeCurrentSubscriber();
 
-        default:
-            LOC_LOGE("Invalid state: %d", mState);
+    /* If no subscribers in list, just move the state.
+     * Request for releasing data connection should already have been
+     * sent */
+    if (0 == mSubscriberCount) {
+        transitionState(AGPS_STATE_RELEASED);
     }
 }
 
-void AgpsStateMachine::processAgpsEventGranted(){
+void AgpsStateMachine::onGrantedInPending(AgpsEvent /*event*/){
 
-    switch (mState) {
+    // Move to acquired state
+    transitionState(AGPS_STATE_ACQUIRED);
+    notifyAllSubscribers(
+            AGPS_EVENT_GRANTED, false,
+            AGPS_NOTIFICATION_TYPE_FOR_ACTIVE_SUBSCRIBERS);
+}
 
-        case AGPS_STATE_RELEASED:
-        case AGPS_STATE_ACQUIRED:
-        case AGPS_STATE_RELEASING:
-            LOC_LOGE("Unexpected event GRANTED in state %d", mState);
-            break;
+void AgpsStateMachine::onReleasedInReleased(AgpsEvent /*event*/){
 
-        case AGPS_STATE_PENDING:
-            // Move to acquired state
-            transitionState(AGPS_STATE_ACQUIRED);
-            notifyAllSubscribers(
-                    AGPS_EVENT_GRANTED, false,
-                    AGPS_NOTIFICATION_TYPE_FOR_ACTIVE_SUBSCRIBERS);
-            break;
-
-        default:
-            LOC_LOGE("Invalid state: %d", mState);
+    /* Subscriber list should be empty if we are in released state */
+    if (0 != mSubscriberCount) {
+        LOC_LOGE("Unexpected event RELEASED in RELEASED state");
     }
 }
 
-void AgpsStateMachine::processAgpsEventReleased(){
-
-    switch (mState) {
-
-        case AGPS_STATE_RELEASED:
-            /* Subscriber list should be empty if we are in released state */
-            if (!mSubscriberList.empty()) {
-                LOC_LOGE("Unexpected event RELEASED in RELEASED state");
-            }
-            break;
+void AgpsStateMachine::onReleasedInAcquired(AgpsEvent /*event*/){
 
-        case AGPS_STATE_ACQUIRED:
-            /* Force release received */
-            LOC_LOGW("Force RELEASED event in ACQUIRED state");
-            transitionState(AGPS_STATE_RELEASED);
-            notifyAllSubscribers(
-                    AGPS_EVENT_RELEASED, true,
-                    AGPS_NOTIFICATION_TYPE_FOR_ALL_SUBSCRIBERS);
-            break;
+    /* Force release received */
+    LOC_LOGW("Force RELEASED event in ACQUIRED state");
+    transitionState(AGPS_STATE_RELEASED);
+    notifyAllSubscribers(
+            AGPS_EVENT_RELEASED, true,
+            AGPS_NOTIFICATION_TYPE_FOR_ALL_SUBSCRIBERS);
+}
 
-        case AGPS_STATE_RELEASING:
-            /* Notify all inactive subscribers about the event */
-            notifyAllSubscribers(
-                    AGPS_EVENT_RELEASED, true,
-                    AGPS_NOTIFICATION_TYPE_FOR_INACTIVE_SUBSCRIBERS);
-
-            /* If we have active subscribers now, they must be waiting for
-             * data conn setup */
-            if (anyActiveSubscribers()) {
-                transitionState(AGPS_STATE_PENDING);
-                requestOrReleaseDataConn(true);
-            }
-            /* No active subscribers, move to released state */
-            else {
-                transitionState(AGPS_STATE_RELEASED);
-            }
-            break;
+void AgpsStateMachine::onReleasedOrDeniedInReleasing(AgpsEvent /*event*/){
 
-        case AGPS_STATE_PENDING:
-            /* NOOP */
-            break;
+    /* Notify all inactive subscribers about the event */
+    notifyAllSubscribers(
+            AGPS_EVENT_RELEASED, true,
+            AGPS_NOTIFICATION_TYPE_FOR_INACTIVE_SUBSCRIBERS);
 
-        default:
-            LOC_LOGE("Invalid state: %d", mState);
+    /* If we have active subscribers now, they must be waiting for
+     * data conn setup */
+    if (anyActiveSubscribers()) {
+        transitionState(AGPS_STATE_PENDING);
+        requestOrReleaseDataConn(true);
+    }
+    /* No active subscribers, move to released state */
+    else {
+        transitionState(AGPS_STATE_RELEASED);
     }
 }
 
-void AgpsStateMachine::processAgpsEventDenied(){
-
-    switch (mState) {
-
-        case AGPS_STATE_RELEASED:
-            LOC_LOGE("Unexpected event DENIED in state %d", mState);
-            break;
-
-        case AGPS_STATE_ACQUIRED:
-            /* NOOP */
-            break;
+void AgpsStateMachine::onDeniedInPending(AgpsEvent /*event*/){
 
-        case AGPS_STATE_RELEASING:
-            /* Notify all inactive subscribers about the event */
-            notifyAllSubscribers(
-                    AGPS_EVENT_RELEASED, true,
-                    AGPS_NOTIFICATION_TYPE_FOR_INACTIVE_SUBSCRIBERS);
-
-            /* If we have active subscribers now, they must be waiting for
-             * data conn setup */
-            if (anyActiveSubscribers()) {
-                transitionState(AGPS_STATE_PENDING);
-                requestOrReleaseDataConn(true);
-            }
-            /* No active subscribers, move to released state */
-            else {
-                transitionState(AGPS_STATE_RELEASED);
-            }
-            break;
+    transitionState(AGPS_STATE_RELEASED);
+    notifyAllSubscribers(
+            AGPS_EVENT_DENIED, true,
+            AGPS_NOTIFICATION_TYPE_FOR_ALL_SUBSCRIBERS);
+}
 
-        case AGPS_STATE_PENDING:
-            transitionState(AGPS_STATE_RELEASED);
-            notifyAllSubscribers(
-                    AGPS_EVENT_DENIED, true,
-                    AGPS_NOTIFICATION_TYPE_FOR_ALL_SUBSCRIBERS);
-            break;
+void AgpsStateMachine::onUnexpectedEvent(AgpsEvent event){
 
-        default:
-            LOC_LOGE("Invalid state: %d", mState);
-    }
+    LOC_LOGE("Unexpected event %d in state %d", event, mState);
 }
 
 /* Request or Release data connection
@@ -315,10 +275,12 @@ void AgpsStateMachine::notifyAllSubscribers(
             "SM %p, Event %d Delete %d Notification Type %d",
             this, event, deleteSubscriberPostNotify, notificationType);
 
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    while ( it != mSubscriberList.end() ) {
+    /* Notified subscribers to be deleted are dropped while walking the
+     * table; the survivors are moved up, keeping their order */
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < mSubscriberCount; i++) {
 
-        AgpsSubscriber* subscriber = *it;
+        AgpsSubscriber* subscriber = &mSubscribers[i];
 
         if (notificationType == AGPS_NOTIFICATION_TYPE_FOR_ALL_SUBSCRIBERS ||
                 (notificationType == AGPS_NOTIFICATION_TYPE_FOR_INACTIVE_SUBSCRIBERS &&
@@ -331,15 +293,15 @@ void AgpsStateMachine::notifyAllSubscribers(
             notifyEventToSubscriber(event, subscriber, false);
 
             if (deleteSubscriberPostNotify) {
-                it = mSubscriberList.erase(it);
-                delete subscriber;
-            } else {
-                it++;
+                continue;
             }
-        } else {
-            it++;
         }
+        if (kept != i) {
+            mSubscribers[kept] = *subscriber;
+        }
+        kept++;
     }
+    mSubscriberCount = kept;
 }
 
 void AgpsStateMachine::notifyEventToSubscriber(
@@ -389,52 +351,52 @@ void AgpsStateMachine::transitionState(AgpsState newState){
     // notify state transitions to all subscribers ?
 }
 
-void AgpsStateMachine::addSubscriber(AgpsSubscriber* subscriberToAdd){
+bool AgpsStateMachine::addSubscriber(const AgpsSubscriber* subscriberToAdd){
 
-    LOC_LOGD("addSubscriber(): SM %p, Subscriber %p",
-               this, subscriberToAdd);
+    LOC_LOGD("addSubscriber(): SM %p, connHandle %d",
+               this, subscriberToAdd->mConnHandle);
 
     // Check if subscriber is already present in the current list
     // If not, then add
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    for (; it != mSubscriberList.end(); it++) {
-        AgpsSubscriber* subscriber = *it;
-        if (subscriber->equals(subscriberToAdd)) {
-            LOC_LOGE("Subscriber already in list");
-            return;
-        }
+    if (NULL != getSubscriber(subscriberToAdd->mConnHandle)) {
+        LOC_LOGE("Subscriber already in list");
+        return true;
+    }
+
+    if (mSubscriberCount >= MAX_AGPS_SUBSCRIBERS) {
+        LOC_LOGE("Subscriber table full (%d), dropping connHandle %d",
+                 MAX_AGPS_SUBSCRIBERS, subscriberToAdd->mConnHandle);
+        return false;
     }
 
-    AgpsSubscriber* cloned = subscriberToAdd->clone();
-    LOC_LOGD("addSubscriber(): cloned subscriber: %p", cloned);
-    mSubscriberList.push_back(cloned);
+    mSubscribers[mSubscriberCount++] = *subscriberToAdd;
+    return true;
 }
 
 void AgpsStateMachine::deleteSubscriber(AgpsSubscriber* subscriberToDelete){
 
-    LOC_LOGD("deleteSubscriber(): SM %p, Subscriber %p",
-               this, subscriberToDelete);
-
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    while ( it != mSubscriberList.end() ) {
-
-        AgpsSubscriber* subscriber = *it;
-        if (subscriber && subscriber->equals(subscriberToDelete)) {
-
-            it = mSubscriberList.erase(it);
-            delete subscriber;
-        } else {
-            it++;
+    LOC_LOGD("deleteSubscriber(): SM %p, connHandle %d",
+               this, subscriberToDelete->mConnHandle);
+
+    /* subscriberToDelete may point into the table itself,
+     * so take the handle before moving entries */
+    int connHandle = subscriberToDelete->mConnHandle;
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < mSubscriberCount; i++) {
+        if (mSubscribers[i].mConnHandle != connHandle) {
+            if (kept != i) {
+                mSubscribers[kept] = mSubscribers[i];
+            }
+            kept++;
         }
     }
+    mSubscriberCount = kept;
 }
 
 bool AgpsStateMachine::anyActiveSubscribers(){
 
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    for (; it != mSubscriberList.end(); it++) {
-        AgpsSubscriber* subscriber = *it;
-        if (!subscriber->mIsInactive) {
+    for (uint32_t i = 0; i < mSubscriberCount; i++) {
+        if (!mSubscribers[i].mIsInactive) {
             return true;
         }
     }
@@ -443,33 +405,25 @@ bool AgpsStateMachine::anyActiveSubscribers(){
 
 void AgpsStateMachine::setAPN(char* apn, unsigned int len){
 
-    if (NULL != mAPN) {
-        delete mAPN;
-        mAPN  = NULL;
-    }
-
     if (NULL == apn || len > MAX_APN_LEN || strlen(apn) != len) {
         LOC_LOGD("Invalid apn len (%d) or null apn", len);
-        mAPN = NULL;
+        mAPN[0] = '\0';
         mAPNLen = 0;
+        mAPNValid = false;
     } else {
-        mAPN = new char[len+1];
-        if (NULL != mAPN) {
-            memcpy(mAPN, apn, len);
-            mAPN[len] = '\0';
-            mAPNLen = len;
-        }
+        memcpy(mAPN, apn, len);
+        mAPN[len] = '\0';
+        mAPNLen = len;
+        mAPNValid = true;
     }
 }
 
 AgpsSubscriber* AgpsStateMachine::getSubscriber(int connHandle){
 
-    /* Go over the subscriber list */
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    for (; it != mSubscriberList.end(); it++) {
-        AgpsSubscriber* subscriber = *it;
-        if (subscriber->mConnHandle == connHandle) {
-            return subscriber;
+    /* Go over the subscriber table */
+    for (uint32_t i = 0; i < mSubscriberCount; i++) {
+        if (mSubscribers[i].mConnHandle == connHandle) {
+            return &mSubscribers[i];
         }
     }
 
@@ -479,12 +433,10 @@ AgpsSubscriber* AgpsStateMachine::getSubscriber(int connHandle){
 
 AgpsSubscriber* AgpsStateMachine::getFirstSubscriber(bool isInactive){
 
-    /* Go over the subscriber list */
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    for (; it != mSubscriberList.end(); it++) {
-        AgpsSubscriber* subscriber = *it;
-        if(subscriber->mIsInactive == isInactive) {
-            return subscriber;
+    /* Go over the subscriber table */
+    for (uint32_t i = 0; i < mSubscriberCount; i++) {
+        if (mSubscribers[i].mIsInactive == isInactive) {
+            return &mSubscribers[i];
         }
     }
 
@@ -496,13 +448,7 @@ void AgpsStateMachine::dropAllSubscribers(){
 
     LOC_LOGD("dropAllSubscribers(): SM %p", this);
 
-    /* Go over the subscriber list */
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    while ( it != mSubscriberList.end() ) {
-        AgpsSubscriber* subscriber = *it;
-        it = mSubscriberList.erase(it);
-        delete subscriber;
-    }
+    mSubscriberCount = 0;
 }
 
 /* --------------------------------------------------------------------
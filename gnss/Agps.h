@@ -31,7 +31,6 @@
 #define AGPS_H
 
 #include <functional>
-#include <list>
 #include <MsgTask.h>
 #include <gps_extended_c.h>
 #include <loc_pla.h>
@@ -90,7 +89,9 @@ class AgpsStateMachine;
 
 /* SUBSCRIBER
  * Each Subscriber instance corresponds to one AGPS request,
- * received by the AGPS state machine */
+ * received by the AGPS state machine.
+ * Subscribers are plain values, copied into the state machine's
+ * fixed subscriber table; no heap copy is made per request. */
 class AgpsSubscriber {
 
 public:
@@ -104,6 +105,9 @@ public:
     bool mIsInactive;
     LocApnTypeMask mApnTypeMask;
 
+    inline AgpsSubscriber() :
+            mConnHandle(-1), mWaitForCloseComplete(false),
+            mIsInactive(false), mApnTypeMask(0) {}
     inline AgpsSubscriber(
             int connHandle, bool waitForCloseComplete, bool isInactive,
             LocApnTypeMask apnTypeMask) :
@@ -111,26 +115,26 @@ public:
             mWaitForCloseComplete(waitForCloseComplete),
             mIsInactive(isInactive),
             mApnTypeMask(apnTypeMask) {}
-    inline virtual ~AgpsSubscriber() {}
 
-    inline virtual bool equals(const AgpsSubscriber *s) const
+    inline bool equals(const AgpsSubscriber *s) const
     { return (mConnHandle == s->mConnHandle); }
-
-    inline virtual AgpsSubscriber* clone()
-    { return new AgpsSubscriber(
-            mConnHandle, mWaitForCloseComplete, mIsInactive, mApnTypeMask); }
 };
 
+/* Max number of outstanding ATL requests per state machine */
+#define MAX_AGPS_SUBSCRIBERS 16
+
 /* AGPS STATE MACHINE */
 class AgpsStateMachine {
 protected:
     /* AGPS Manager instance, from where this state machine is created */
     AgpsManager* mAgpsManager;
 
-    /* List of all subscribers for this State Machine.
-     * Once a subscriber is notified for ATL open/close status,
-     * it is deleted */
-    std::list<AgpsSubscriber*> mSubscriberList;
+    /* Table of all subscribers for this State Machine, in arrival order,
+     * keyed by mConnHandle. Only the first mSubscriberCount entries are
+     * in use. Once a subscriber is notified for ATL open/close status,
+     * it is removed and the entries behind it move up. */
+    AgpsSubscriber mSubscribers[MAX_AGPS_SUBSCRIBERS];
+    uint32_t mSubscriberCount;
 
     /* Current subscriber, whose request this State Machine is
      * currently processing */
@@ -150,24 +154,30 @@ private:
     LocApnTypeMask mApnTypeMask;
 
     /* APN and IP Type info for AGPS Call */
-    char* mAPN;
+    char mAPN[MAX_APN_LEN + 1];
     unsigned int mAPNLen;
+    bool mAPNValid;
     AGpsBearerType mBearer;
 
+    /* Handler for one (state, event) cell of the transition table */
+    typedef void (AgpsStateMachine::*TransitionHandler)(AgpsEvent event);
+    static const TransitionHandler
+            sTransitionTable[AGPS_STATE_RELEASING + 1][AGPS_EVENT_DENIED + 1];
+
 public:
     /* CONSTRUCTOR */
     AgpsStateMachine(AgpsManager* agpsManager, AGpsExtType agpsType):
-        mFrameworkStatusV4Cb(NULL),
-        mAgpsManager(agpsManager), mSubscriberList(),
+        mAgpsManager(agpsManager), mSubscriberCount(0),
         mCurrentSubscriber(NULL), mState(AGPS_STATE_RELEASED),
-        mAgpsType(agpsType), mAPN(NULL), mAPNLen(0),
-        mBearer(AGPS_APN_BEARER_INVALID) {};
+        mFrameworkStatusV4Cb(NULL),
+        mAgpsType(agpsType), mApnTypeMask(0), mAPNLen(0), mAPNValid(false),
+        mBearer(AGPS_APN_BEARER_INVALID) { mAPN[0] = '\0'; };
 
-    virtual ~AgpsStateMachine() { if(NULL != mAPN) delete[] mAPN; };
+    virtual ~AgpsStateMachine() {}
 
     /* Getter/Setter methods */
     void setAPN(char* apn, unsigned int len);
-    inline char* getAPN() const { return mAPN; }
+    inline char* getAPN() { return mAPNValid ? mAPN : NULL; }
     inline uint32_t getAPNLen() const { return mAPNLen; }
     inline void setBearer(AGpsBearerType bearer) { mBearer = bearer; }
     inline LocApnTypeMask getApnTypeMask() const { return mApnTypeMask; }
@@ -199,8 +209,7 @@ public:
     void dropAllSubscribers();
 
 protected:
-    /* Remove the specified subscriber from list if present.
-     * Also delete the subscriber instance. */
+    /* Remove the specified subscriber from list if present. */
     void deleteSubscriber(AgpsSubscriber* subscriber);
 
 private:
@@ -209,16 +218,27 @@ private:
      * sendRsrcRequest(LOC_GPS_RELEASE_AGPS_DATA_CONN) */
     void requestOrReleaseDataConn(bool request);
 
-    /* Individual event processing methods */
-    void processAgpsEventSubscribe();
-    void processAgpsEventUnsubscribe();
-    void processAgpsEventGranted();
-    void processAgpsEventReleased();
-    void processAgpsEventDenied();
-
-    /* Clone the passed in subscriber and add to the subscriber list
-     * if not already present */
-    void addSubscriber(AgpsSubscriber* subscriber);
+    /* Transition table handlers, named after the (event, state)
+     * cells they serve */
+    void onSubscribeInReleased(AgpsEvent event);
+    void onSubscribeInAcquired(AgpsEvent event);
+    void onSubscribeQueued(AgpsEvent event);
+    void onUnsubscribeInReleased(AgpsEvent event);
+    void onUnsubscribeInPendingOrAcquired(AgpsEvent event);
+    void onUnsubscribeInReleasing(AgpsEvent event);
+    void onGrantedInPending(AgpsEvent event);
+    void onReleasedInReleased(AgpsEvent event);
+    void onReleasedInAcquired(AgpsEvent event);
+    void onReleasedOrDeniedInReleasing(AgpsEvent event);
+    void onDeniedInPending(AgpsEvent event);
+    void onUnexpectedEvent(AgpsEvent event);
+
+    /* Unsubscribe handling shared by PENDING, ACQUIRED and RELEASING */
+    void unsubscribeCurrentSubscriber();
+
+    /* Copy the passed in subscriber into the subscriber table
+     * if not already present. Returns false if the table is full. */
+    bool addSubscriber(const AgpsSubscriber* subscriber);
 
     /* Notify subscribers about AGPS events */
     void notifyAllSubscribers(
@@ -47,6 +47,7 @@
 #include <SystemStatus.h>
 #include <vector>
 #include <loc_misc_utils.h>
+#include <LocWorkAccounting.h>
 #include <gps_extended_c.h>
 
 #define RAD2DEG    (180.0 / M_PI)
@@ -60,6 +61,12 @@
 
 #define DGNSS_RANGE_UPDATE_TIME_10MIN_IN_MILLI  600000
 
+// coalesce keys of the report msgs only carrying the latest state,
+// the lower 32 bits are available for a per report sub key
+#define COALESCE_KEY_REPORT_SV               (1ULL << 32)
+#define COALESCE_KEY_REPORT_NMEA             (2ULL << 32)
+#define COALESCE_KEY_REPORT_MEASUREMENT      (3ULL << 32)
+
 using namespace loc_core;
 
 static int loadEngHubForExternalEngine = 0;
@@ -117,6 +124,9 @@ GnssAdapter::GnssAdapter() :
     mOdcpiRequestActive(false),
     mOdcpiTimer(this),
     mOdcpiRequest(),
+    mOdcpiCachedLocation(),
+    mOdcpiCachedLocationTime(0),
+    mOdcpiStats(),
     mCallbackPriority(OdcpiPrioritytype::ODCPI_HANDLER_PRIORITY_LOW),
     mSystemStatus(SystemStatus::getInstance(mMsgTask)),
     mServerUrl(":"),
@@ -2587,6 +2597,9 @@ GnssAdapter::handleEngineUpEvent()
             mAdapter.initCDFWService();
             // restart sessions
             mAdapter.restartSessions(true);
+            // tracking is issued above, so geofence and batching replay can follow
+            mAdapter.mLocApi->getEngineStateSnapshot().submit(ENGINE_REPLAY_PRIORITY_TRACKING,
+                                                               *mAdapter.getMsgTask(), {});
             for (auto msg: mAdapter.mPendingMsgs) {
                 mAdapter.sendMsg(msg);
             }
@@ -2594,6 +2607,7 @@ GnssAdapter::handleEngineUpEvent()
         }
     };
 
+    mLocApi->getEngineStateSnapshot().expect(ENGINE_REPLAY_PRIORITY_TRACKING);
     readConfigCommand();
     sendMsg(new MsgHandleEngineUpEvent(*this));
 }
@@ -2660,32 +2674,12 @@ void GnssAdapter::checkAndRestartTimeBasedSession()
 {
     LOC_LOGD("%s]: ", __func__);
 
-    if (!mTimeBasedTrackingSessions.empty()) {
-        // get the LocationOptions that has the smallest interval, which should be the active one
-        TrackingOptions smallestIntervalOptions; // size is zero until set for the first time
-        TrackingOptions highestPowerTrackingOptions;
-        memset(&smallestIntervalOptions, 0, sizeof(smallestIntervalOptions));
-        memset(&highestPowerTrackingOptions, 0, sizeof(highestPowerTrackingOptions));
-        for (auto it = mTimeBasedTrackingSessions.begin();
-                it != mTimeBasedTrackingSessions.end(); ++it) {
-            // size of zero means we havent set it yet
-            if (0 == smallestIntervalOptions.size ||
-                it->second.minInterval < smallestIntervalOptions.minInterval) {
-                 smallestIntervalOptions = it->second;
-            }
-            GnssPowerMode powerMode = it->second.powerMode;
-            // Size of zero means we havent set it yet
-            if (0 == highestPowerTrackingOptions.size ||
-                (GNSS_POWER_MODE_INVALID != powerMode &&
-                        powerMode < highestPowerTrackingOptions.powerMode)) {
-                 highestPowerTrackingOptions = it->second;
-            }
-        }
-
-        highestPowerTrackingOptions.setLocationOptions(smallestIntervalOptions);
+    TrackingOptions multiplexedOptions;
+    if (mTrackingMultiplexer.getAggregate(multiplexedOptions)) {
+        mTrackingMultiplexer.setApplied(multiplexedOptions);
         // want to run SPE session at a fixed min interval in some automotive scenarios
-        if(!checkAndSetSPEToRunforNHz(highestPowerTrackingOptions)) {
-            mLocApi->startTimeBasedTracking(highestPowerTrackingOptions, nullptr);
+        if(!checkAndSetSPEToRunforNHz(multiplexedOptions)) {
+            mLocApi->startTimeBasedTracking(multiplexedOptions, nullptr);
         }
     }
 }
@@ -2846,6 +2840,7 @@ GnssAdapter::saveTrackingSession(LocationAPI* client, uint32_t sessionId,
         mDistanceBasedTrackingSessions[key] = options;
     } else {
         mTimeBasedTrackingSessions[key] = options;
+        mTrackingMultiplexer.addSession(key, options);
     }
     reportPowerStateIfChanged();
 }
@@ -2857,6 +2852,7 @@ GnssAdapter::eraseTrackingSession(LocationAPI* client, uint32_t sessionId)
     auto it = mTimeBasedTrackingSessions.find(key);
     if (it != mTimeBasedTrackingSessions.end()) {
         mTimeBasedTrackingSessions.erase(it);
+        mTrackingMultiplexer.removeSession(key);
     } else {
         auto itr = mDistanceBasedTrackingSessions.find(key);
         if (itr != mDistanceBasedTrackingSessions.end()) {
@@ -3017,38 +3013,12 @@ GnssAdapter::startTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t sessi
         // need to wait for QMI callback
         reportToClientWithNoWait = false;
     } else {
-        // find the smallest interval and powerMode
-        TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-        GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-        memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-        for (auto it = mTimeBasedTrackingSessions.begin(); it != mTimeBasedTrackingSessions.end(); ++it) {
-            // if not set or there is a new smallest interval, then set the new interval
-            if (0 == multiplexedOptions.size ||
-                it->second.minInterval < multiplexedOptions.minInterval) {
-                multiplexedOptions = it->second;
-            }
-            // if session is not the one we are updating and either powerMode
-            // is not set or there is a new smallest powerMode, then set the new powerMode
-            if (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                it->second.powerMode < multiplexedPowerMode) {
-                multiplexedPowerMode = it->second.powerMode;
-            }
-        }
-        bool updateOptions = false;
-        // if session we are starting has smaller interval then next smallest
-        if (options.minInterval < multiplexedOptions.minInterval) {
-            multiplexedOptions.minInterval = options.minInterval;
-            updateOptions = true;
-        }
-
-        // if session we are starting has smaller powerMode then next smallest
-        if (options.powerMode < multiplexedPowerMode) {
-            multiplexedOptions.powerMode = options.powerMode;
-            updateOptions = true;
-        }
-        if (updateOptions) {
+        // aggregate of the ongoing sessions plus the session we are starting
+        TrackingOptions multiplexedOptions;
+        LocationSessionKey key(client, sessionId);
+        mTrackingMultiplexer.getAggregate(multiplexedOptions, &key, &options);
+        if (!mTrackingMultiplexer.isApplied(multiplexedOptions)) {
             // restart time based tracking with the newly updated options
-
             startTimeBasedTracking(client, sessionId, multiplexedOptions);
             // need to wait for QMI callback
             reportToClientWithNoWait = false;
@@ -3070,6 +3040,10 @@ GnssAdapter::startTimeBasedTracking(LocationAPI* client, uint32_t sessionId,
     convertOptions(locPosMode, trackingOptions);
     // save position mode parameters
     setLocPositionMode(locPosMode);
+    // the options last accepted by the engine, restored if these are rejected
+    TrackingOptions prevApplied;
+    bool prevAppliedValid = mTrackingMultiplexer.getApplied(prevApplied);
+    mTrackingMultiplexer.setApplied(trackingOptions);
     // inform engine hub that GNSS session is about to start
     mEngHubProxy->gnssSetFixMode(mLocPositionMode);
     mEngHubProxy->gnssStartFix();
@@ -3080,9 +3054,11 @@ GnssAdapter::startTimeBasedTracking(LocationAPI* client, uint32_t sessionId,
     TrackingOptions tempOptions(trackingOptions);
     if (!checkAndSetSPEToRunforNHz(tempOptions)) {
         mLocApi->startTimeBasedTracking(tempOptions, new LocApiResponse(*getContext(),
-                          [this, client, sessionId] (LocationError err) {
+                          [this, client, sessionId, sent = trackingOptions, prevApplied,
+                           prevAppliedValid] (LocationError err) {
                 if (LOCATION_ERROR_SUCCESS != err) {
                     eraseTrackingSession(client, sessionId);
+                    mTrackingMultiplexer.restoreApplied(sent, prevApplied, prevAppliedValid);
                 } else {
                     checkUpdateDgnssNtrip(false);
                 }
@@ -3104,6 +3080,10 @@ GnssAdapter::updateTracking(LocationAPI* client, uint32_t sessionId,
     convertOptions(locPosMode, updatedOptions);
     // save position mode parameters
     setLocPositionMode(locPosMode);
+    // the options last accepted by the engine, restored if these are rejected
+    TrackingOptions prevApplied;
+    bool prevAppliedValid = mTrackingMultiplexer.getApplied(prevApplied);
+    mTrackingMultiplexer.setApplied(updatedOptions);
 
     // inform engine hub that GNSS session is about to start
     mEngHubProxy->gnssSetFixMode(mLocPositionMode);
@@ -3115,10 +3095,12 @@ GnssAdapter::updateTracking(LocationAPI* client, uint32_t sessionId,
     TrackingOptions tempOptions(updatedOptions);
     if(!checkAndSetSPEToRunforNHz(tempOptions)) {
         mLocApi->startTimeBasedTracking(tempOptions, new LocApiResponse(*getContext(),
-                          [this, client, sessionId, oldOptions] (LocationError err) {
+                          [this, client, sessionId, oldOptions, sent = updatedOptions,
+                           prevApplied, prevAppliedValid] (LocationError err) {
                 if (LOCATION_ERROR_SUCCESS != err) {
                     // restore the old LocationOptions
                     saveTrackingSession(client, sessionId, oldOptions);
+                    mTrackingMultiplexer.restoreApplied(sent, prevApplied, prevAppliedValid);
                 }
                 reportResponse(client, err, sessionId);
             }
@@ -3258,55 +3240,19 @@ GnssAdapter::updateTrackingMultiplex(LocationAPI* client, uint32_t id,
     // get the session we are updating
     auto it = mTimeBasedTrackingSessions.find(key);
 
-    // cache the clients existing LocationOptions
-    TrackingOptions oldOptions = it->second;
-
-    // if session we are updating exists and the minInterval or powerMode has changed
-    if (it != mTimeBasedTrackingSessions.end() &&
-       (it->second.minInterval != trackingOptions.minInterval ||
-        it->second.powerMode != trackingOptions.powerMode)) {
-        // find the smallest interval and powerMode, other than the session we are updating
-        TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-        GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-        memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-        for (auto it2 = mTimeBasedTrackingSessions.begin();
-             it2 != mTimeBasedTrackingSessions.end(); ++it2) {
-            // if session is not the one we are updating and either interval
-            // is not set or there is a new smallest interval, then set the new interval
-            if (it2->first != key && (0 == multiplexedOptions.size ||
-                it2->second.minInterval < multiplexedOptions.minInterval)) {
-                 multiplexedOptions = it2->second;
-            }
-            // if session is not the one we are updating and either powerMode
-            // is not set or there is a new smallest powerMode, then set the new powerMode
-            if (it2->first != key && (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                it2->second.powerMode < multiplexedPowerMode)) {
-                multiplexedPowerMode = it2->second.powerMode;
-            }
-            // else part: no QMI call is made, need to report back to client right away
-        }
-        bool updateOptions = false;
-        // if session we are updating has smaller interval then next smallest
-        if (trackingOptions.minInterval < multiplexedOptions.minInterval) {
-            multiplexedOptions.minInterval = trackingOptions.minInterval;
-            updateOptions = true;
-        }
-        // if session we are updating has smaller powerMode then next smallest
-        if (trackingOptions.powerMode < multiplexedPowerMode) {
-            multiplexedOptions.powerMode = trackingOptions.powerMode;
-            updateOptions = true;
-        }
-        // if only one session exists, then tracking should be updated with it
-        if (1 == mTimeBasedTrackingSessions.size()) {
-            multiplexedOptions = trackingOptions;
-            updateOptions = true;
-        }
-        if (updateOptions) {
+    if (it != mTimeBasedTrackingSessions.end()) {
+        // cache the clients existing LocationOptions
+        TrackingOptions oldOptions = it->second;
+        // aggregate of the other sessions plus the updated options of this session
+        TrackingOptions multiplexedOptions;
+        mTrackingMultiplexer.getAggregate(multiplexedOptions, &key, &trackingOptions);
+        if (!mTrackingMultiplexer.isApplied(multiplexedOptions)) {
             // restart time based tracking with the newly updated options
             updateTracking(client, id, multiplexedOptions, oldOptions);
             // need to wait for QMI callback
             reportToClientWithNoWait = false;
         }
+        // else part: no QMI call is made, need to report back to client right away
     }
 
     return reportToClientWithNoWait;
@@ -3372,6 +3318,7 @@ GnssAdapter::stopTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t id)
 
     if (1 == mTimeBasedTrackingSessions.size()) {
         stopTracking(client, id);
+        mTrackingMultiplexer.resetApplied();
         // need to wait for QMI callback
         reportToClientWithNoWait = false;
     } else {
@@ -3380,30 +3327,10 @@ GnssAdapter::stopTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t id)
         // get the session we are stopping
         auto it = mTimeBasedTrackingSessions.find(key);
         if (it != mTimeBasedTrackingSessions.end()) {
-            // find the smallest interval and powerMode, other than the session we are stopping
-            TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-            GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-            memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-            for (auto it2 = mTimeBasedTrackingSessions.begin();
-                 it2 != mTimeBasedTrackingSessions.end(); ++it2) {
-                // if session is not the one we are stopping and either interval
-                // is not set or there is a new smallest interval, then set the new interval
-                if (it2->first != key && (0 == multiplexedOptions.size ||
-                    it2->second.minInterval < multiplexedOptions.minInterval)) {
-                     multiplexedOptions = it2->second;
-                }
-                // if session is not the one we are stopping and either powerMode
-                // is not set or there is a new smallest powerMode, then set the new powerMode
-                if (it2->first != key && (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                    it2->second.powerMode < multiplexedPowerMode)) {
-                    multiplexedPowerMode = it2->second.powerMode;
-                }
-            }
-            // if session we are stopping has smaller interval then next smallest or
-            // if session we are stopping has smaller powerMode then next smallest
-            if (it->second.minInterval < multiplexedOptions.minInterval ||
-                it->second.powerMode < multiplexedPowerMode) {
-                multiplexedOptions.powerMode = multiplexedPowerMode;
+            // aggregate of the sessions other than the one we are stopping
+            TrackingOptions multiplexedOptions;
+            if (mTrackingMultiplexer.getAggregate(multiplexedOptions, &key) &&
+                    !mTrackingMultiplexer.isApplied(multiplexedOptions)) {
                 // restart time based tracking with the newly updated options
                 startTimeBasedTracking(client, id, multiplexedOptions);
                 // need to wait for QMI callback
@@ -3976,6 +3903,7 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
         for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
             if ((reportToFlpClient && isFlpClient(it->second)) ||
                     (reportToGnssClient && !isFlpClient(it->second))) {
+                LocWorkAccounting::ClientCallbackScope accounting(it->first);
                 if (nullptr != it->second.gnssLocationInfoCb) {
                     it->second.gnssLocationInfoCb(locationInfo);
                 } else if ((nullptr != it->second.engineLocationsInfoCb) &&
@@ -4127,6 +4055,7 @@ GnssAdapter::reportEnginePositions(unsigned int count,
     if (needReportEnginePositions) {
         for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
             if (nullptr != it->second.engineLocationsInfoCb) {
+                LocWorkAccounting::ClientCallbackScope accounting(it->first);
                 it->second.engineLocationsInfoCb(count, locationInfo);
             }
         }
@@ -4155,6 +4084,12 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
         inline virtual void proc() const {
             mAdapter.reportSv((GnssSvNotification&)mSvNotify);
         }
+        inline virtual uint64_t getCoalesceKey() const override {
+            return COALESCE_KEY_REPORT_SV;
+        }
+        inline virtual const void* getCoalesceOwner() const override {
+            return &mAdapter;
+        }
     };
 
     sendMsg(new MsgReportSv(*this, svNotify));
@@ -4301,6 +4236,7 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
 
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.gnssSvCb) {
+            LocWorkAccounting::ClientCallbackScope accounting(it->first);
             it->second.gnssSvCb(svNotify);
         }
     }
@@ -4333,13 +4269,15 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
         GnssAdapter& mAdapter;
         const char* mNmea;
         size_t mLength;
+        uint32_t mSentenceKey;
         inline MsgReportNmea(GnssAdapter& adapter,
                              const char* nmea,
                              size_t length) :
             LocMsg(),
             mAdapter(adapter),
             mNmea(new char[length+1]),
-            mLength(length) {
+            mLength(length),
+            mSentenceKey(loc_nmea_get_sentence_key(nmea, length)) {
                 if (mNmea == nullptr) {
                     LOC_LOGE("%s] new allocation failed, fatal error.", __func__);
                     return;
@@ -4364,6 +4302,12 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
                 mAdapter.reportGGAToNtrip(mNmea);
             }
         }
+        inline virtual uint64_t getCoalesceKey() const override {
+            return (0 == mSentenceKey) ? 0 : (COALESCE_KEY_REPORT_NMEA | mSentenceKey);
+        }
+        inline virtual const void* getCoalesceOwner() const override {
+            return &mAdapter;
+        }
     };
 
     sendMsg(new MsgReportNmea(*this, nmea, length));
@@ -4381,9 +4325,11 @@ GnssAdapter::reportNmea(const char* nmea, size_t length)
     nmeaNotification.timestamp = now;
     nmeaNotification.nmea = nmea;
     nmeaNotification.length = length;
+    LocWorkAccounting::getInstance().addNmeaBytes(length);
 
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.gnssNmeaCb) {
+            LocWorkAccounting::ClientCallbackScope accounting(it->first);
             it->second.gnssNmeaCb(nmeaNotification);
         }
     }
@@ -4436,6 +4382,7 @@ GnssAdapter::reportData(GnssDataNotification& dataNotify)
     }
     for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.gnssDataCb) {
+            LocWorkAccounting::ClientCallbackScope accounting(it->first);
             it->second.gnssDataCb(dataNotify);
         }
     }
@@ -4744,6 +4691,12 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
             inline virtual void proc() const {
                 mAdapter.reportGnssMeasurementData(mMeasurementsNotify);
             }
+            inline virtual uint64_t getCoalesceKey() const override {
+                return COALESCE_KEY_REPORT_MEASUREMENT;
+            }
+            inline virtual const void* getCoalesceOwner() const override {
+                return &mAdapter;
+            }
         };
 
         sendMsg(new MsgReportGnssMeasurementData(*this, gnssMeasurements, msInWeek));
@@ -4759,6 +4712,7 @@ GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsNotification& measu
 {
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.gnssMeasurementsCb) {
+            LocWorkAccounting::ClientCallbackScope accounting(it->first);
             it->second.gnssMeasurementsCb(measurements);
         }
     }
@@ -4830,8 +4784,21 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
         // so the mOdcpiTimer helps avoid spamming the framework as well as
         // extending the odcpi session past 30 seconds if needed
         if (ODCPI_REQUEST_TYPE_START == request.type) {
+            if (request.isEmergencyMode) {
+                mOdcpiStats.emergencyRequests++;
+            }
             if (false == mOdcpiRequestActive && false == mOdcpiTimer.isActive()) {
-                mOdcpiRequestCb(request);
+                // a fresh enough location from the last injection answers a
+                // non-emergency request right away without asking the framework,
+                // the timer still runs so the framework is asked on expiry if the
+                // modem keeps the request active. Emergency requests always go
+                // to the framework, with the cached location injected meanwhile
+                if (injectOdcpiFromCache() && false == request.isEmergencyMode) {
+                    mOdcpiStats.cacheHits++;
+                } else {
+                    mOdcpiRequestCb(request);
+                    mOdcpiStats.frameworkRequests++;
+                }
                 mOdcpiRequestActive = true;
                 mOdcpiTimer.start();
             // if the current active odcpi session is non-emergency, and the new
@@ -4839,7 +4806,9 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
             // and restart the timer
             } else if (false == mOdcpiRequest.isEmergencyMode &&
                        true == request.isEmergencyMode) {
+                injectOdcpiFromCache();
                 mOdcpiRequestCb(request);
+                mOdcpiStats.frameworkRequests++;
                 mOdcpiRequestActive = true;
                 if (true == mOdcpiTimer.isActive()) {
                     mOdcpiTimer.restart();
@@ -4851,8 +4820,14 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
             // before requesting new ODCPI to avoid spamming ODCPI requests
             } else if (false == mOdcpiRequestActive && true == mOdcpiTimer.isActive()) {
                 mOdcpiRequestActive = true;
+                mOdcpiStats.mergedRequests++;
+            } else {
+                mOdcpiStats.mergedRequests++;
             }
             mOdcpiRequest = request;
+            LOC_LOGd("framework requests %u emergency %u merged %u cache hits %u",
+                     mOdcpiStats.frameworkRequests, mOdcpiStats.emergencyRequests,
+                     mOdcpiStats.mergedRequests, mOdcpiStats.cacheHits);
         // the request is being stopped, but allow timer to expire first
         // before stopping the timer just in case more ODCPI requests come
         // to avoid spamming more odcpi requests to the framework
@@ -4974,6 +4949,43 @@ void GnssAdapter::injectOdcpi(const Location& location)
             location.latitude, location.longitude);
 
     mLocApi->injectPosition(location, true);
+
+    if (location.flags & LOCATION_HAS_ACCURACY_BIT) {
+        mOdcpiCachedLocation = location;
+        // boot time keeps counting through suspend; back-date it by the age the
+        // location already had when it was injected
+        mOdcpiCachedLocationTime = getBootTimeMilliSec();
+        if (location.timestamp > 0) {
+            struct timeval tv;
+            gettimeofday(&tv, (struct timezone *) NULL);
+            uint64_t now = tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+            if (now > location.timestamp &&
+                now - location.timestamp < mOdcpiCachedLocationTime) {
+                mOdcpiCachedLocationTime -= now - location.timestamp;
+            }
+        }
+    }
+}
+
+bool GnssAdapter::injectOdcpiFromCache()
+{
+    if (0 == ContextBase::mGps_conf.ODCPI_CACHE_MAX_AGE_MSEC ||
+        0 == mOdcpiCachedLocationTime) {
+        return false;
+    }
+
+    uint64_t age = getBootTimeMilliSec() - mOdcpiCachedLocationTime;
+    if (age > ContextBase::mGps_conf.ODCPI_CACHE_MAX_AGE_MSEC ||
+        mOdcpiCachedLocation.accuracy >
+                ContextBase::mGps_conf.ODCPI_CACHE_MAX_ACCURACY_METERS) {
+        LOC_LOGd("cached location not usable, age %" PRIu64 " ms accuracy %.1f m",
+                 age, mOdcpiCachedLocation.accuracy);
+        return false;
+    }
+
+    LOC_LOGd("injecting cached location, age %" PRIu64 " ms", age);
+    mLocApi->injectPosition(mOdcpiCachedLocation, true);
+    return true;
 }
 
 // Called in the context of LocTimer thread
@@ -5007,6 +5019,7 @@ void GnssAdapter::odcpiTimerExpire()
     // expires, request again and restart timer
     if (mOdcpiRequestActive) {
         mOdcpiRequestCb(mOdcpiRequest);
+        mOdcpiStats.frameworkRequests++;
         mOdcpiTimer.restart();
     } else {
         mOdcpiTimer.stop();
@@ -5024,6 +5037,8 @@ GnssAdapter::invokeGnssEnergyConsumedCallback(uint64_t energyConsumedSinceFirstB
 bool
 GnssAdapter::reportGnssEngEnergyConsumedEvent(uint64_t energyConsumedSinceFirstBoot){
     LOC_LOGD("%s]: %" PRIu64 " ", __func__, energyConsumedSinceFirstBoot);
+    // kept for the AP work accounting, whether or not a client asked for it
+    LocWorkAccounting::getInstance().addEnergyReport(energyConsumedSinceFirstBoot);
 
     struct MsgReportGnssGnssEngEnergyConsumed : public LocMsg {
         GnssAdapter& mAdapter;
@@ -5060,7 +5075,6 @@ void GnssAdapter::initDefaultAgps() {
 
     if (cbInfo.statusV4Cb == nullptr) {
         LOC_LOGE("%s]: statusV4Cb is nullptr!", __func__);
-        dlclose(handle);
         return;
     }
 
@@ -5626,6 +5640,28 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
     convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_NAVIC, reports);
     LOC_LOGV("getDebugReport - satellite=%zu", r.mSatelliteInfo.size());
 
+    // scheduling policies applied to the location threads
+    r.mThreadPolicies.clear();
+    LocThread::getAppliedPolicies(r.mThreadPolicies);
+    LOC_LOGV("getDebugReport - thread policies:\n%s", r.mThreadPolicies.c_str());
+    r.mOdcpiStats = mOdcpiStats;
+    LOC_LOGV("getDebugReport - ODCPI framework requests %u emergency %u merged %u"
+             " cache hits %u", mOdcpiStats.frameworkRequests,
+             mOdcpiStats.emergencyRequests, mOdcpiStats.mergedRequests,
+             mOdcpiStats.cacheHits);
+    r.mAvoidedTrackingRestarts = mTrackingMultiplexer.getAvoidedRestarts();
+    LOC_LOGV("getDebugReport - avoided tracking restarts %u", r.mAvoidedTrackingRestarts);
+    r.mClockStats = ElapsedRealtimeClock::getInstance().getStats();
+    LOC_LOGV("getDebugReport - clock model samples %u steps %u sets %u error %" PRIi64
+             " ns max %" PRIi64 " ns drift %" PRIi64 " ppb", r.mClockStats.samples,
+             r.mClockStats.steps, r.mClockStats.realtimeSets, r.mClockStats.lastErrorNanos,
+             r.mClockStats.maxErrorNanos, r.mClockStats.driftPpb);
+
+    // AP side work of the location stack
+    r.mWorkAccounting.clear();
+    LocWorkAccounting::getInstance().dump(r.mWorkAccounting);
+    LOC_LOGV("getDebugReport - work accounting:\n%s", r.mWorkAccounting.c_str());
+
     return true;
 }
 
@@ -6523,7 +6559,6 @@ GnssAdapter::initEngHubProxy() {
     static bool firstTime = true;
     static bool engHubLoadSuccessful = false;
 
-    const char *error = nullptr;
     unsigned int processListLength = 0;
     loc_process_info_s_type* processInfoList = nullptr;
 
@@ -6569,10 +6604,10 @@ GnssAdapter::initEngHubProxy() {
         // load the engine hub .so, if the .so is not present
         // all EngHubProxyBase calls will turn into no-op.
         void *handle = nullptr;
-        if ((handle = dlopen("libloc_eng_hub.so", RTLD_NOW)) == nullptr) {
-            if ((error = dlerror()) != nullptr) {
-                LOC_LOGE("%s]: libloc_eng_hub.so not found %s !", __func__, error);
-            }
+        getEngHubProxyFn* getter = (getEngHubProxyFn*) dlGetSymFromLib(
+                handle, "libloc_eng_hub.so", "getEngHubProxy");
+        if (nullptr == handle) {
+            LOC_LOGE("%s]: libloc_eng_hub.so not found !", __func__);
             break;
         }
 
@@ -6619,7 +6654,6 @@ GnssAdapter::initEngHubProxy() {
             reportQwesCapabilities(featureMap);
         };
 
-        getEngHubProxyFn* getter = (getEngHubProxyFn*) dlsym(handle, "getEngHubProxy");
         if(getter != nullptr) {
             EngineHubProxyBase* hubProxy = (*getter) (mMsgTask, mSystemStatus->getOsObserver(),
                       reportPositionEventCb,
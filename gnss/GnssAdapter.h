@@ -42,6 +42,7 @@
 #include <loc_misc_utils.h>
 #include <queue>
 #include <NativeAgpsHandler.h>
+#include <TrackingMultiplexer.h>
 
 #define MAX_URL_LEN 256
 #define NMEA_SENTENCE_MAX_LENGTH 200
@@ -206,6 +207,7 @@ class GnssAdapter : public LocAdapterBase {
 
     /* ==== TRACKING ======================================================================= */
     TrackingOptionsMap mTimeBasedTrackingSessions;
+    TrackingMultiplexer mTrackingMultiplexer;
     LocationSessionMap mDistanceBasedTrackingSessions;
     LocPosMode mLocPositionMode;
     GnssSvUsedInPosition mGnssSvIdUsedInPosition;
@@ -260,7 +262,11 @@ class GnssAdapter : public LocAdapterBase {
     OdcpiPrioritytype mCallbackPriority;
     OdcpiTimer mOdcpiTimer;
     OdcpiRequestInfo mOdcpiRequest;
+    Location mOdcpiCachedLocation;
+    uint64_t mOdcpiCachedLocationTime;  // boot time of the cached fix, 0 if none
+    GnssDebugOdcpiStats mOdcpiStats;
     void odcpiTimerExpire();
+    bool injectOdcpiFromCache();
 
     /* ==== DELETEAIDINGDATA =============================================================== */
     int64_t mLastDeleteAidingDataTime;
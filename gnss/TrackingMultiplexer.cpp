@@ -0,0 +1,124 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_TrackingMultiplexer"
+
+#include <TrackingMultiplexer.h>
+#include <log_util.h>
+
+void TrackingMultiplexer::addSession(const LocationSessionKey& key,
+                                     const TrackingOptions& options)
+{
+    removeSession(key);
+    mSessions[key] = options;
+    mIntervals.emplace(options.minInterval, key);
+    mPowerModes.emplace(powerModeRank(options.powerMode), key);
+}
+
+void TrackingMultiplexer::removeSession(const LocationSessionKey& key)
+{
+    auto it = mSessions.find(key);
+    if (it != mSessions.end()) {
+        mIntervals.erase(IntervalEntry(it->second.minInterval, key));
+        mPowerModes.erase(PowerModeEntry(powerModeRank(it->second.powerMode), key));
+        mSessions.erase(it);
+    }
+}
+
+bool TrackingMultiplexer::getAggregate(TrackingOptions& aggregate,
+                                       const LocationSessionKey* excludedKey,
+                                       const TrackingOptions* candidate) const
+{
+    // the smallest entries other than the excluded session, at most 2 to visit
+    const TrackingOptions* intervalOptions = nullptr;
+    for (auto it = mIntervals.begin(); it != mIntervals.end(); ++it) {
+        if (nullptr == excludedKey || it->second != *excludedKey) {
+            intervalOptions = &mSessions.at(it->second);
+            break;
+        }
+    }
+    const TrackingOptions* powerOptions = nullptr;
+    for (auto it = mPowerModes.begin(); it != mPowerModes.end(); ++it) {
+        if (nullptr == excludedKey || it->second != *excludedKey) {
+            powerOptions = &mSessions.at(it->second);
+            break;
+        }
+    }
+
+    if (nullptr != candidate) {
+        if (nullptr == intervalOptions ||
+                candidate->minInterval < intervalOptions->minInterval) {
+            intervalOptions = candidate;
+        }
+        if (nullptr == powerOptions ||
+                powerModeRank(candidate->powerMode) < powerModeRank(powerOptions->powerMode)) {
+            powerOptions = candidate;
+        }
+    }
+
+    if (nullptr == intervalOptions || nullptr == powerOptions) {
+        return false;
+    }
+
+    aggregate = *powerOptions;
+    aggregate.setLocationOptions(*intervalOptions);
+    return true;
+}
+
+bool TrackingMultiplexer::isSameAsApplied(const TrackingOptions& options) const
+{
+    return mAppliedValid &&
+            mApplied.minInterval == options.minInterval &&
+            mApplied.minDistance == options.minDistance &&
+            mApplied.mode == options.mode &&
+            mApplied.locReqEngTypeMask == options.locReqEngTypeMask &&
+            mApplied.powerMode == options.powerMode &&
+            mApplied.tbm == options.tbm;
+}
+
+bool TrackingMultiplexer::isApplied(const TrackingOptions& aggregate)
+{
+    bool applied = isSameAsApplied(aggregate);
+    if (applied) {
+        mAvoidedRestarts++;
+        LOC_LOGd("aggregate unchanged, interval %u powerMode %u, avoided restarts %u",
+                 aggregate.minInterval, aggregate.powerMode, mAvoidedRestarts);
+    }
+    return applied;
+}
+
+void TrackingMultiplexer::restoreApplied(const TrackingOptions& sent,
+                                         const TrackingOptions& prev, bool prevValid)
+{
+    if (isSameAsApplied(sent)) {
+        setApplied(prev, prevValid);
+    } else {
+        LOC_LOGd("options applied since, interval %u powerMode %u kept",
+                 mApplied.minInterval, mApplied.powerMode);
+    }
+}
@@ -0,0 +1,96 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef TRACKING_MULTIPLEXER_H
+#define TRACKING_MULTIPLEXER_H
+
+#include <map>
+#include <set>
+#include <utility>
+#include <LocAdapterBase.h>
+#include <LocationDataTypes.h>
+
+/* Keeps the aggregate of the time based tracking sessions, i.e. the smallest
+ * interval and the highest power mode of all sessions, in ordered sets so that
+ * starting, updating and stopping a session is O(log n). It also remembers the
+ * aggregate last sent to the engine, so a session change which leaves the
+ * aggregate as it is does not restart the engine session. */
+class TrackingMultiplexer {
+    typedef std::pair<uint32_t, LocationSessionKey> IntervalEntry;
+    typedef std::pair<uint32_t, LocationSessionKey> PowerModeEntry;
+
+    std::map<LocationSessionKey, TrackingOptions> mSessions;
+    std::set<IntervalEntry> mIntervals;
+    std::set<PowerModeEntry> mPowerModes;
+    TrackingOptions mApplied;
+    bool mAppliedValid;
+    uint32_t mAvoidedRestarts;
+
+    // GNSS_POWER_MODE_INVALID means no preference, so it ranks last
+    static inline uint32_t powerModeRank(GnssPowerMode powerMode) {
+        return (GNSS_POWER_MODE_INVALID == powerMode) ? UINT32_MAX : (uint32_t)powerMode;
+    }
+    bool isSameAsApplied(const TrackingOptions& options) const;
+
+public:
+    inline TrackingMultiplexer() :
+            mApplied(), mAppliedValid(false), mAvoidedRestarts(0) {}
+
+    void addSession(const LocationSessionKey& key, const TrackingOptions& options);
+    void removeSession(const LocationSessionKey& key);
+
+    // Computes the aggregate options of all sessions but the excluded one, plus
+    // the candidate session options if given. Location options come from the
+    // session of the smallest interval, power mode and tbm from the session of
+    // the highest power mode. Returns false if there is no session to aggregate.
+    bool getAggregate(TrackingOptions& aggregate,
+                      const LocationSessionKey* excludedKey = nullptr,
+                      const TrackingOptions* candidate = nullptr) const;
+
+    // true if the aggregate is what was last sent to the engine, in which case
+    // the caller does not restart the engine session and the avoided restart is
+    // counted. The applied options survive a suspend, as resuming always resends
+    // the aggregate.
+    bool isApplied(const TrackingOptions& aggregate);
+    inline void setApplied(const TrackingOptions& aggregate, bool valid = true) {
+        mApplied = aggregate;
+        mAppliedValid = valid;
+    }
+    inline bool getApplied(TrackingOptions& applied) const {
+        applied = mApplied;
+        return mAppliedValid;
+    }
+    inline void resetApplied() { mAppliedValid = false; }
+    // Rolls the applied options back to prev when the engine rejected the options
+    // sent, unless a later request has already applied other options
+    void restoreApplied(const TrackingOptions& sent, const TrackingOptions& prev,
+                        bool prevValid);
+    inline uint32_t getAvoidedRestarts() const { return mAvoidedRestarts; }
+};
+
+#endif // TRACKING_MULTIPLEXER_H
@@ -33,8 +33,11 @@
 #include <loc_pla.h>
 #include <log_util.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <atomic>
 #include <map>
 #include <loc_misc_utils.h>
+#include <LocPluginRegistry.h>
 
 typedef const GnssInterface* (getGnssInterface)();
 typedef const GeofenceInterface* (getGeofenceInterface)();
@@ -62,23 +65,42 @@ typedef std::map<LocationAPI*, LocationAPIDestroyCbData>
     LocationClientDestroyCbMap;
 
 typedef std::map<LocationAPI*, LocationCallbacks> LocationClientMap;
-typedef struct {
+
+// Clients are spread over shards keyed by their LocationAPI pointer. API calls only
+// take the read lock of their own shard, so calls from different clients, and
+// concurrent calls from the same client, do not serialize. Creating, updating and
+// destroying a client takes the write lock of its shard.
+#define LOCATION_API_CLIENT_SHARDS 8
+struct LocationClientShard {
+    pthread_rwlock_t lock;
     LocationClientMap clientData;
     LocationClientDestroyCbMap destroyClientData;
+    inline LocationClientShard() { pthread_rwlock_init(&lock, nullptr); }
+};
+
+typedef struct {
     LocationControlAPI* controlAPI;
     LocationControlCallbacks controlCallbacks;
-    GnssInterface* gnssInterface;
-    GeofenceInterface* geofenceInterface;
-    BatchingInterface* batchingInterface;
+    // loaded once and never unloaded, so they are read without a lock
+    std::atomic<GnssInterface*> gnssInterface;
+    std::atomic<GeofenceInterface*> geofenceInterface;
+    std::atomic<BatchingInterface*> batchingInterface;
 } LocationAPIData;
 
 static LocationAPIData gData = {};
+static LocationClientShard gClientShards[LOCATION_API_CLIENT_SHARDS];
+// guards the control API and the OS framework refcount, never held across API calls
 static pthread_mutex_t gDataMutex = PTHREAD_MUTEX_INITIALIZER;
-static bool gGnssLoadFailed = false;
-static bool gBatchingLoadFailed = false;
-static bool gGeofenceLoadFailed = false;
+static pthread_once_t gGnssLoadOnce = PTHREAD_ONCE_INIT;
+static pthread_once_t gBatchingLoadOnce = PTHREAD_ONCE_INIT;
+static pthread_once_t gGeofenceLoadOnce = PTHREAD_ONCE_INIT;
 static uint32_t gOSFrameworkRefCount = 0;
 
+static inline LocationClientShard& getClientShard(const void* client)
+{
+    return gClientShards[((uintptr_t)client >> 4) % LOCATION_API_CLIENT_SHARDS];
+}
+
 template <typename T1, typename T2>
 static const T1* loadLocationInterface(const char* library, const char* name) {
     void* libhandle = nullptr;
@@ -90,6 +112,42 @@ static const T1* loadLocationInterface(const char* library, const char* name) {
     }
 }
 
+static void loadGnssInterface() {
+    GnssInterface* gnssInterface =
+        (GnssInterface*)loadLocationInterface<GnssInterface,
+            getGnssInterface>("libgnss.so", "getGnssInterface");
+    if (NULL == gnssInterface) {
+        LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
+    } else {
+        gnssInterface->initialize();
+        gData.gnssInterface = gnssInterface;
+    }
+}
+
+static void loadBatchingInterface() {
+    BatchingInterface* batchingInterface =
+        (BatchingInterface*)loadLocationInterface<BatchingInterface,
+         getBatchingInterface>("libbatching.so", "getBatchingInterface");
+    if (NULL == batchingInterface) {
+        LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
+    } else {
+        batchingInterface->initialize();
+        gData.batchingInterface = batchingInterface;
+    }
+}
+
+static void loadGeofenceInterface() {
+    GeofenceInterface* geofenceInterface =
+       (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
+       getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
+    if (NULL == geofenceInterface) {
+        LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
+    } else {
+        geofenceInterface->initialize();
+        gData.geofenceInterface = geofenceInterface;
+    }
+}
+
 static void createOSFrameworkInstance() {
     void* libHandle = nullptr;
     createOSFramework* getter = (createOSFramework*)dlGetSymFromLib(libHandle,
@@ -152,17 +210,18 @@ void LocationAPI::onRemoveClientCompleteCb (LocationAdapterTypeMask adapterType)
     bool invokeCallback = false;
     locationApiDestroyCompleteCallback destroyCompleteCb;
     LOC_LOGd("adatper type %x", adapterType);
-    pthread_mutex_lock(&gDataMutex);
-    auto it = gData.destroyClientData.find(this);
-    if (it != gData.destroyClientData.end()) {
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_wrlock(&shard.lock);
+    auto it = shard.destroyClientData.find(this);
+    if (it != shard.destroyClientData.end()) {
         it->second.waitAdapterMask &= ~adapterType;
         if (it->second.waitAdapterMask == 0) {
             invokeCallback = true;
             destroyCompleteCb = it->second.destroyCompleteCb;
-            gData.destroyClientData.erase(it);
+            shard.destroyClientData.erase(it);
         }
     }
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 
     if (invokeCallback) {
         LOC_LOGd("invoke client destroy cb");
@@ -189,6 +248,22 @@ void onGeofenceRemoveClientCompleteCb (LocationAPI* client)
     client->onRemoveClientCompleteCb (LOCATION_ADAPTER_GEOFENCE_TYPE_BIT);
 }
 
+// dlopen and initialize the interfaces a client needs, at most once per process,
+// before any registry lock is taken
+static void loadInterfacesFor(LocationCallbacks& locationCallbacks)
+{
+    if (isGnssClient(locationCallbacks)) {
+        pthread_once(&gGnssLoadOnce, loadGnssInterface);
+    }
+    if (isBatchingClient(locationCallbacks)) {
+        pthread_once(&gBatchingLoadOnce, loadBatchingInterface);
+    }
+    if (isGeofenceClient(locationCallbacks)) {
+        pthread_once(&gGeofenceLoadOnce, loadGeofenceInterface);
+    }
+    loc_util::LocPluginRegistry::getInstance().markMilestone("location interfaces loaded");
+}
+
 LocationAPI*
 LocationAPI::createInstance (LocationCallbacks& locationCallbacks)
 {
@@ -198,83 +273,53 @@ LocationAPI::createInstance (LocationCallbacks& locationCallbacks)
         LOC_LOGe("missing mandatory callback, return null");
         return NULL;
     }
+    loc_util::LocPluginRegistry::getInstance().markMilestone("LocationAPI::createInstance");
 
     LocationAPI* newLocationAPI = new LocationAPI();
     bool requestedCapabilities = false;
 
     pthread_mutex_lock(&gDataMutex);
-
     gOSFrameworkRefCount++;
     if (1 == gOSFrameworkRefCount) {
         createOSFrameworkInstance();
     }
+    pthread_mutex_unlock(&gDataMutex);
 
-    if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
-            gData.gnssInterface->addClient(newLocationAPI, locationCallbacks);
-            if (!requestedCapabilities) {
-                gData.gnssInterface->requestCapabilities(newLocationAPI);
-                requestedCapabilities = true;
-            }
+    loadInterfacesFor(locationCallbacks);
+
+    LocationClientShard& shard = getClientShard(newLocationAPI);
+    pthread_rwlock_wrlock(&shard.lock);
+
+    GnssInterface* gnssInterface = gData.gnssInterface;
+    if (isGnssClient(locationCallbacks) && NULL != gnssInterface) {
+        gnssInterface->addClient(newLocationAPI, locationCallbacks);
+        if (!requestedCapabilities) {
+            gnssInterface->requestCapabilities(newLocationAPI);
+            requestedCapabilities = true;
         }
     }
 
-    if (isBatchingClient(locationCallbacks)) {
-        if (NULL == gData.batchingInterface && !gBatchingLoadFailed) {
-            gData.batchingInterface =
-                (BatchingInterface*)loadLocationInterface<BatchingInterface,
-                 getBatchingInterface>("libbatching.so", "getBatchingInterface");
-            if (NULL == gData.batchingInterface) {
-                gBatchingLoadFailed = true;
-                LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
-            } else {
-                gData.batchingInterface->initialize();
-            }
-        }
-        if (NULL != gData.batchingInterface) {
-            gData.batchingInterface->addClient(newLocationAPI, locationCallbacks);
-            if (!requestedCapabilities) {
-                gData.batchingInterface->requestCapabilities(newLocationAPI);
-                requestedCapabilities = true;
-            }
+    BatchingInterface* batchingInterface = gData.batchingInterface;
+    if (isBatchingClient(locationCallbacks) && NULL != batchingInterface) {
+        batchingInterface->addClient(newLocationAPI, locationCallbacks);
+        if (!requestedCapabilities) {
+            batchingInterface->requestCapabilities(newLocationAPI);
+            requestedCapabilities = true;
         }
     }
 
-    if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-               (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
-               getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
-            gData.geofenceInterface->addClient(newLocationAPI, locationCallbacks);
-            if (!requestedCapabilities) {
-                gData.geofenceInterface->requestCapabilities(newLocationAPI);
-                requestedCapabilities = true;
-            }
+    GeofenceInterface* geofenceInterface = gData.geofenceInterface;
+    if (isGeofenceClient(locationCallbacks) && NULL != geofenceInterface) {
+        geofenceInterface->addClient(newLocationAPI, locationCallbacks);
+        if (!requestedCapabilities) {
+            geofenceInterface->requestCapabilities(newLocationAPI);
+            requestedCapabilities = true;
         }
     }
 
-    gData.clientData[newLocationAPI] = locationCallbacks;
+    shard.clientData[newLocationAPI] = locationCallbacks;
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 
     return newLocationAPI;
 }
@@ -283,13 +328,17 @@ void
 LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
 {
     bool invokeDestroyCb = false;
-
-    pthread_mutex_lock(&gDataMutex);
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
-        bool removeFromGnssInf = (NULL != gData.gnssInterface);
-        bool removeFromBatchingInf = (NULL != gData.batchingInterface);
-        bool removeFromGeofenceInf = (NULL != gData.geofenceInterface);
+    GnssInterface* gnssInterface = gData.gnssInterface;
+    BatchingInterface* batchingInterface = gData.batchingInterface;
+    GeofenceInterface* geofenceInterface = gData.geofenceInterface;
+
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_wrlock(&shard.lock);
+    auto it = shard.clientData.find(this);
+    if (it != shard.clientData.end()) {
+        bool removeFromGnssInf = (NULL != gnssInterface);
+        bool removeFromBatchingInf = (NULL != batchingInterface);
+        bool removeFromGeofenceInf = (NULL != geofenceInterface);
         bool needToWait = (removeFromGnssInf || removeFromBatchingInf || removeFromGeofenceInf);
         LOC_LOGe("removeFromGnssInf: %d, removeFromBatchingInf: %d, removeFromGeofenceInf: %d,"
                  "needToWait: %d", removeFromGnssInf, removeFromBatchingInf, removeFromGeofenceInf,
@@ -307,24 +356,24 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
                     (removeFromBatchingInf ? LOCATION_ADAPTER_BATCHING_TYPE_BIT : 0);
             destroyCbData.waitAdapterMask |=
                     (removeFromGeofenceInf ? LOCATION_ADAPTER_GEOFENCE_TYPE_BIT : 0);
-            gData.destroyClientData[this] = destroyCbData;
+            shard.destroyClientData[this] = destroyCbData;
             LOC_LOGi("destroy data stored in the map: 0x%x", destroyCbData.waitAdapterMask);
         }
 
         if (removeFromGnssInf) {
-            gData.gnssInterface->removeClient(it->first,
-                                              onGnssRemoveClientCompleteCb);
+            gnssInterface->removeClient(it->first,
+                                        onGnssRemoveClientCompleteCb);
         }
         if (removeFromBatchingInf) {
-            gData.batchingInterface->removeClient(it->first,
-                                             onBatchingRemoveClientCompleteCb);
+            batchingInterface->removeClient(it->first,
+                                            onBatchingRemoveClientCompleteCb);
         }
         if (removeFromGeofenceInf) {
-            gData.geofenceInterface->removeClient(it->first,
-                                                  onGeofenceRemoveClientCompleteCb);
+            geofenceInterface->removeClient(it->first,
+                                            onGeofenceRemoveClientCompleteCb);
         }
 
-        gData.clientData.erase(it);
+        shard.clientData.erase(it);
 
         if (!needToWait) {
             invokeDestroyCb = true;
@@ -333,13 +382,15 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
         LOC_LOGE("%s:%d]: Location API client %p not found in client data",
                  __func__, __LINE__, this);
     }
+    pthread_rwlock_unlock(&shard.lock);
 
+    pthread_mutex_lock(&gDataMutex);
     if (1 == gOSFrameworkRefCount) {
         destroyOSFrameworkInstance();
     }
     gOSFrameworkRefCount--;
-
     pthread_mutex_unlock(&gDataMutex);
+
     if (invokeDestroyCb) {
         if (!destroyCompleteCb) {
             (destroyCompleteCb) ();
@@ -368,77 +419,45 @@ LocationAPI::updateCallbacks(LocationCallbacks& locationCallbacks)
         return;
     }
 
-    pthread_mutex_lock(&gDataMutex);
+    loadInterfacesFor(locationCallbacks);
 
-    if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
-            // either adds new Client or updates existing Client
-            gData.gnssInterface->addClient(this, locationCallbacks);
-        }
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_wrlock(&shard.lock);
+
+    GnssInterface* gnssInterface = gData.gnssInterface;
+    if (isGnssClient(locationCallbacks) && NULL != gnssInterface) {
+        // either adds new Client or updates existing Client
+        gnssInterface->addClient(this, locationCallbacks);
     }
 
-    if (isBatchingClient(locationCallbacks)) {
-        if (NULL == gData.batchingInterface && !gBatchingLoadFailed) {
-            gData.batchingInterface =
-                (BatchingInterface*)loadLocationInterface<BatchingInterface,
-                 getBatchingInterface>("libbatching.so", "getBatchingInterface");
-            if (NULL == gData.batchingInterface) {
-                gBatchingLoadFailed = true;
-                LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
-            } else {
-                gData.batchingInterface->initialize();
-            }
-        }
-        if (NULL != gData.batchingInterface) {
-            // either adds new Client or updates existing Client
-            gData.batchingInterface->addClient(this, locationCallbacks);
-        }
+    BatchingInterface* batchingInterface = gData.batchingInterface;
+    if (isBatchingClient(locationCallbacks) && NULL != batchingInterface) {
+        // either adds new Client or updates existing Client
+        batchingInterface->addClient(this, locationCallbacks);
     }
 
-    if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-                (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
-                 getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
-            // either adds new Client or updates existing Client
-            gData.geofenceInterface->addClient(this, locationCallbacks);
-        }
+    GeofenceInterface* geofenceInterface = gData.geofenceInterface;
+    if (isGeofenceClient(locationCallbacks) && NULL != geofenceInterface) {
+        // either adds new Client or updates existing Client
+        geofenceInterface->addClient(this, locationCallbacks);
     }
 
-    gData.clientData[this] = locationCallbacks;
+    shard.clientData[this] = locationCallbacks;
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 uint32_t
 LocationAPI::startTracking(TrackingOptions& trackingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
+    auto it = shard.clientData.find(this);
+    if (it != shard.clientData.end()) {
         if (NULL != gData.gnssInterface) {
-            id = gData.gnssInterface->startTracking(this, trackingOptions);
+            id = gData.gnssInterface.load()->startTracking(this, trackingOptions);
         } else {
             LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                      __func__, __LINE__, this);
@@ -448,19 +467,20 @@ LocationAPI::startTracking(TrackingOptions& trackingOptions)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
     return id;
 }
 
 void
 LocationAPI::stopTracking(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
+    auto it = shard.clientData.find(this);
+    if (it != shard.clientData.end()) {
         if (gData.gnssInterface != NULL) {
-            gData.gnssInterface->stopTracking(this, id);
+            gData.gnssInterface.load()->stopTracking(this, id);
         } else {
             LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                      __func__, __LINE__, this);
@@ -470,19 +490,20 @@ LocationAPI::stopTracking(uint32_t id)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 void
 LocationAPI::updateTrackingOptions(
         uint32_t id, TrackingOptions& trackingOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
+    auto it = shard.clientData.find(this);
+    if (it != shard.clientData.end()) {
         if (gData.gnssInterface != NULL) {
-            gData.gnssInterface->updateTrackingOptions(this, id, trackingOptions);
+            gData.gnssInterface.load()->updateTrackingOptions(this, id, trackingOptions);
         } else {
             LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                      __func__, __LINE__, this);
@@ -492,161 +513,171 @@ LocationAPI::updateTrackingOptions(
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 uint32_t
 LocationAPI::startBatching(BatchingOptions &batchingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (NULL != gData.batchingInterface) {
-        id = gData.batchingInterface->startBatching(this, batchingOptions);
+        id = gData.batchingInterface.load()->startBatching(this, batchingOptions);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
     return id;
 }
 
 void
 LocationAPI::stopBatching(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (NULL != gData.batchingInterface) {
-        gData.batchingInterface->stopBatching(this, id);
+        gData.batchingInterface.load()->stopBatching(this, id);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 void
 LocationAPI::updateBatchingOptions(uint32_t id, BatchingOptions& batchOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (NULL != gData.batchingInterface) {
-        gData.batchingInterface->updateBatchingOptions(this, id, batchOptions);
+        gData.batchingInterface.load()->updateBatchingOptions(this, id, batchOptions);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 void
 LocationAPI::getBatchedLocations(uint32_t id, size_t count)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (gData.batchingInterface != NULL) {
-        gData.batchingInterface->getBatchedLocations(this, id, count);
+        gData.batchingInterface.load()->getBatchedLocations(this, id, count);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 uint32_t*
 LocationAPI::addGeofences(size_t count, GeofenceOption* options, GeofenceInfo* info)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (gData.geofenceInterface != NULL) {
-        ids = gData.geofenceInterface->addGeofences(this, count, options, info);
+        ids = gData.geofenceInterface.load()->addGeofences(this, count, options, info);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
     return ids;
 }
 
 void
 LocationAPI::removeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->removeGeofences(this, count, ids);
+        gData.geofenceInterface.load()->removeGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 void
 LocationAPI::modifyGeofences(size_t count, uint32_t* ids, GeofenceOption* options)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->modifyGeofences(this, count, ids, options);
+        gData.geofenceInterface.load()->modifyGeofences(this, count, ids, options);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 void
 LocationAPI::pauseGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->pauseGeofences(this, count, ids);
+        gData.geofenceInterface.load()->pauseGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 void
 LocationAPI::resumeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->resumeGeofences(this, count, ids);
+        gData.geofenceInterface.load()->resumeGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 void
 LocationAPI::gnssNiResponse(uint32_t id, GnssNiResponse response)
 {
-    pthread_mutex_lock(&gDataMutex);
+    LocationClientShard& shard = getClientShard(this);
+    pthread_rwlock_rdlock(&shard.lock);
 
     if (gData.gnssInterface != NULL) {
-        gData.gnssInterface->gnssNiResponse(this, id, response);
+        gData.gnssInterface.load()->gnssNiResponse(this, id, response);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&shard.lock);
 }
 
 void LocationAPI::enableNetworkProvider() {
@@ -699,24 +730,16 @@ LocationControlAPI*
 LocationControlAPI::createInstance(LocationControlCallbacks& locationControlCallbacks)
 {
     LocationControlAPI* controlAPI = NULL;
+    if (nullptr != locationControlCallbacks.responseCb) {
+        pthread_once(&gGnssLoadOnce, loadGnssInterface);
+    }
     pthread_mutex_lock(&gDataMutex);
 
     if (nullptr != locationControlCallbacks.responseCb && NULL == gData.controlAPI) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
         if (NULL != gData.gnssInterface) {
             gData.controlAPI = new LocationControlAPI();
             gData.controlCallbacks = locationControlCallbacks;
-            gData.gnssInterface->setControlCallbacks(locationControlCallbacks);
+            gData.gnssInterface.load()->setControlCallbacks(locationControlCallbacks);
             controlAPI = gData.controlAPI;
         }
     }
@@ -750,63 +773,47 @@ uint32_t
 LocationControlAPI::enable(LocationTechnologyType techType)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->enable(techType);
+        id = gData.gnssInterface.load()->enable(techType);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 void
 LocationControlAPI::disable(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        gData.gnssInterface->disable(id);
+        gData.gnssInterface.load()->disable(id);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 uint32_t*
 LocationControlAPI::gnssUpdateConfig(const GnssConfig& config)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        ids = gData.gnssInterface->gnssUpdateConfig(config);
+        ids = gData.gnssInterface.load()->gnssUpdateConfig(config);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return ids;
 }
 
 uint32_t* LocationControlAPI::gnssGetConfig(GnssConfigFlagsMask mask) {
 
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
-
     if (NULL != gData.gnssInterface) {
-        ids = gData.gnssInterface->gnssGetConfig(mask);
+        ids = gData.gnssInterface.load()->gnssGetConfig(mask);
     } else {
         LOC_LOGe("No gnss interface available for Control API client %p", this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return ids;
 }
 
@@ -814,16 +821,12 @@ uint32_t
 LocationControlAPI::gnssDeleteAidingData(GnssAidingData& data)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->gnssDeleteAidingData(data);
+        id = gData.gnssInterface.load()->gnssDeleteAidingData(data);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
@@ -831,134 +834,98 @@ uint32_t LocationControlAPI::configConstellations(
         const GnssSvTypeConfig& constellationEnablementConfig,
         const GnssSvIdConfig&   blacklistSvConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->gnssUpdateSvConfig(
+        id = gData.gnssInterface.load()->gnssUpdateSvConfig(
                 constellationEnablementConfig, blacklistSvConfig);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configConstellationSecondaryBand(
         const GnssSvTypeConfig& secondaryBandConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->gnssUpdateSecondaryBandConfig(secondaryBandConfig);
+        id = gData.gnssInterface.load()->gnssUpdateSecondaryBandConfig(secondaryBandConfig);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configConstrainedTimeUncertainty(
             bool enable, float tuncThreshold, uint32_t energyBudget) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->setConstrainedTunc(enable,
+        id = gData.gnssInterface.load()->setConstrainedTunc(enable,
                                                      tuncThreshold,
                                                      energyBudget);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configPositionAssistedClockEstimator(bool enable) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->setPositionAssistedClockEstimator(enable);
+        id = gData.gnssInterface.load()->setPositionAssistedClockEstimator(enable);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configLeverArm(const LeverArmConfigInfo& configInfo) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configLeverArm(configInfo);
+        id = gData.gnssInterface.load()->configLeverArm(configInfo);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configRobustLocation(bool enable, bool enableForE911) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configRobustLocation(enable, enableForE911);
+        id = gData.gnssInterface.load()->configRobustLocation(enable, enableForE911);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configMinGpsWeek(uint16_t minGpsWeek) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configMinGpsWeek(minGpsWeek);
+        id = gData.gnssInterface.load()->configMinGpsWeek(minGpsWeek);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configDeadReckoningEngineParams(
         const DeadReckoningEngineConfig& dreConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configDeadReckoningEngineParams(dreConfig);
+        id = gData.gnssInterface.load()->configDeadReckoningEngineParams(dreConfig);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configEngineRunState(
         PositioningEngineMask engType, LocEngineRunState engState) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
     if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configEngineRunState(engType, engState);
+        id = gData.gnssInterface.load()->configEngineRunState(engType, engState);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
-
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
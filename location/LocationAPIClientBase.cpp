@@ -91,7 +91,7 @@ uint32_t LocationAPIControlClient::locAPIGnssDeleteAidingData(GnssAidingData& da
         uint32_t session = mLocationControlAPI->gnssDeleteAidingData(data);
         LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, session);
         mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].reset(session);
-        mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].push(new GnssDeleteAidingDataRequest(*this));
+        mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].push(mRequestPool.get<GnssDeleteAidingDataRequest>(*this));
 
         retVal = LOCATION_ERROR_SUCCESS;
     }
@@ -111,7 +111,7 @@ uint32_t LocationAPIControlClient::locAPIEnable(LocationTechnologyType techType)
         uint32_t session = mLocationControlAPI->enable(techType);
         LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, session);
         mRequestQueues[CTRL_REQUEST_CONTROL].reset(session);
-        mRequestQueues[CTRL_REQUEST_CONTROL].push(new EnableRequest(*this));
+        mRequestQueues[CTRL_REQUEST_CONTROL].push(mRequestPool.get<EnableRequest>(*this));
         retVal = LOCATION_ERROR_SUCCESS;
         mEnabled = true;
     } else {
@@ -129,7 +129,7 @@ void LocationAPIControlClient::locAPIDisable()
         uint32_t session = 0;
         session = mRequestQueues[CTRL_REQUEST_CONTROL].getSession();
         if (session > 0) {
-            mRequestQueues[CTRL_REQUEST_CONTROL].push(new DisableRequest(*this));
+            mRequestQueues[CTRL_REQUEST_CONTROL].push(mRequestPool.get<DisableRequest>(*this));
             mLocationControlAPI->disable(session);
             mEnabled = false;
         } else {
@@ -156,7 +156,7 @@ uint32_t LocationAPIControlClient::locAPIGnssUpdateConfig(GnssConfig config)
                 if (nullptr != mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].getSessionArrayPtr()) {
                     mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].reset(idArray);
                 }
-                mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].push(new GnssUpdateConfigRequest(*this));
+                mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].push(mRequestPool.get<GnssUpdateConfigRequest>(*this));
                 retVal = LOCATION_ERROR_SUCCESS;
                 delete [] idArray;
             }
@@ -179,7 +179,7 @@ uint32_t LocationAPIControlClient::locAPIGnssGetConfig(GnssConfigFlagsMask mask)
             if (nullptr != mRequestQueues[CTRL_REQUEST_CONFIG_GET].getSessionArrayPtr()) {
                 mRequestQueues[CTRL_REQUEST_CONFIG_GET].reset(idArray);
             }
-            mRequestQueues[CTRL_REQUEST_CONFIG_GET].push(new GnssGetConfigRequest(*this));
+            mRequestQueues[CTRL_REQUEST_CONFIG_GET].push(mRequestPool.get<GnssGetConfigRequest>(*this));
             retVal = LOCATION_ERROR_SUCCESS;
             delete [] idArray;
         }
@@ -198,7 +198,7 @@ void LocationAPIControlClient::onCtrlResponseCb(LocationError error, uint32_t id
     LocationAPIRequest* request = getRequestBySession(id);
     if (request) {
         request->onResponse(error, id);
-        delete request;
+        releaseRequest(request);
     }
 }
 
@@ -215,10 +215,17 @@ void LocationAPIControlClient::onCtrlCollectiveResponseCb(
     LocationAPIRequest* request = getRequestBySessionArrayPtr(ids);
     if (request) {
         request->onCollectiveResponse(count, errors, ids);
-        delete request;
+        releaseRequest(request);
     }
 }
 
+void LocationAPIControlClient::releaseRequest(LocationAPIRequest* request)
+{
+    pthread_mutex_lock(&mMutex);
+    request->release();
+    pthread_mutex_unlock(&mMutex);
+}
+
 LocationAPIRequest* LocationAPIControlClient::getRequestBySession(uint32_t session)
 {
     pthread_mutex_lock(&mMutex);
@@ -323,6 +330,7 @@ void LocationAPIClientBase::destroy()
     for (int i = 0; i < REQUEST_MAX; i++) {
         mRequestQueues[i].reset((uint32_t)0);
     }
+    mRemovedGeofenceBiDict.clear();
 
     LocationAPI* localHandle = nullptr;
     if (nullptr != mLocationAPI) {
@@ -365,7 +373,7 @@ uint32_t LocationAPIClientBase::locAPIStartTracking(TrackingOptions& options)
             // startTracking returns, so we are not going to unlock mutex
             // until StartTrackingRequest is pushed into mRequestQueues[REQUEST_TRACKING]
             mRequestQueues[REQUEST_TRACKING].reset(session);
-            mRequestQueues[REQUEST_TRACKING].push(new StartTrackingRequest(*this));
+            mRequestQueues[REQUEST_TRACKING].push(mRequestPool.get<StartTrackingRequest>(*this));
             mTracking = true;
         }
 
@@ -383,7 +391,7 @@ void LocationAPIClientBase::locAPIStopTracking()
         uint32_t session = 0;
         session = mRequestQueues[REQUEST_TRACKING].getSession();
         if (session > 0) {
-            mRequestQueues[REQUEST_TRACKING].push(new StopTrackingRequest(*this));
+            mRequestQueues[REQUEST_TRACKING].push(mRequestPool.get<StopTrackingRequest>(*this));
             mLocationAPI->stopTracking(session);
             mTracking = false;
         } else {
@@ -400,7 +408,7 @@ void LocationAPIClientBase::locAPIUpdateTrackingOptions(TrackingOptions& options
         uint32_t session = 0;
         session = mRequestQueues[REQUEST_TRACKING].getSession();
         if (session > 0) {
-            mRequestQueues[REQUEST_TRACKING].push(new UpdateTrackingOptionsRequest(*this));
+            mRequestQueues[REQUEST_TRACKING].push(mRequestPool.get<UpdateTrackingOptionsRequest>(*this));
             mLocationAPI->updateTrackingOptions(session, options);
         } else {
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__, session);
@@ -442,7 +450,7 @@ uint32_t LocationAPIClientBase::locAPIStartSession(
             if (sessionMode == SESSION_MODE_ON_FIX) {
                 trackingSession = mLocationAPI->startTracking(options);
                 LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, trackingSession);
-                mRequestQueues[REQUEST_SESSION].push(new StartTrackingRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(mRequestPool.get<StartTrackingRequest>(*this));
             } else {
                 // Fill in the batch mode
                 BatchingOptions batchOptions = {};
@@ -467,7 +475,7 @@ uint32_t LocationAPIClientBase::locAPIStartSession(
                 batchingSession = mLocationAPI->startBatching(batchOptions);
                 LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, batchingSession);
                 mRequestQueues[REQUEST_SESSION].setSession(batchingSession);
-                mRequestQueues[REQUEST_SESSION].push(new StartBatchingRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(mRequestPool.get<StartBatchingRequest>(*this));
             }
 
             uint32_t session = ((sessionMode != SESSION_MODE_ON_FIX) ?
@@ -503,10 +511,10 @@ uint32_t LocationAPIClientBase::locAPIStopSession(uint32_t id)
             uint32_t sMode = entity.sessionMode;
 
             if (sMode == SESSION_MODE_ON_FIX) {
-                mRequestQueues[REQUEST_SESSION].push(new StopTrackingRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(mRequestPool.get<StopTrackingRequest>(*this));
                 mLocationAPI->stopTracking(trackingSession);
             } else {
-                mRequestQueues[REQUEST_SESSION].push(new StopBatchingRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(mRequestPool.get<StopBatchingRequest>(*this));
                 mLocationAPI->stopBatching(batchingSession);
             }
 
@@ -538,7 +546,7 @@ uint32_t LocationAPIClientBase::locAPIUpdateSessionOptions(
             if (sessionMode == SESSION_MODE_ON_FIX) {
                 // we only add an UpdateTrackingOptionsRequest to mRequestQueues[REQUEST_SESSION],
                 // even if this update request will stop batching and then start tracking.
-                mRequestQueues[REQUEST_SESSION].push(new UpdateTrackingOptionsRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(mRequestPool.get<UpdateTrackingOptionsRequest>(*this));
                 if (sMode == SESSION_MODE_ON_FIX) {
                     mLocationAPI->updateTrackingOptions(trackingSession, options);
                 } else  {
@@ -557,7 +565,7 @@ uint32_t LocationAPIClientBase::locAPIUpdateSessionOptions(
             } else {
                 // we only add an UpdateBatchingOptionsRequest to mRequestQueues[REQUEST_SESSION],
                 // even if this update request will stop tracking and then start batching.
-                mRequestQueues[REQUEST_SESSION].push(new UpdateBatchingOptionsRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(mRequestPool.get<UpdateBatchingOptionsRequest>(*this));
                 BatchingOptions batchOptions = {};
                 batchOptions.size = sizeof(BatchingOptions);
                 switch (sessionMode) {
@@ -624,7 +632,7 @@ uint32_t LocationAPIClientBase::locAPIGetBatchedLocations(uint32_t id, size_t co
             SessionEntity entity = mSessionBiDict.getExtById(id);
             if (entity.sessionMode != SESSION_MODE_ON_FIX) {
                 uint32_t batchingSession = entity.batchingSession;
-                mRequestQueues[REQUEST_SESSION].push(new GetBatchedLocationsRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(mRequestPool.get<GetBatchedLocationsRequest>(*this));
                 mLocationAPI->getBatchedLocations(batchingSession, count);
                 retVal = LOCATION_ERROR_SUCCESS;
             }  else {
@@ -654,7 +662,7 @@ uint32_t LocationAPIClientBase::locAPIAddGeofences(
         uint32_t* sessions = mLocationAPI->addGeofences(count, options, data);
         if (sessions) {
             LOC_LOGI("%s:%d] start new sessions: %p", __FUNCTION__, __LINE__, sessions);
-            mRequestQueues[REQUEST_GEOFENCE].push(new AddGeofencesRequest(*this));
+            mRequestQueues[REQUEST_GEOFENCE].push(mRequestPool.get<AddGeofencesRequest>(*this));
 
             for (size_t i = 0; i < count; i++) {
                 mGeofenceBiDict.set(ids[i], sessions[i], options[i].breachTypeMask);
@@ -671,40 +679,31 @@ void LocationAPIClientBase::locAPIRemoveGeofences(size_t count, uint32_t* ids)
 {
     pthread_mutex_lock(&mMutex);
     if (mLocationAPI) {
-        uint32_t* sessions = (uint32_t*)malloc(sizeof(uint32_t) * count);
-        if (sessions == NULL) {
-            LOC_LOGE("%s:%d] Failed to allocate %zu bytes !",
-                    __FUNCTION__, __LINE__, sizeof(uint32_t) * count);
-            pthread_mutex_unlock(&mMutex);
-            return;
+        if (mSessionScratch.size() < count || mSessionScratch.empty()) {
+            mSessionScratch.resize(count > 0 ? count : 1);
         }
+        uint32_t* sessions = mSessionScratch.data();
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
-            BiDict<GeofenceBreachTypeMask>* removedGeofenceBiDict =
-                    new BiDict<GeofenceBreachTypeMask>();
             size_t j = 0;
             for (size_t i = 0; i < count; i++) {
                 sessions[j] = mGeofenceBiDict.getSession(ids[i]);
                 if (sessions[j] > 0) {
                     GeofenceBreachTypeMask type = mGeofenceBiDict.getExtBySession(sessions[j]);
                     mGeofenceBiDict.rmBySession(sessions[j]);
-                    removedGeofenceBiDict->set(ids[i], sessions[j], type);
+                    mRemovedGeofenceBiDict.set(ids[i], sessions[j], type);
                     j++;
                 }
             }
             if (j > 0) {
-                mRequestQueues[REQUEST_GEOFENCE].push(new RemoveGeofencesRequest(*this,
-                        removedGeofenceBiDict));
+                mRequestQueues[REQUEST_GEOFENCE].push(
+                        mRequestPool.get<RemoveGeofencesRequest>(*this));
                 mLocationAPI->removeGeofences(j, sessions);
-            } else {
-                delete(removedGeofenceBiDict);
             }
         } else {
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__,
                     mRequestQueues[REQUEST_GEOFENCE].getSession());
         }
-
-        free(sessions);
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -714,13 +713,10 @@ void LocationAPIClientBase::locAPIModifyGeofences(
 {
     pthread_mutex_lock(&mMutex);
     if (mLocationAPI) {
-        uint32_t* sessions = (uint32_t*)malloc(sizeof(uint32_t) * count);
-        if (sessions == NULL) {
-            LOC_LOGE("%s:%d] Failed to allocate %zu bytes !",
-                    __FUNCTION__, __LINE__, sizeof(uint32_t) * count);
-            pthread_mutex_unlock(&mMutex);
-            return;
+        if (mSessionScratch.size() < count || mSessionScratch.empty()) {
+            mSessionScratch.resize(count > 0 ? count : 1);
         }
+        uint32_t* sessions = mSessionScratch.data();
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
@@ -732,15 +728,13 @@ void LocationAPIClientBase::locAPIModifyGeofences(
                 }
             }
             if (j > 0) {
-                mRequestQueues[REQUEST_GEOFENCE].push(new ModifyGeofencesRequest(*this));
+                mRequestQueues[REQUEST_GEOFENCE].push(mRequestPool.get<ModifyGeofencesRequest>(*this));
                 mLocationAPI->modifyGeofences(j, sessions, options);
             }
         } else {
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__,
                     mRequestQueues[REQUEST_GEOFENCE].getSession());
         }
-
-        free(sessions);
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -749,13 +743,10 @@ void LocationAPIClientBase::locAPIPauseGeofences(size_t count, uint32_t* ids)
 {
     pthread_mutex_lock(&mMutex);
     if (mLocationAPI) {
-        uint32_t* sessions = (uint32_t*)malloc(sizeof(uint32_t) * count);
-        if (sessions == NULL) {
-            LOC_LOGE("%s:%d] Failed to allocate %zu bytes !",
-                    __FUNCTION__, __LINE__, sizeof(uint32_t) * count);
-            pthread_mutex_unlock(&mMutex);
-            return;
+        if (mSessionScratch.size() < count || mSessionScratch.empty()) {
+            mSessionScratch.resize(count > 0 ? count : 1);
         }
+        uint32_t* sessions = mSessionScratch.data();
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
@@ -766,15 +757,13 @@ void LocationAPIClientBase::locAPIPauseGeofences(size_t count, uint32_t* ids)
                 }
             }
             if (j > 0) {
-                mRequestQueues[REQUEST_GEOFENCE].push(new PauseGeofencesRequest(*this));
+                mRequestQueues[REQUEST_GEOFENCE].push(mRequestPool.get<PauseGeofencesRequest>(*this));
                 mLocationAPI->pauseGeofences(j, sessions);
             }
         } else {
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__,
                     mRequestQueues[REQUEST_GEOFENCE].getSession());
         }
-
-        free(sessions);
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -784,13 +773,10 @@ void LocationAPIClientBase::locAPIResumeGeofences(
 {
     pthread_mutex_lock(&mMutex);
     if (mLocationAPI) {
-        uint32_t* sessions = (uint32_t*)malloc(sizeof(uint32_t) * count);
-        if (sessions == NULL) {
-            LOC_LOGE("%s:%d] Failed to allocate %zu bytes !",
-                    __FUNCTION__, __LINE__, sizeof(uint32_t) * count);
-            pthread_mutex_unlock(&mMutex);
-            return;
+        if (mSessionScratch.size() < count || mSessionScratch.empty()) {
+            mSessionScratch.resize(count > 0 ? count : 1);
         }
+        uint32_t* sessions = mSessionScratch.data();
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
@@ -804,15 +790,13 @@ void LocationAPIClientBase::locAPIResumeGeofences(
                 }
             }
             if (j > 0) {
-                mRequestQueues[REQUEST_GEOFENCE].push(new ResumeGeofencesRequest(*this));
+                mRequestQueues[REQUEST_GEOFENCE].push(mRequestPool.get<ResumeGeofencesRequest>(*this));
                 mLocationAPI->resumeGeofences(j, sessions);
             }
         } else {
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__,
                     mRequestQueues[REQUEST_GEOFENCE].getSession());
         }
-
-        free(sessions);
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -833,7 +817,7 @@ void LocationAPIClientBase::locAPIGnssNiResponse(uint32_t id, GnssNiResponse res
         mLocationAPI->gnssNiResponse(id, response);
         LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, session);
         mRequestQueues[REQUEST_NIRESPONSE].reset(session);
-        mRequestQueues[REQUEST_NIRESPONSE].push(new GnssNiResponseRequest(*this));
+        mRequestQueues[REQUEST_NIRESPONSE].push(mRequestPool.get<GnssNiResponseRequest>(*this));
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -841,20 +825,18 @@ void LocationAPIClientBase::locAPIGnssNiResponse(uint32_t id, GnssNiResponse res
 void LocationAPIClientBase::beforeGeofenceBreachCb(
         GeofenceBreachNotification geofenceBreachNotification)
 {
-    uint32_t* ids = (uint32_t*)malloc(sizeof(uint32_t) * geofenceBreachNotification.count);
     uint32_t* backup = geofenceBreachNotification.ids;
     size_t n = geofenceBreachNotification.count;
     geofenceBreachCallback genfenceCallback = nullptr;
 
-    if (ids == NULL) {
-        LOC_LOGE("%s:%d] Failed to alloc %zu bytes",
-                __FUNCTION__, __LINE__,
-                sizeof(uint32_t) * geofenceBreachNotification.count);
-        return;
-    }
-
     pthread_mutex_lock(&mMutex);
     if (mGeofenceBreachCallback != nullptr) {
+        // breaches are delivered one at a time from the geofence callback
+        // context, so the id buffer can be reused between notifications
+        if (mBreachIds.size() < n || mBreachIds.empty()) {
+            mBreachIds.resize(n > 0 ? n : 1);
+        }
+        uint32_t* ids = mBreachIds.data();
         size_t count = 0;
         for (size_t i = 0; i < n; i++) {
             uint32_t id = mGeofenceBiDict.getId(geofenceBreachNotification.ids[i]);
@@ -885,7 +867,6 @@ void LocationAPIClientBase::beforeGeofenceBreachCb(
     // restore ids
     geofenceBreachNotification.ids = backup;
     geofenceBreachNotification.count = n;
-    free(ids);
 }
 
 void LocationAPIClientBase::beforeBatchingStatusCb(BatchingStatusInfo batchStatus,
@@ -921,7 +902,7 @@ void LocationAPIClientBase::onResponseCb(LocationError error, uint32_t id)
     LocationAPIRequest* request = getRequestBySession(id);
     if (request) {
         request->onResponse(error, id);
-        delete request;
+        releaseRequest(request);
     }
 }
 
@@ -943,10 +924,17 @@ void LocationAPIClientBase::onCollectiveResponseCb(
     pthread_mutex_unlock(&mMutex);
     if (request) {
         request->onCollectiveResponse(count, errors, ids);
-        delete request;
+        releaseRequest(request);
     }
 }
 
+void LocationAPIClientBase::releaseRequest(LocationAPIRequest* request)
+{
+    pthread_mutex_lock(&mMutex);
+    request->release();
+    pthread_mutex_unlock(&mMutex);
+}
+
 void LocationAPIClientBase::removeSession(uint32_t session) {
     if (mSessionBiDict.hasSession(session)) {
         mSessionBiDict.rmBySession(session);
@@ -32,12 +32,14 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <pthread.h>
-#include <queue>
-#include <map>
+#include <new>
+#include <utility>
+#include <vector>
 
 #include "LocationAPI.h"
 #include <loc_pla.h>
 #include <log_util.h>
+#include <LocIdHashMap.h>
 
 enum SESSION_MODE {
     SESSION_MODE_NONE = 0,
@@ -64,18 +66,88 @@ enum CTRL_REQUEST_TYPE {
 
 class LocationAPIClientBase;
 
+class RequestPool;
+
 class LocationAPIRequest {
 public:
-    LocationAPIRequest() {}
+    LocationAPIRequest() : mNext(nullptr), mPool(nullptr) {}
     virtual ~LocationAPIRequest() {}
     virtual void onResponse(LocationError /*error*/, uint32_t /*id*/) {}
     virtual void onCollectiveResponse(
             size_t /*count*/, LocationError* /*errors*/, uint32_t* /*ids*/) {}
+    // destroys the request, handing its memory back to the pool it came from
+    inline void release();
+
+    // intrusive link used by RequestQueue
+    LocationAPIRequest* mNext;
+    // owning pool, nullptr if the request was allocated with new
+    RequestPool* mPool;
+};
+
+// Free list of fixed size blocks that requests are constructed in, so that
+// issuing a request does not hit the heap once the pool has warmed up.
+// Every request only holds a reference back to its client, so all of them
+// fit the same block size. Not thread safe, callers serialize on the mutex
+// of the client that owns the pool.
+class RequestPool {
+public:
+    RequestPool() : mFreeList(nullptr) {}
+    ~RequestPool() {
+        while (nullptr != mFreeList) {
+            Block* block = mFreeList;
+            mFreeList = block->mNext;
+            free(block);
+        }
+    }
+    RequestPool(const RequestPool&) = delete;
+    RequestPool& operator=(const RequestPool&) = delete;
+
+    template <typename T, typename... Args>
+    T* get(Args&&... args) {
+        static_assert(sizeof(T) <= sizeof(Block), "request does not fit RequestPool block");
+        static_assert(alignof(T) <= alignof(Block), "request alignment exceeds RequestPool block");
+        void* mem = mFreeList;
+        if (nullptr != mem) {
+            mFreeList = mFreeList->mNext;
+        } else {
+            mem = malloc(sizeof(Block));
+            if (nullptr == mem) {
+                LOC_LOGE("%s:%d] Failed to allocate request", __FUNCTION__, __LINE__);
+                return nullptr;
+            }
+        }
+        T* request = new (mem) T(std::forward<Args>(args)...);
+        request->mPool = this;
+        return request;
+    }
+
+    void put(LocationAPIRequest* request) {
+        request->~LocationAPIRequest();
+        Block* block = reinterpret_cast<Block*>(request);
+        block->mNext = mFreeList;
+        mFreeList = block;
+    }
+
+private:
+    union Block {
+        Block* mNext;
+        void* mStorage[4];
+    };
+    Block* mFreeList;
 };
 
+inline void LocationAPIRequest::release() {
+    if (nullptr != mPool) {
+        mPool->put(this);
+    } else {
+        delete this;
+    }
+}
+
+// FIFO of pending requests, linked through LocationAPIRequest::mNext
 class RequestQueue {
 public:
-    RequestQueue(): mSession(0), mSessionArrayPtr(nullptr) {
+    RequestQueue(): mSession(0), mSessionArrayPtr(nullptr), mHead(nullptr), mTail(nullptr) {
     }
     virtual ~RequestQueue() {
         reset((uint32_t)0);
@@ -84,10 +156,8 @@ public:
     void inline setSessionArrayPtr(uint32_t* ptr) { mSessionArrayPtr = ptr; }
     void reset(uint32_t session) {
         LocationAPIRequest* request = nullptr;
-        while (!mQueue.empty()) {
-            request = mQueue.front();
-            mQueue.pop();
-            delete request;
+        while ((request = pop()) != nullptr) {
+            request->release();
         }
         mSession = session;
     }
@@ -96,13 +166,25 @@ public:
         mSessionArrayPtr = sessionArrayPtr;
     }
     void push(LocationAPIRequest* request) {
-        mQueue.push(request);
+        if (nullptr == request) {
+            return;
+        }
+        request->mNext = nullptr;
+        if (nullptr != mTail) {
+            mTail->mNext = request;
+        } else {
+            mHead = request;
+        }
+        mTail = request;
     }
     LocationAPIRequest* pop() {
-        LocationAPIRequest* request = nullptr;
-        if (!mQueue.empty()) {
-            request = mQueue.front();
-            mQueue.pop();
+        LocationAPIRequest* request = mHead;
+        if (nullptr != request) {
+            mHead = request->mNext;
+            if (nullptr == mHead) {
+                mTail = nullptr;
+            }
+            request->mNext = nullptr;
         }
         return request;
     }
@@ -111,7 +193,8 @@ public:
 private:
     uint32_t mSession;
     uint32_t* mSessionArrayPtr;
-    std::queue<LocationAPIRequest*> mQueue;
+    LocationAPIRequest* mHead;
+    LocationAPIRequest* mTail;
 };
 
 class LocationAPIControlClient {
@@ -190,8 +273,12 @@ public:
     };
 
 private:
+    void releaseRequest(LocationAPIRequest* request);
+
     pthread_mutex_t mMutex;
     LocationControlAPI* mLocationControlAPI;
+    // must outlive mRequestQueues, which hand their requests back on reset
+    RequestPool mRequestPool;
     RequestQueue mRequestQueues[CTRL_REQUEST_MAX];
     bool mEnabled;
     GnssConfig mConfig;
@@ -308,50 +395,54 @@ private:
         }
         bool hasId(uint32_t id) {
             pthread_mutex_lock(&mBiDictMutex);
-            bool ret = (mForwardMap.find(id) != mForwardMap.end());
+            bool ret = (nullptr != mForwardMap.find(id));
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
         }
         bool hasSession(uint32_t session) {
             pthread_mutex_lock(&mBiDictMutex);
-            bool ret = (mBackwardMap.find(session) != mBackwardMap.end());
+            bool ret = (nullptr != mBackwardMap.find(session));
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
         }
         void set(uint32_t id, uint32_t session, T& ext) {
             pthread_mutex_lock(&mBiDictMutex);
             mForwardMap[id] = session;
-            mBackwardMap[session] = id;
-            mExtMap[session] = ext;
+            BackwardEntry& entry = mBackwardMap[session];
+            entry.id = id;
+            entry.ext = ext;
             pthread_mutex_unlock(&mBiDictMutex);
         }
         void clear() {
             pthread_mutex_lock(&mBiDictMutex);
             mForwardMap.clear();
             mBackwardMap.clear();
-            mExtMap.clear();
             pthread_mutex_unlock(&mBiDictMutex);
         }
         void rmById(uint32_t id) {
             pthread_mutex_lock(&mBiDictMutex);
-            mBackwardMap.erase(mForwardMap[id]);
-            mExtMap.erase(mForwardMap[id]);
-            mForwardMap.erase(id);
+            uint32_t* session = mForwardMap.find(id);
+            if (nullptr != session) {
+                mBackwardMap.erase(*session);
+                mForwardMap.erase(id);
+            }
             pthread_mutex_unlock(&mBiDictMutex);
         }
         void rmBySession(uint32_t session) {
             pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap.erase(mBackwardMap[session]);
-            mBackwardMap.erase(session);
-            mExtMap.erase(session);
+            BackwardEntry* entry = mBackwardMap.find(session);
+            if (nullptr != entry) {
+                mForwardMap.erase(entry->id);
+                mBackwardMap.erase(session);
+            }
             pthread_mutex_unlock(&mBiDictMutex);
         }
         uint32_t getId(uint32_t session) {
             pthread_mutex_lock(&mBiDictMutex);
             uint32_t ret = 0;
-            auto it = mBackwardMap.find(session);
-            if (it != mBackwardMap.end()) {
-                ret = it->second;
+            BackwardEntry* entry = mBackwardMap.find(session);
+            if (nullptr != entry) {
+                ret = entry->id;
             }
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
@@ -359,9 +450,9 @@ private:
         uint32_t getSession(uint32_t id) {
             pthread_mutex_lock(&mBiDictMutex);
             uint32_t ret = 0;
-            auto it = mForwardMap.find(id);
-            if (it != mForwardMap.end()) {
-                ret = it->second;
+            uint32_t* session = mForwardMap.find(id);
+            if (nullptr != session) {
+                ret = *session;
             }
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
@@ -370,11 +461,11 @@ private:
             pthread_mutex_lock(&mBiDictMutex);
             T ret;
             memset(&ret, 0, sizeof(T));
-            uint32_t session = mForwardMap[id];
-            if (session > 0) {
-                auto it = mExtMap.find(session);
-                if (it != mExtMap.end()) {
-                    ret = it->second;
+            uint32_t* session = mForwardMap.find(id);
+            if (nullptr != session && *session > 0) {
+                BackwardEntry* entry = mBackwardMap.find(*session);
+                if (nullptr != entry) {
+                    ret = entry->ext;
                 }
             }
             pthread_mutex_unlock(&mBiDictMutex);
@@ -384,9 +475,9 @@ private:
             pthread_mutex_lock(&mBiDictMutex);
             T ret;
             memset(&ret, 0, sizeof(T));
-            auto it = mExtMap.find(session);
-            if (it != mExtMap.end()) {
-                ret = it->second;
+            BackwardEntry* entry = mBackwardMap.find(session);
+            if (nullptr != entry) {
+                ret = entry->ext;
             }
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
@@ -394,20 +485,24 @@ private:
         std::vector<uint32_t> getAllSessions() {
             std::vector<uint32_t> ret;
             pthread_mutex_lock(&mBiDictMutex);
-            for (auto it = mBackwardMap.begin(); it != mBackwardMap.end(); it++) {
-                ret.push_back(it->first);
-            }
+            ret.reserve(mBackwardMap.size());
+            mBackwardMap.forEach([&ret](uint32_t session, BackwardEntry& /*entry*/) {
+                ret.push_back(session);
+            });
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
         }
     private:
+        struct BackwardEntry {
+            uint32_t id;
+            T ext;
+            BackwardEntry() : id(0), ext() {}
+        };
         pthread_mutex_t mBiDictMutex;
-        // mForwarMap mapping id->session
-        std::map<uint32_t, uint32_t> mForwardMap;
-        // mBackwardMap mapping session->id
-        std::map<uint32_t, uint32_t> mBackwardMap;
-        // mExtMap mapping session->ext
-        std::map<uint32_t, T> mExtMap;
+        // mForwardMap mapping id->session
+        loc_util::LocIdHashMap<uint32_t> mForwardMap;
+        // mBackwardMap mapping session->{id, ext}
+        loc_util::LocIdHashMap<BackwardEntry> mBackwardMap;
     };
 
     class StartTrackingRequest : public LocationAPIRequest {
@@ -489,50 +584,40 @@ private:
     public:
         AddGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
-            uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+            uint32_t* ids = mAPI.getResponseIds(count);
             for (size_t i = 0; i < count; i++) {
                 ids[i] = mAPI.mGeofenceBiDict.getId(sessions[i]);
             }
             LOC_LOGD("%s:]Returned geofence-id: %d in add geofence", __FUNCTION__, *ids);
             mAPI.onAddGeofencesCb(count, errors, ids);
-            free(ids);
         }
         LocationAPIClientBase& mAPI;
     };
 
     class RemoveGeofencesRequest : public LocationAPIRequest {
     public:
-        RemoveGeofencesRequest(LocationAPIClientBase& API,
-                               BiDict<GeofenceBreachTypeMask>* removedGeofenceBiDict) :
-                               mAPI(API), mRemovedGeofenceBiDict(removedGeofenceBiDict) {}
+        RemoveGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
-            if (nullptr != mRemovedGeofenceBiDict) {
-                uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
-                for (size_t i = 0; i < count; i++) {
-                    ids[i] = mRemovedGeofenceBiDict->getId(sessions[i]);
-                }
-                LOC_LOGD("%s:]Returned geofence-id: %d in remove geofence", __FUNCTION__, *ids);
-                mAPI.onRemoveGeofencesCb(count, errors, ids);
-                free(ids);
-                delete(mRemovedGeofenceBiDict);
-            } else {
-                LOC_LOGE("%s:%d] Unable to access removed geofences data.", __FUNCTION__, __LINE__);
+            uint32_t* ids = mAPI.getResponseIds(count);
+            for (size_t i = 0; i < count; i++) {
+                ids[i] = mAPI.mRemovedGeofenceBiDict.getId(sessions[i]);
+                mAPI.mRemovedGeofenceBiDict.rmBySession(sessions[i]);
             }
+            LOC_LOGD("%s:]Returned geofence-id: %d in remove geofence", __FUNCTION__, *ids);
+            mAPI.onRemoveGeofencesCb(count, errors, ids);
         }
         LocationAPIClientBase& mAPI;
-        BiDict<GeofenceBreachTypeMask>* mRemovedGeofenceBiDict;
     };
 
     class ModifyGeofencesRequest : public LocationAPIRequest {
     public:
         ModifyGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
-            uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+            uint32_t* ids = mAPI.getResponseIds(count);
             for (size_t i = 0; i < count; i++) {
                 ids[i] = mAPI.mGeofenceBiDict.getId(sessions[i]);
             }
             mAPI.onModifyGeofencesCb(count, errors, ids);
-            free(ids);
         }
         LocationAPIClientBase& mAPI;
     };
@@ -541,12 +626,11 @@ private:
     public:
         PauseGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
-            uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+            uint32_t* ids = mAPI.getResponseIds(count);
             for (size_t i = 0; i < count; i++) {
                 ids[i] = mAPI.mGeofenceBiDict.getId(sessions[i]);
             }
             mAPI.onPauseGeofencesCb(count, errors, ids);
-            free(ids);
         }
         LocationAPIClientBase& mAPI;
     };
@@ -555,12 +639,11 @@ private:
     public:
         ResumeGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
-            uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+            uint32_t* ids = mAPI.getResponseIds(count);
             for (size_t i = 0; i < count; i++) {
                 ids[i] = mAPI.mGeofenceBiDict.getId(sessions[i]);
             }
             mAPI.onResumeGeofencesCb(count, errors, ids);
-            free(ids);
         }
         LocationAPIClientBase& mAPI;
     };
@@ -574,6 +657,16 @@ private:
         LocationAPIClientBase& mAPI;
     };
 
+    // id array handed to the collective geofence callbacks, reused across
+    // responses since they are all delivered from the same callback context
+    inline uint32_t* getResponseIds(size_t count) {
+        if (mResponseIds.size() < count || mResponseIds.empty()) {
+            mResponseIds.resize(count > 0 ? count : 1);
+        }
+        return mResponseIds.data();
+    }
+    void releaseRequest(LocationAPIRequest* request);
+
 private:
     pthread_mutex_t mMutex;
 
@@ -582,9 +675,22 @@ private:
 
     LocationAPI* mLocationAPI;
 
+    // must outlive mRequestQueues, which hand their requests back on reset
+    RequestPool mRequestPool;
     RequestQueue mRequestQueues[REQUEST_MAX];
     BiDict<GeofenceBreachTypeMask> mGeofenceBiDict;
+    // geofences whose removal is still waiting for its response
+    BiDict<GeofenceBreachTypeMask> mRemovedGeofenceBiDict;
     BiDict<SessionEntity> mSessionBiDict;
+    // session arrays for remove/modify/pause/resume, guarded by mMutex
+    std::vector<uint32_t> mSessionScratch;
+    // id arrays handed to the geofence response and breach callbacks. They are
+    // used outside mMutex and the callbacks get a pointer into them, which is
+    // only safe as long as all geofence responses and breaches are delivered on
+    // the one geofence callback thread, one at a time. A second callback thread
+    // would need a scratch array per response instead.
+    std::vector<uint32_t> mResponseIds;
+    std::vector<uint32_t> mBreachIds;
     int32_t mBatchSize;
     bool mTracking;
 };
@@ -1663,11 +1663,36 @@ typedef struct {
     float                               serverPredictionAgeSeconds;
 } GnssDebugSatelliteInfo;
 
+typedef struct {
+    uint32_t frameworkRequests;  // ODCPI requests sent to the framework
+    uint32_t emergencyRequests;  // emergency ODCPI START requests from modem
+    uint32_t mergedRequests;     // START requests merged into the ongoing request
+    uint32_t cacheHits;          // START requests answered with the cached location
+} GnssDebugOdcpiStats;
+
+typedef struct {
+    uint32_t samples;            // paired BOOTTIME / REALTIME readings of the clock model
+    uint32_t steps;              // REALTIME steps detected
+    uint32_t realtimeSets;       // REALTIME sets reported by the kernel
+    int64_t lastErrorNanos;      // model prediction error at the latest reading
+    int64_t maxErrorNanos;       // largest absolute prediction error, steps excluded
+    int64_t driftPpb;            // REALTIME rate against BOOTTIME, parts per billion
+} GnssDebugClockStats;
+
 typedef struct {
     uint32_t size;                        // set to sizeof
     GnssDebugLocation                   mLocation;
     GnssDebugTime                       mTime;
     std::vector<GnssDebugSatelliteInfo> mSatelliteInfo;
+    // scheduling policies applied to the location threads, one per line
+    std::string                         mThreadPolicies;
+    GnssDebugOdcpiStats                 mOdcpiStats;
+    // engine restarts skipped as the multiplexed tracking options were unchanged
+    uint32_t                            mAvoidedTrackingRestarts;
+    // REALTIME model behind the elapsed realtime of fixes and measurements
+    GnssDebugClockStats                 mClockStats;
+    // AP side work accounting summary, one item per line
+    std::string                         mWorkAccounting;
 } GnssDebugReport;
 
 typedef uint32_t LeapSecondSysInfoMask;
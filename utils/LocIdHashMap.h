@@ -0,0 +1,159 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_ID_HASH_MAP_H
+#define LOC_ID_HASH_MAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace loc_util {
+
+/* Open addressing hash map keyed by 32 bit ids / sessions.
+   Slots live in one flat array probed linearly, erase shifts the following
+   cluster back so no tombstones are left behind, and clear() keeps the
+   capacity so a map that is filled and drained repeatedly stops allocating
+   once it has reached its working size.
+   V must be default constructible and copy assignable. Not thread safe. */
+template <typename V>
+class LocIdHashMap {
+    struct Slot {
+        uint32_t mKey;
+        bool mUsed;
+        V mValue;
+        Slot() : mKey(0), mUsed(false), mValue() {}
+    };
+
+    std::vector<Slot> mSlots;
+    size_t mSize;
+
+    inline size_t mask() const { return mSlots.size() - 1; }
+    inline size_t home(uint32_t key) const {
+        // Fibonacci hashing spreads the mostly sequential ids across the table
+        return (size_t)(key * 2654435761u) & mask();
+    }
+
+    Slot* lookup(uint32_t key) {
+        if (mSlots.empty()) {
+            return nullptr;
+        }
+        for (size_t i = home(key); mSlots[i].mUsed; i = (i + 1) & mask()) {
+            if (mSlots[i].mKey == key) {
+                return &mSlots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(mSlots);
+        mSlots.resize(old.empty() ? 16 : old.size() * 2);
+        mSize = 0;
+        for (size_t i = 0; i < old.size(); i++) {
+            if (old[i].mUsed) {
+                (*this)[old[i].mKey] = old[i].mValue;
+            }
+        }
+    }
+
+public:
+    LocIdHashMap() : mSize(0) {}
+
+    inline size_t size() const { return mSize; }
+    inline bool empty() const { return 0 == mSize; }
+
+    inline V* find(uint32_t key) {
+        Slot* slot = lookup(key);
+        return (nullptr != slot) ? &slot->mValue : nullptr;
+    }
+
+    V& operator[](uint32_t key) {
+        // keep the load factor at or below 1/2 so probe runs stay short
+        if ((mSize + 1) * 2 > mSlots.size()) {
+            grow();
+        }
+        size_t i = home(key);
+        for (; mSlots[i].mUsed; i = (i + 1) & mask()) {
+            if (mSlots[i].mKey == key) {
+                return mSlots[i].mValue;
+            }
+        }
+        mSlots[i].mKey = key;
+        mSlots[i].mUsed = true;
+        mSlots[i].mValue = V();
+        mSize++;
+        return mSlots[i].mValue;
+    }
+
+    bool erase(uint32_t key) {
+        Slot* slot = lookup(key);
+        if (nullptr == slot) {
+            return false;
+        }
+        size_t hole = slot - &mSlots[0];
+        for (size_t i = (hole + 1) & mask(); mSlots[i].mUsed; i = (i + 1) & mask()) {
+            // move the entry back into the hole unless its home lies
+            // cyclically in (hole, i], in which case it must stay put
+            size_t h = home(mSlots[i].mKey);
+            if (((i - h) & mask()) >= ((i - hole) & mask())) {
+                mSlots[hole] = mSlots[i];
+                hole = i;
+            }
+        }
+        mSlots[hole].mUsed = false;
+        mSlots[hole].mValue = V();
+        mSize--;
+        return true;
+    }
+
+    void clear() {
+        if (mSize > 0) {
+            for (size_t i = 0; i < mSlots.size(); i++) {
+                mSlots[i].mUsed = false;
+                mSlots[i].mValue = V();
+            }
+            mSize = 0;
+        }
+    }
+
+    template <typename F>
+    void forEach(F f) {
+        for (size_t i = 0; i < mSlots.size(); i++) {
+            if (mSlots[i].mUsed) {
+                f(mSlots[i].mKey, mSlots[i].mValue);
+            }
+        }
+    }
+};
+
+} // namespace loc_util
+
+#endif /* LOC_ID_HASH_MAP_H */
@@ -0,0 +1,131 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <time.h>
+#include <inttypes.h>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <loc_pla.h>
+#include <log_util.h>
+#include <LocInitGraph.h>
+
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "LocSvc_InitGraph"
+
+namespace loc_util {
+
+static uint64_t monotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+size_t LocInitGraph::add(const char* name, Step step, const std::vector<size_t>& dependencies)
+{
+    size_t id = mNodes.size();
+    mNodes.push_back({name, step, {}, 0, 0});
+    for (auto dependency : dependencies) {
+        if (dependency < id) {
+            mNodes[dependency].mDependents.push_back(id);
+            mNodes[id].mPendingDependencies++;
+        } else {
+            LOC_LOGe("%s: %s can only depend on steps added before it", mName, name);
+        }
+    }
+    return id;
+}
+
+void LocInitGraph::runStep(size_t id)
+{
+    uint64_t start = monotonicMicros();
+    mNodes[id].mStep();
+    mNodes[id].mDurationUs = monotonicMicros() - start;
+}
+
+void LocInitGraph::run()
+{
+    std::mutex mutex;
+    std::condition_variable finishedCond;
+    std::vector<size_t> ready;
+    std::vector<size_t> finished;
+    std::vector<std::thread> threads;
+    size_t remaining = mNodes.size();
+    uint64_t start = monotonicMicros();
+
+    for (size_t i = 0; i < mNodes.size(); i++) {
+        if (0 == mNodes[i].mPendingDependencies) {
+            ready.push_back(i);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (remaining > 0) {
+        // the first ready step runs on this thread, which would otherwise only wait
+        for (size_t i = 1; i < ready.size(); i++) {
+            threads.emplace_back([this, id = ready[i], &mutex, &finishedCond, &finished]() {
+                runStep(id);
+                std::lock_guard<std::mutex> guard(mutex);
+                finished.push_back(id);
+                finishedCond.notify_one();
+            });
+        }
+        if (!ready.empty()) {
+            size_t id = ready[0];
+            lock.unlock();
+            runStep(id);
+            lock.lock();
+            finished.push_back(id);
+        }
+        ready.clear();
+
+        finishedCond.wait(lock, [&finished]() { return !finished.empty(); });
+        for (auto id : finished) {
+            remaining--;
+            LOC_LOGi("%s: %s took %" PRIu64 " us", mName, mNodes[id].mName, mNodes[id].mDurationUs);
+            for (auto dependent : mNodes[id].mDependents) {
+                if (0 == --mNodes[dependent].mPendingDependencies) {
+                    ready.push_back(dependent);
+                }
+            }
+        }
+        finished.clear();
+    }
+    lock.unlock();
+
+    for (auto& each : threads) {
+        each.join();
+    }
+    LOC_LOGi("%s: %zu steps done in %" PRIu64 " us", mName, mNodes.size(),
+             monotonicMicros() - start);
+}
+
+} // namespace loc_util
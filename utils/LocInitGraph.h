@@ -0,0 +1,74 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_INIT_GRAPH_H
+#define LOC_INIT_GRAPH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+namespace loc_util {
+
+/* Runs a set of initialization steps in dependency order.
+   A step only names steps added before it as dependencies, so the graph is
+   acyclic by construction. run() starts every step whose dependencies are
+   done, one of them on the calling thread and the others on threads of their
+   own, so independent steps overlap, and returns once all of them have
+   finished. The time each step took and the total are logged.
+   A graph is meant to be built and run once, from a single thread. */
+class LocInitGraph {
+public:
+    typedef std::function<void()> Step;
+
+    inline explicit LocInitGraph(const char* name) : mName(name) {}
+
+    // returns the id to list this step under in the dependencies of later steps
+    size_t add(const char* name, Step step, const std::vector<size_t>& dependencies = {});
+    void run();
+
+private:
+    struct Node {
+        const char* mName;
+        Step mStep;
+        std::vector<size_t> mDependents;
+        uint32_t mPendingDependencies;
+        uint64_t mDurationUs;
+    };
+
+    const char* mName;
+    std::vector<Node> mNodes;
+
+    void runStep(size_t id);
+};
+
+} // namespace loc_util
+
+#endif // LOC_INIT_GRAPH_H
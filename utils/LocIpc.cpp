@@ -35,6 +35,7 @@
 #include <loc_misc_utils.h>
 #include <log_util.h>
 #include <LocIpc.h>
+#include <LocWorkAccounting.h>
 #include <algorithm>
 
 using namespace std;
@@ -64,6 +65,9 @@ ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockad
                           socklen_t addrlen) const {
     ssize_t rtv = -1;
     SOCK_OP_AND_LOG(buf, len, isValid(), rtv, sendto(buf, len, flags, destAddr, addrlen));
+    if (rtv > 0) {
+        LocWorkAccounting::getInstance().addIpcBytesSent(rtv);
+    }
     return rtv;
 }
 ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
@@ -74,6 +78,9 @@ ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>
     } // else it sid would be connection based socket id for recv
     SOCK_OP_AND_LOG(dataCb.get(), mMaxTxSize, isValid(), rtv,
                     recvfrom(recver, dataCb, sid, flags, srcAddr, addrlen));
+    if (rtv > 0) {
+        LocWorkAccounting::getInstance().addIpcBytesReceived(rtv);
+    }
     return rtv;
 }
 ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
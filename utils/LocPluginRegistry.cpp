@@ -0,0 +1,167 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <dlfcn.h>
+#include <time.h>
+#include <inttypes.h>
+#include <loc_pla.h>
+#include <log_util.h>
+#include <loc_misc_utils.h>
+#include <LocPluginRegistry.h>
+
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "LocSvc_PluginRegistry"
+
+namespace loc_util {
+
+static uint64_t monotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void logDlError(const char* failedCall, const char* name) {
+    const char * err = dlerror();
+    LOC_LOGe("%s %s error: %s", failedCall, name, (nullptr == err) ? "unknown" : err);
+}
+
+LocPluginRegistry& LocPluginRegistry::getInstance() {
+    static LocPluginRegistry sInstance;
+    return sInstance;
+}
+
+LocPluginRegistry::Library& LocPluginRegistry::getLibraryLocked(const char* libName) {
+    for (auto& each : mLibraries) {
+        if (each.mName == libName) {
+            return each;
+        }
+    }
+
+    uint64_t start = monotonicMicros();
+    void* handle = dlopen(libName, RTLD_NOW | RTLD_NODELETE);
+    uint64_t loadTimeUs = monotonicMicros() - start;
+    if (nullptr == handle) {
+        logDlError("dlopen", libName);
+    } else {
+        LOC_LOGd("%s loaded in %" PRIu64 " us", libName, loadTimeUs);
+    }
+    mLibraries.push_back({libName, handle, loadTimeUs, 0, {}});
+    return mLibraries.back();
+}
+
+LocPluginRegistry::Library* LocPluginRegistry::findLibraryLocked(void* libHandle) {
+    for (auto& each : mLibraries) {
+        if (each.mHandle == libHandle) {
+            return &each;
+        }
+    }
+    return nullptr;
+}
+
+void* LocPluginRegistry::lookupLocked(Library& library, const char* symName) {
+    auto iter = library.mSymbols.find(symName);
+    if (iter != library.mSymbols.end()) {
+        return iter->second;
+    }
+
+    void* sym = dlsym(library.mHandle, symName);
+    if (nullptr == sym) {
+        logDlError("dlsym", symName);
+        library.mSymbolMisses++;
+    }
+    library.mSymbols.emplace(symName, sym);
+    return sym;
+}
+
+void* LocPluginRegistry::getSymbol(void*& libHandle, const char* libName, const char* symName)
+{
+    void* sym = nullptr;
+    if ((nullptr != libHandle || nullptr != libName) && nullptr != symName) {
+        std::lock_guard<std::mutex> guard(mMutex);
+        Library* library = nullptr;
+        if (nullptr == libHandle) {
+            library = &getLibraryLocked(libName);
+            libHandle = library->mHandle;
+        } else {
+            library = findLibraryLocked(libHandle);
+        }
+
+        if (nullptr != library) {
+            if (nullptr != library->mHandle) {
+                sym = lookupLocked(*library, symName);
+            }
+        } else {
+            // a handle the caller opened itself, nothing to cache it under
+            sym = dlsym(libHandle, symName);
+            if (nullptr == sym) {
+                logDlError("dlsym", symName);
+            }
+        }
+    } else {
+        LOC_LOGe("Either libHandle (%p) or libName (%p) must not be null; "
+                 "symName (%p) can not be null.", libHandle, libName, symName);
+    }
+
+    return sym;
+}
+
+bool LocPluginRegistry::markMilestone(const char* milestone) {
+    std::lock_guard<std::mutex> guard(mMutex);
+    for (auto& each : mMilestones) {
+        if (each.mName == milestone) {
+            return false;
+        }
+    }
+
+    uint64_t now = getBootTimeMilliSec();
+    uint64_t first = mMilestones.empty() ? now : mMilestones.front().mBootTimeMs;
+    mMilestones.push_back({milestone, now});
+    LOC_LOGi("startup: %s at +%" PRIu64 " ms", milestone, now - first);
+    return true;
+}
+
+void LocPluginRegistry::dump() {
+    std::lock_guard<std::mutex> guard(mMutex);
+    for (auto& each : mLibraries) {
+        LOC_LOGi("plugin %s: %s, load %" PRIu64 " us, %zu symbols, %u missing",
+                 each.mName.c_str(), (nullptr == each.mHandle) ? "not found" : "loaded",
+                 each.mLoadTimeUs, each.mSymbols.size(), each.mSymbolMisses);
+    }
+    if (!mMilestones.empty()) {
+        uint64_t first = mMilestones.front().mBootTimeMs;
+        for (auto& each : mMilestones) {
+            LOC_LOGi("startup: %s at +%" PRIu64 " ms",
+                     each.mName.c_str(), each.mBootTimeMs - first);
+        }
+    }
+}
+
+} // namespace loc_util
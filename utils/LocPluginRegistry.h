@@ -0,0 +1,84 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_PLUGIN_REGISTRY_H
+#define LOC_PLUGIN_REGISTRY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace loc_util {
+
+/* Process wide registry of the optional libraries the stack loads at runtime.
+   Each library is dlopen'd at most once, with RTLD_NODELETE so a stray
+   dlclose() by a caller cannot unload it, and each symbol is dlsym'd at most
+   once. Failed opens and lookups are remembered too, so a missing plugin
+   costs one attempt per process rather than one per call.
+   The registry also keeps a startup timeline: the first time each named
+   milestone is reached it is logged with its offset from the first one. */
+class LocPluginRegistry {
+public:
+    static LocPluginRegistry& getInstance();
+
+    // same contract as dlGetSymFromLib() in loc_misc_utils.h
+    void* getSymbol(void*& libHandle, const char* libName, const char* symName);
+
+    // returns true only the first time the milestone is reached
+    bool markMilestone(const char* milestone);
+    void dump();
+
+private:
+    struct Library {
+        std::string mName;
+        void* mHandle;
+        uint64_t mLoadTimeUs;
+        uint32_t mSymbolMisses;
+        std::unordered_map<std::string, void*> mSymbols;
+    };
+    struct Milestone {
+        std::string mName;
+        uint64_t mBootTimeMs;
+    };
+
+    std::mutex mMutex;
+    std::vector<Library> mLibraries;
+    std::vector<Milestone> mMilestones;
+
+    inline LocPluginRegistry() {}
+    Library& getLibraryLocked(const char* libName);
+    Library* findLibraryLocked(void* libHandle);
+    void* lookupLocked(Library& library, const char* symName);
+};
+
+} // namespace loc_util
+
+#endif // LOC_PLUGIN_REGISTRY_H
@@ -0,0 +1,162 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <time.h>
+#include <inttypes.h>
+#include <loc_pla.h>
+#include <log_util.h>
+#include <LocPowerStateFilter.h>
+
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "LocSvc_PowerStateFilter"
+
+namespace loc_util {
+
+static uint64_t monotonicMillis() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+LocPowerStateFilter::LocPowerStateFilter(const EdgeCb& edgeCb, uint32_t settleWindowMs) :
+        mEdgeCb(edgeCb), mSettleWindowMs(settleWindowMs),
+        mPublished(false), mPending(false), mCandidate(false), mCandidateSinceMs(0),
+        mStats{0, 0, 0}, mSettleTimer(*this) {
+}
+
+bool LocPowerStateFilter::isChargingStatus(LocChargeStatus status) {
+    return (LOC_CHARGE_STATUS_CHARGING == status) || (LOC_CHARGE_STATUS_FULL == status);
+}
+
+void LocPowerStateFilter::seed(bool charging) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mPublished = charging;
+    if (mPending) {
+        mPending = false;
+        mSettleTimer.stop();
+    }
+}
+
+void LocPowerStateFilter::onChargeStatus(LocChargeStatus status) {
+    bool publish = false;
+    bool charging = false;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStats.mReceived++;
+
+        if (LOC_CHARGE_STATUS_UNKNOWN == status) {
+            mStats.mSuppressed++;
+            return;
+        }
+        charging = isChargingStatus(status);
+        // only NOT_CHARGING may be transient, connect and disconnect go out at once
+        bool hold = (LOC_CHARGE_STATUS_NOT_CHARGING == status) && (0 != mSettleWindowMs);
+
+        if (mPending) {
+            if (charging != mCandidate) {
+                // change undone within the settle window, drop both updates
+                mPending = false;
+                mSettleTimer.stop();
+                mStats.mSuppressed += 2;
+                LOC_LOGv("%s undone within %" PRIu32 " ms",
+                         charging ? "discharging" : "charging", mSettleWindowMs);
+                return;
+            }
+            if (hold) {
+                mStats.mSuppressed++;
+                return;
+            }
+            // the held change is confirmed by a disconnect
+            mSettleTimer.stop();
+            mStats.mSuppressed++;
+            publish = publishLocked();
+        } else if (charging == mPublished) {
+            mStats.mSuppressed++;
+            return;
+        } else {
+            mCandidate = charging;
+            mPending = true;
+            mCandidateSinceMs = monotonicMillis();
+            if (!hold || !mSettleTimer.start(mSettleWindowMs, false)) {
+                publish = publishLocked();
+            }
+        }
+    }
+    if (publish) {
+        mEdgeCb(charging);
+    }
+}
+
+void LocPowerStateFilter::settle() {
+    bool publish = false;
+    bool charging = false;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (!mPending) {
+            return;
+        }
+        // the timer may have fired for a candidate that was since dropped and
+        // replaced; give the current one the rest of its window. If the start
+        // fails, the replacement already armed the timer, which calls back here.
+        uint64_t heldMs = monotonicMillis() - mCandidateSinceMs;
+        if (heldMs < mSettleWindowMs) {
+            mSettleTimer.start(mSettleWindowMs - (uint32_t)heldMs, false);
+            return;
+        }
+        publish = publishLocked();
+        charging = mPublished;
+    }
+    if (publish) {
+        mEdgeCb(charging);
+    }
+}
+
+bool LocPowerStateFilter::publishLocked() {
+    mPending = false;
+    mPublished = mCandidate;
+    mStats.mPublished++;
+    LOC_LOGd("publish %s, received %" PRIu64 " published %" PRIu64 " suppressed %" PRIu64,
+             mPublished ? "CHARGING" : "NOT CHARGING",
+             mStats.mReceived, mStats.mPublished, mStats.mSuppressed);
+    return nullptr != mEdgeCb;
+}
+
+bool LocPowerStateFilter::isCharging() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mPublished;
+}
+
+LocPowerStateFilter::Stats LocPowerStateFilter::getStats() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mStats;
+}
+
+} // namespace loc_util
@@ -0,0 +1,110 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_POWER_STATE_FILTER_H
+#define LOC_POWER_STATE_FILTER_H
+
+#include <stdint.h>
+#include <functional>
+#include <mutex>
+#include <LocTimer.h>
+
+namespace loc_util {
+
+/* Charge status as reported by a power supply source, e.g. the health HAL */
+typedef enum {
+    LOC_CHARGE_STATUS_UNKNOWN = 0,
+    LOC_CHARGE_STATUS_CHARGING,
+    LOC_CHARGE_STATUS_DISCHARGING,
+    LOC_CHARGE_STATUS_NOT_CHARGING,
+    LOC_CHARGE_STATUS_FULL
+} LocChargeStatus;
+
+/* Turns a stream of charge status updates into charging / not charging edges.
+   Updates that do not change the charging state, e.g. the periodic health
+   updates while charging, or CHARGING -> FULL, are dropped right away.
+   Plugging in and unplugging, i.e. changes to CHARGING, FULL or DISCHARGING,
+   are published at once. NOT_CHARGING, which is also seen transiently
+   around plugging in, is only published once it has held for the settle
+   window; if it is undone within the window it is never published.
+   Held edges are published from the LocTimer thread, so the source is never
+   blocked by the consumer; the others, and every edge with a settle window
+   of 0, are published synchronously from onChargeStatus().
+   Any caller can act as the source, which lets the filter run off target
+   with a fake source in place of the health HAL. */
+class LocPowerStateFilter {
+public:
+    typedef std::function<void(bool charging)> EdgeCb;
+
+    struct Stats {
+        uint64_t mReceived;   // updates passed to onChargeStatus()
+        uint64_t mPublished;  // edges passed to the EdgeCb
+        uint64_t mSuppressed; // updates that were redundant or undone in time
+    };
+
+    LocPowerStateFilter(const EdgeCb& edgeCb, uint32_t settleWindowMs);
+    virtual ~LocPowerStateFilter() {}
+
+    // sets the charging state the consumer already knows about, without publishing it
+    void seed(bool charging);
+    void onChargeStatus(LocChargeStatus status);
+
+    // last published charging state
+    bool isCharging() const;
+    Stats getStats() const;
+
+    static bool isChargingStatus(LocChargeStatus status);
+
+private:
+    class SettleTimer : public LocTimer {
+        LocPowerStateFilter& mFilter;
+    public:
+        inline SettleTimer(LocPowerStateFilter& filter) : LocTimer(), mFilter(filter) {}
+        inline virtual void timeOutCallback() override { mFilter.settle(); }
+    };
+
+    void settle();
+    // called with mLock held; returns true if the caller is to publish mPublished
+    bool publishLocked();
+
+    const EdgeCb mEdgeCb;
+    const uint32_t mSettleWindowMs;
+    mutable std::mutex mLock;
+    bool mPublished;
+    bool mPending;
+    bool mCandidate;
+    uint64_t mCandidateSinceMs;
+    Stats mStats;
+    // declared last so that it is stopped before the state it works on goes away
+    SettleTimer mSettleTimer;
+};
+
+} // namespace loc_util
+
+#endif /* LOC_POWER_STATE_FILTER_H */
@@ -0,0 +1,100 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_RING_BUFFER_H
+#define LOC_RING_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace loc_util {
+
+/* Fixed capacity history of the last N values.
+   Storage is one inline array sized at compile time, push_back() overwrites
+   the oldest entry once the ring is full, and index 0 is always the oldest
+   entry held, so callers see the same order a trimmed std::vector would give
+   them without the erase(begin()) shuffle on every update.
+   T must be default constructible and copy assignable. Not thread safe. */
+template <typename T, uint32_t N>
+class LocRingBuffer {
+    static_assert(N > 0, "LocRingBuffer needs a capacity of at least one");
+
+    T mItems[N];
+    uint32_t mHead;     // slot of the oldest entry
+    uint32_t mSize;
+
+    inline uint32_t slot(size_t i) const { return (uint32_t)((mHead + i) % N); }
+
+public:
+    LocRingBuffer() : mHead(0), mSize(0) {}
+
+    inline static uint32_t capacity() { return N; }
+    inline size_t size() const { return mSize; }
+    inline bool empty() const { return 0 == mSize; }
+    inline void clear() { mHead = 0; mSize = 0; }
+
+    // i counts from the oldest entry held
+    inline T& operator[](size_t i) { return mItems[slot(i)]; }
+    inline const T& operator[](size_t i) const { return mItems[slot(i)]; }
+    inline T& back() { return mItems[slot(mSize - 1)]; }
+    inline const T& back() const { return mItems[slot(mSize - 1)]; }
+
+    void push_back(const T& item) {
+        if (mSize < N) {
+            mItems[slot(mSize)] = item;
+            mSize++;
+        } else {
+            mItems[mHead] = item;
+            mHead = (mHead + 1) % N;
+        }
+    }
+
+    // calls f on the newest count entries, oldest first
+    template <typename F>
+    void forEachLast(size_t count, F f) const {
+        if (count > mSize) {
+            count = mSize;
+        }
+        for (size_t i = mSize - count; i < mSize; i++) {
+            f(mItems[slot(i)]);
+        }
+    }
+
+    // replaces out with the newest count entries, oldest first
+    void copyLast(std::vector<T>& out, size_t count) const {
+        out.clear();
+        out.reserve(count < mSize ? count : mSize);
+        forEachLast(count, [&out](const T& item) { out.push_back(item); });
+    }
+};
+
+} // namespace loc_util
+
+#endif // LOC_RING_BUFFER_H
@@ -27,19 +27,209 @@
  *
  */
 #include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
 #include <LocThread.h>
 #include <string.h>
 #include <string>
 #include <thread>
+#include <mutex>
+#include <map>
 #include <loc_pla.h>
+#include <loc_cfg.h>
+#include <log_util.h>
+
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "LocSvc_LocThread"
 
 using std::weak_ptr;
 using std::shared_ptr;
 using std::thread;
 using std::string;
+using std::mutex;
+using std::lock_guard;
+using std::map;
 
 namespace loc_util {
 
+#define LOC_THREAD_POLICY_MAX_NUM 8
+
+/* Scheduling policy of a named thread, configured in gps.conf as
+ *   LOC_THREAD_POLICY_<n> = <name> <OTHER|FIFO|RR> <rt priority> <nice> <cpu mask> <timerslack ns>
+ * A cpu mask or timerslack of 0 leaves the inherited setting unchanged. */
+struct LocThreadPolicy {
+    char name[16];
+    int schedPolicy;
+    int priority;
+    int niceValue;
+    uint64_t cpuMask;
+    uint64_t timerSlackNs;
+};
+
+class LocThreadPolicies {
+    mutex mLock;
+    bool mConfigRead;
+    int mNumPolicies;
+    LocThreadPolicy mPolicies[LOC_THREAD_POLICY_MAX_NUM];
+    // tid -> applied policy description of the running threads
+    map<pid_t, string> mApplied;
+
+    void readConfig();
+    static bool parsePolicy(const char* str, LocThreadPolicy& policy);
+public:
+    inline LocThreadPolicies() : mConfigRead(false), mNumPolicies(0), mPolicies{} {}
+    void apply(const string& tName);
+    void remove();
+    void getApplied(string& report);
+};
+
+// never destroyed, detached threads may still exit after static destruction
+static LocThreadPolicies& getThreadPolicies() {
+    static LocThreadPolicies* policies = new LocThreadPolicies();
+    return *policies;
+}
+
+bool LocThreadPolicies::parsePolicy(const char* str, LocThreadPolicy& policy) {
+    char schedName[8] = {};
+    if (6 != sscanf(str, "%15s %7s %d %d %" SCNx64 " %" SCNu64, policy.name, schedName,
+                    &policy.priority, &policy.niceValue, &policy.cpuMask,
+                    &policy.timerSlackNs)) {
+        return false;
+    }
+    if (0 == strcmp(schedName, "FIFO")) {
+        policy.schedPolicy = SCHED_FIFO;
+    } else if (0 == strcmp(schedName, "RR")) {
+        policy.schedPolicy = SCHED_RR;
+    } else if (0 == strcmp(schedName, "OTHER")) {
+        policy.schedPolicy = SCHED_OTHER;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void LocThreadPolicies::readConfig() {
+    char confStrs[LOC_THREAD_POLICY_MAX_NUM][LOC_MAX_PARAM_STRING] = {};
+    const loc_param_s_type threadPolicyConfTable[LOC_THREAD_POLICY_MAX_NUM] = {
+        {"LOC_THREAD_POLICY_1", &confStrs[0], NULL, 's'},
+        {"LOC_THREAD_POLICY_2", &confStrs[1], NULL, 's'},
+        {"LOC_THREAD_POLICY_3", &confStrs[2], NULL, 's'},
+        {"LOC_THREAD_POLICY_4", &confStrs[3], NULL, 's'},
+        {"LOC_THREAD_POLICY_5", &confStrs[4], NULL, 's'},
+        {"LOC_THREAD_POLICY_6", &confStrs[5], NULL, 's'},
+        {"LOC_THREAD_POLICY_7", &confStrs[6], NULL, 's'},
+        {"LOC_THREAD_POLICY_8", &confStrs[7], NULL, 's'}
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, threadPolicyConfTable);
+
+    for (int i = 0; i < LOC_THREAD_POLICY_MAX_NUM; i++) {
+        if (0 == confStrs[i][0]) {
+            continue;
+        }
+        if (parsePolicy(confStrs[i], mPolicies[mNumPolicies])) {
+            mNumPolicies++;
+        } else {
+            LOC_LOGe("invalid LOC_THREAD_POLICY_%d: %s", i + 1, confStrs[i]);
+        }
+    }
+}
+
+// runs in the context of the thread being configured
+void LocThreadPolicies::apply(const string& tName) {
+    const LocThreadPolicy* policy = nullptr;
+    {
+        lock_guard<mutex> guard(mLock);
+        if (!mConfigRead) {
+            mConfigRead = true;
+            readConfig();
+        }
+        for (int i = 0; i < mNumPolicies && nullptr == policy; i++) {
+            if (0 == strcmp(mPolicies[i].name, tName.c_str())) {
+                policy = &mPolicies[i];
+            }
+        }
+    }
+    if (nullptr == policy) {
+        return;
+    }
+
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    string applied(tName);
+    char buf[64];
+
+    if (0 != policy->cpuMask) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (int cpu = 0; cpu < 64; cpu++) {
+            if (policy->cpuMask & (1ULL << cpu)) {
+                CPU_SET(cpu, &cpuSet);
+            }
+        }
+        if (0 == sched_setaffinity(0, sizeof(cpuSet), &cpuSet)) {
+            snprintf(buf, sizeof(buf), " cpus=0x%" PRIx64, policy->cpuMask);
+        } else {
+            snprintf(buf, sizeof(buf), " cpus=denied(%d)", errno);
+        }
+        applied += buf;
+    }
+
+    bool rtApplied = false;
+    if (SCHED_OTHER != policy->schedPolicy) {
+        struct sched_param param = {};
+        param.sched_priority = policy->priority;
+        if (0 == sched_setscheduler(0, policy->schedPolicy, &param)) {
+            rtApplied = true;
+            snprintf(buf, sizeof(buf), " %s=%d",
+                     (SCHED_FIFO == policy->schedPolicy) ? "fifo" : "rr", policy->priority);
+        } else {
+            // fall back to the nice value below, e.g. without CAP_SYS_NICE
+            snprintf(buf, sizeof(buf), " rt=denied(%d)", errno);
+        }
+        applied += buf;
+    }
+
+    if (!rtApplied && 0 != policy->niceValue) {
+        if (0 == setpriority(PRIO_PROCESS, tid, policy->niceValue)) {
+            snprintf(buf, sizeof(buf), " nice=%d", policy->niceValue);
+        } else {
+            snprintf(buf, sizeof(buf), " nice=denied(%d)", errno);
+        }
+        applied += buf;
+    }
+
+    if (0 != policy->timerSlackNs) {
+        if (0 == prctl(PR_SET_TIMERSLACK, (unsigned long)policy->timerSlackNs, 0, 0, 0)) {
+            snprintf(buf, sizeof(buf), " timerslack=%" PRIu64, policy->timerSlackNs);
+        } else {
+            snprintf(buf, sizeof(buf), " timerslack=denied(%d)", errno);
+        }
+        applied += buf;
+    }
+
+    LOC_LOGi("tid %d policy:%s", tid, applied.c_str());
+    lock_guard<mutex> guard(mLock);
+    mApplied[tid] = applied;
+}
+
+void LocThreadPolicies::remove() {
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    lock_guard<mutex> guard(mLock);
+    mApplied.erase(tid);
+}
+
+void LocThreadPolicies::getApplied(string& report) {
+    lock_guard<mutex> guard(mLock);
+    for (auto& applied : mApplied) {
+        report += std::to_string(applied.first) + " " + applied.second + "\n";
+    }
+}
+
 class LocThreadDelegate {
     static const char defaultThreadName[];
     weak_ptr<LocRunnable> mRunnable;
@@ -82,8 +272,10 @@ LocThreadDelegate::LocThreadDelegate(const string tName, shared_ptr<LocRunnable>
         mThread([tName, runnable] {
                 prctl(PR_SET_NAME, tName.c_str(), 0, 0, 0);
                 runnable->prerun();
+                getThreadPolicies().apply(tName);
                 while (runnable->run());
                 runnable->postrun();
+                getThreadPolicies().remove();
             }) {
 
     mThread.detach();
@@ -101,6 +293,10 @@ bool LocThread::start(const char* tName, shared_ptr<LocRunnable> runnable) {
     return success;
 }
 
+void LocThread::getAppliedPolicies(string& report) {
+    getThreadPolicies().getApplied(report);
+}
+
 void LocThread::stop() {
     if (nullptr != mThread) {
         delete mThread;
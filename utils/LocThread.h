@@ -31,6 +31,7 @@
 
 #include <stddef.h>
 #include <memory>
+#include <string>
 
 using std::shared_ptr;
 
@@ -89,6 +90,11 @@ public:
 
     // thread status check
     inline bool isRunning() { return NULL != mThread; }
+
+    // Appends the scheduling policy applied to each running named thread,
+    // as configured with LOC_THREAD_POLICY_<n> in gps.conf, one line per
+    // thread, including the settings the kernel denied.
+    static void getAppliedPolicies(std::string& report);
 };
 
 } // loc_util
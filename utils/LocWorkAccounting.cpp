@@ -0,0 +1,279 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <dlfcn.h>
+#include <time.h>
+#include <string.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <loc_pla.h>
+#include <loc_cfg.h>
+#include <log_util.h>
+#include <LocWorkAccounting.h>
+
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "LocSvc_WorkAccounting"
+
+// message types listed per thread by dump()
+#define DUMP_MSG_TYPES_PER_THREAD 8
+
+namespace loc_util {
+
+static bool readEnabledConfig() {
+    uint32_t enabled = 0;
+    const loc_param_s_type workAccountingConfTable[] = {
+        {"WORK_ACCOUNTING_ENABLED", &enabled, NULL, 'n'}
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, workAccountingConfTable);
+    LOC_LOGd("WORK_ACCOUNTING_ENABLED %u", enabled);
+    return 0 != enabled;
+}
+
+LocWorkAccounting::LocWorkAccounting() :
+        mEnabled(readEnabledConfig()), mRemovedClients{nullptr, 0, 0},
+        mRemovedClientCount(0), mNmeaBytes(0), mIpcBytesSent(0), mIpcBytesReceived(0),
+        mEnergyReports(0), mEnergyConsumed(0), mPrevEnergyConsumed(0),
+        mApCpuNanosAtEnergy(0), mApCpuNanosAtPrevEnergy(0) {}
+
+// never destroyed, detached MsgTask threads may still report after static destruction
+LocWorkAccounting& LocWorkAccounting::getInstance() {
+    static LocWorkAccounting* sInstance = new LocWorkAccounting();
+    return *sInstance;
+}
+
+uint64_t LocWorkAccounting::threadCpuNanos() {
+    struct timespec ts;
+    if (0 != clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts)) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Names a message class by its exported vtable symbol. Message classes are
+// mostly local to the function that sends them and have no exported symbol;
+// those are named by library and offset, which resolves against the
+// unstripped library.
+static std::string typeName(const void* type) {
+    char name[256];
+    Dl_info info;
+    if (0 != dladdr(type, &info) && nullptr != info.dli_fname) {
+        // an object points into its vtable, past the offset-to-top and typeinfo slots
+        if (nullptr != info.dli_sname && (uintptr_t)info.dli_saddr <= (uintptr_t)type &&
+                (uintptr_t)type - (uintptr_t)info.dli_saddr <= 2 * sizeof(void*)) {
+            snprintf(name, sizeof(name), "%s", info.dli_sname);
+        } else {
+            const char* lib = strrchr(info.dli_fname, '/');
+            snprintf(name, sizeof(name), "%s+0x%" PRIxPTR,
+                     (nullptr == lib) ? info.dli_fname : lib + 1,
+                     (uintptr_t)type - (uintptr_t)info.dli_fbase);
+        }
+    } else {
+        snprintf(name, sizeof(name), "%p", type);
+    }
+    return name;
+}
+
+void LocWorkAccounting::ThreadAccount::addMsg(const void* msgType, uint64_t cpuNanos) {
+    std::lock_guard<std::mutex> guard(mLock);
+    mMsgCount++;
+    mCpuNanos += cpuNanos;
+    auto it = mMsgTypes.find(msgType);
+    if (mMsgTypes.end() == it) {
+        it = mMsgTypes.emplace(msgType, MsgTypeStats{msgType, "", 0, 0, 0}).first;
+    }
+    MsgTypeStats& stats = it->second;
+    stats.mCount++;
+    stats.mCpuNanos += cpuNanos;
+    if (cpuNanos > stats.mMaxCpuNanos) {
+        stats.mMaxCpuNanos = cpuNanos;
+    }
+}
+
+std::shared_ptr<LocWorkAccounting::ThreadAccount> LocWorkAccounting::addThread(
+        const char* name) {
+    if (!mEnabled) {
+        return nullptr;
+    }
+    std::shared_ptr<ThreadAccount> account = std::make_shared<ThreadAccount>(name);
+    std::lock_guard<std::mutex> guard(mLock);
+    mThreads.push_back(account);
+    return account;
+}
+
+void LocWorkAccounting::addClientCallback(const void* client, uint64_t cpuNanos) {
+    if (!mEnabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(mLock);
+    auto it = mClients.find(client);
+    if (mClients.end() == it) {
+        it = mClients.emplace(client, ClientStats{client, 0, 0}).first;
+    }
+    it->second.mCallbacks++;
+    it->second.mCpuNanos += cpuNanos;
+}
+
+void LocWorkAccounting::removeClient(const void* client) {
+    if (!mEnabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(mLock);
+    auto it = mClients.find(client);
+    if (mClients.end() != it) {
+        mRemovedClients.mCallbacks += it->second.mCallbacks;
+        mRemovedClients.mCpuNanos += it->second.mCpuNanos;
+        mRemovedClientCount++;
+        mClients.erase(it);
+    }
+}
+
+uint64_t LocWorkAccounting::apCpuNanosLocked() {
+    uint64_t cpuNanos = 0;
+    for (auto& thread : mThreads) {
+        std::lock_guard<std::mutex> guard(thread->mLock);
+        cpuNanos += thread->mCpuNanos;
+    }
+    return cpuNanos;
+}
+
+void LocWorkAccounting::addEnergyReport(uint64_t energyConsumedSinceFirstBoot) {
+    if (!mEnabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(mLock);
+    mPrevEnergyConsumed = mEnergyConsumed;
+    mApCpuNanosAtPrevEnergy = mApCpuNanosAtEnergy;
+    mEnergyConsumed = energyConsumedSinceFirstBoot;
+    mApCpuNanosAtEnergy = apCpuNanosLocked();
+    mEnergyReports++;
+}
+
+void LocWorkAccounting::getSnapshot(Snapshot& snapshot) {
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        snapshot.mThreads.clear();
+        snapshot.mThreads.reserve(mThreads.size());
+        for (auto& thread : mThreads) {
+            std::lock_guard<std::mutex> threadGuard(thread->mLock);
+            snapshot.mThreads.push_back(
+                    ThreadStats{thread->mName, thread->mMsgCount, thread->mCpuNanos, {}});
+            std::vector<MsgTypeStats>& msgTypes = snapshot.mThreads.back().mMsgTypes;
+            msgTypes.reserve(thread->mMsgTypes.size());
+            for (auto& each : thread->mMsgTypes) {
+                msgTypes.push_back(each.second);
+            }
+        }
+        snapshot.mClients.clear();
+        snapshot.mClients.reserve(mClients.size());
+        for (auto& each : mClients) {
+            snapshot.mClients.push_back(each.second);
+        }
+        snapshot.mRemovedClients = mRemovedClients;
+        snapshot.mRemovedClientCount = mRemovedClientCount;
+        snapshot.mEnergyReports = mEnergyReports;
+        snapshot.mEnergyConsumed = mEnergyConsumed;
+        snapshot.mPrevEnergyConsumed = mPrevEnergyConsumed;
+        snapshot.mApCpuNanosAtEnergy = mApCpuNanosAtEnergy;
+        snapshot.mApCpuNanosAtPrevEnergy = mApCpuNanosAtPrevEnergy;
+    }
+    snapshot.mNmeaBytes = mNmeaBytes.load();
+    snapshot.mIpcBytesSent = mIpcBytesSent.load();
+    snapshot.mIpcBytesReceived = mIpcBytesReceived.load();
+
+    // dladdr() is not free, name the types outside of the locks
+    for (auto& thread : snapshot.mThreads) {
+        for (auto& msgType : thread.mMsgTypes) {
+            msgType.mTypeName = typeName(msgType.mType);
+        }
+    }
+}
+
+void LocWorkAccounting::dump(std::string& report) {
+    if (!mEnabled) {
+        report += "work accounting disabled, see WORK_ACCOUNTING_ENABLED\n";
+        return;
+    }
+    Snapshot snapshot;
+    getSnapshot(snapshot);
+    char line[384];
+
+    uint64_t apCpuNanos = 0;
+    for (auto& thread : snapshot.mThreads) {
+        apCpuNanos += thread.mCpuNanos;
+        snprintf(line, sizeof(line), "thread %s: %" PRIu64 " msgs, cpu %" PRIu64 " us\n",
+                 thread.mName.c_str(), thread.mMsgCount, thread.mCpuNanos / 1000);
+        report += line;
+
+        std::sort(thread.mMsgTypes.begin(), thread.mMsgTypes.end(),
+                  [](const MsgTypeStats& a, const MsgTypeStats& b) {
+                      return a.mCpuNanos > b.mCpuNanos;
+                  });
+        size_t count = std::min(thread.mMsgTypes.size(), (size_t)DUMP_MSG_TYPES_PER_THREAD);
+        for (size_t i = 0; i < count; i++) {
+            const MsgTypeStats& msgType = thread.mMsgTypes[i];
+            snprintf(line, sizeof(line),
+                     "  %s: %" PRIu64 " msgs, cpu %" PRIu64 " us, max %" PRIu64 " us\n",
+                     msgType.mTypeName.c_str(), msgType.mCount, msgType.mCpuNanos / 1000,
+                     msgType.mMaxCpuNanos / 1000);
+            report += line;
+        }
+    }
+    for (auto& client : snapshot.mClients) {
+        snprintf(line, sizeof(line), "client %p: %" PRIu64 " callbacks, cpu %" PRIu64 " us\n",
+                 client.mClient, client.mCallbacks, client.mCpuNanos / 1000);
+        report += line;
+    }
+    if (snapshot.mRemovedClientCount > 0) {
+        snprintf(line, sizeof(line),
+                 "%u removed clients: %" PRIu64 " callbacks, cpu %" PRIu64 " us\n",
+                 snapshot.mRemovedClientCount, snapshot.mRemovedClients.mCallbacks,
+                 snapshot.mRemovedClients.mCpuNanos / 1000);
+        report += line;
+    }
+    snprintf(line, sizeof(line),
+             "ap cpu %" PRIu64 " us, nmea %" PRIu64 " bytes, ipc sent %" PRIu64
+             " received %" PRIu64 " bytes\n", apCpuNanos / 1000, snapshot.mNmeaBytes,
+             snapshot.mIpcBytesSent, snapshot.mIpcBytesReceived);
+    report += line;
+    if (snapshot.mEnergyReports > 1) {
+        snprintf(line, sizeof(line),
+                 "modem energy %" PRIu64 ", last interval %" PRIu64 " vs ap cpu %" PRIu64
+                 " us\n", snapshot.mEnergyConsumed,
+                 snapshot.mEnergyConsumed - snapshot.mPrevEnergyConsumed,
+                 (snapshot.mApCpuNanosAtEnergy - snapshot.mApCpuNanosAtPrevEnergy) / 1000);
+        report += line;
+    } else if (snapshot.mEnergyReports > 0) {
+        snprintf(line, sizeof(line), "modem energy %" PRIu64 "\n", snapshot.mEnergyConsumed);
+        report += line;
+    }
+}
+
+} // namespace loc_util
@@ -0,0 +1,180 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_WORK_ACCOUNTING_H
+#define LOC_WORK_ACCOUNTING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace loc_util {
+
+/* Process wide account of the AP side work done by the location stack.
+   - each MsgTask thread reports the thread CPU time of every LocMsg::proc(),
+     attributed to the dynamic type of the message; the type is told by the
+     vtable address, which relies on the Itanium C++ ABI used by the Android
+     and Linux toolchains (see getMsgType() in MsgTask.cpp);
+   - client callbacks are attributed, with the CPU time they took, to the
+     client they are made to (see ClientCallbackScope);
+   - NMEA and IPC byte counts are kept as totals.
+   Modem reported energy is kept along with the AP CPU time spent up to the
+   time of each report, so that the AP cost between two reports can be
+   weighed against the modem energy spent in the same interval.
+   MsgTask threads live as long as the process and are never removed; a
+   removed client is folded into a single entry for all removed clients.
+   Accounting is off unless WORK_ACCOUNTING_ENABLED is set in gps.conf, as
+   it costs two clock reads and a lock per message; when off, nothing is
+   counted and every method below is a cheap no-op. */
+class LocWorkAccounting {
+public:
+    struct MsgTypeStats {
+        const void* mType;       // identifies the message class
+        std::string mTypeName;   // best effort name of mType, filled in by getSnapshot()
+        uint64_t mCount;
+        uint64_t mCpuNanos;
+        uint64_t mMaxCpuNanos;
+    };
+    struct ThreadStats {
+        std::string mName;
+        uint64_t mMsgCount;
+        uint64_t mCpuNanos;
+        std::vector<MsgTypeStats> mMsgTypes;
+    };
+    struct ClientStats {
+        const void* mClient;
+        uint64_t mCallbacks;
+        uint64_t mCpuNanos;
+    };
+    struct Snapshot {
+        std::vector<ThreadStats> mThreads;
+        std::vector<ClientStats> mClients;
+        // all removed clients together, mClient is nullptr
+        ClientStats mRemovedClients;
+        uint32_t mRemovedClientCount;
+        uint64_t mNmeaBytes;
+        uint64_t mIpcBytesSent;
+        uint64_t mIpcBytesReceived;
+        // the two latest modem energy reports, in the units the modem reports,
+        // with the AP CPU time spent by all MsgTask threads at each of them
+        uint32_t mEnergyReports;
+        uint64_t mEnergyConsumed;
+        uint64_t mPrevEnergyConsumed;
+        uint64_t mApCpuNanosAtEnergy;
+        uint64_t mApCpuNanosAtPrevEnergy;
+    };
+
+    // Work account of one MsgTask thread, only updated from that thread
+    class ThreadAccount {
+        friend class LocWorkAccounting;
+        const std::string mName;
+        std::mutex mLock;
+        uint64_t mMsgCount;
+        uint64_t mCpuNanos;
+        std::unordered_map<const void*, MsgTypeStats> mMsgTypes;
+    public:
+        inline ThreadAccount(const char* name) :
+                mName(nullptr == name ? "" : name), mMsgCount(0), mCpuNanos(0) {}
+        void addMsg(const void* msgType, uint64_t cpuNanos);
+    };
+
+    // Attributes the callbacks made within its scope to a client
+    class ClientCallbackScope {
+        const void* mClient;
+        uint64_t mStartCpuNanos;
+    public:
+        inline ClientCallbackScope(const void* client) :
+                mClient(client),
+                mStartCpuNanos(getInstance().isEnabled() ? threadCpuNanos() : 0) {}
+        inline ~ClientCallbackScope() {
+            if (getInstance().isEnabled()) {
+                getInstance().addClientCallback(mClient, threadCpuNanos() - mStartCpuNanos);
+            }
+        }
+    };
+
+    static LocWorkAccounting& getInstance();
+    // CPU time consumed by the calling thread
+    static uint64_t threadCpuNanos();
+
+    inline bool isEnabled() const { return mEnabled; }
+    // nullptr if accounting is not enabled
+    std::shared_ptr<ThreadAccount> addThread(const char* name);
+    void addClientCallback(const void* client, uint64_t cpuNanos);
+    // folds the client's entry into the removed clients entry
+    void removeClient(const void* client);
+    inline void addNmeaBytes(size_t bytes) {
+        if (mEnabled) {
+            mNmeaBytes += bytes;
+        }
+    }
+    inline void addIpcBytesSent(size_t bytes) {
+        if (mEnabled) {
+            mIpcBytesSent += bytes;
+        }
+    }
+    inline void addIpcBytesReceived(size_t bytes) {
+        if (mEnabled) {
+            mIpcBytesReceived += bytes;
+        }
+    }
+    void addEnergyReport(uint64_t energyConsumedSinceFirstBoot);
+
+    void getSnapshot(Snapshot& snapshot);
+    // appends a human readable summary, with the costliest message types first
+    void dump(std::string& report);
+
+private:
+    const bool mEnabled;
+    std::mutex mLock;
+    std::vector<std::shared_ptr<ThreadAccount>> mThreads;
+    std::unordered_map<const void*, ClientStats> mClients;
+    ClientStats mRemovedClients;
+    uint32_t mRemovedClientCount;
+    std::atomic<uint64_t> mNmeaBytes;
+    std::atomic<uint64_t> mIpcBytesSent;
+    std::atomic<uint64_t> mIpcBytesReceived;
+    uint32_t mEnergyReports;
+    uint64_t mEnergyConsumed;
+    uint64_t mPrevEnergyConsumed;
+    uint64_t mApCpuNanosAtEnergy;
+    uint64_t mApCpuNanosAtPrevEnergy;
+
+    LocWorkAccounting();
+    uint64_t apCpuNanosLocked();
+};
+
+} // namespace loc_util
+
+#endif /* LOC_WORK_ACCOUNTING_H */
@@ -35,13 +35,28 @@
 #include <log_util.h>
 #include <loc_log.h>
 #include <loc_pla.h>
+#include <LocWorkAccounting.h>
+
+// Pending messages searched for one superseded by a coalescable message.
+// The search runs under the queue lock, so it is kept short even when the
+// queue is backed up; a match further back is just not coalesced.
+#define MAX_COALESCE_SCAN 32
 
 namespace loc_util {
 
+// Identifies the class of a message without RTTI, which the Android build
+// leaves out: under the Itanium C++ ABI the first word of a polymorphic
+// object is the address of its class's vtable.
+static inline const void* getMsgType(const LocMsg* msg) {
+    return *reinterpret_cast<const void* const*>(msg);
+}
+
 class MTRunnable : public LocRunnable {
     const void* mQ;
+    const std::shared_ptr<LocWorkAccounting::ThreadAccount> mAccount;
 public:
-    inline MTRunnable(const void* q) : mQ(q) {}
+    inline MTRunnable(const void* q, const char* threadName) :
+            mQ(q), mAccount(LocWorkAccounting::getInstance().addThread(threadName)) {}
     virtual ~MTRunnable();
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
@@ -60,14 +75,31 @@ static void LocMsgDestroy(void* msg) {
     delete (LocMsg*)msg;
 }
 
+static bool LocMsgSupersedes(void* newMsg, void* pendingMsg) {
+    const LocMsg* msg = (const LocMsg*)newMsg;
+    const LocMsg* pending = (const LocMsg*)pendingMsg;
+    return msg->getCoalesceKey() == pending->getCoalesceKey() &&
+           msg->getCoalesceOwner() == pending->getCoalesceOwner();
+}
+
 MsgTask::MsgTask(const char* threadName) :
     mQ(msg_q_init2()), mThread() {
-    mThread.start(threadName, std::make_shared<MTRunnable>(mQ));
+    mThread.start(threadName, std::make_shared<MTRunnable>(mQ, threadName));
 }
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
     if (msg && this) {
-        msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        if (0 == msg->getCoalesceKey()) {
+            msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        } else {
+            bool replaced = false;
+            msg_q_snd_replace((void*)mQ, (void*)msg, LocMsgDestroy,
+                              LocMsgSupersedes, MAX_COALESCE_SCAN, &replaced);
+            if (replaced) {
+                LOC_LOGV("%s: dropped pending msg of key 0x%" PRIx64,
+                         __func__, msg->getCoalesceKey());
+            }
+        }
     } else {
         LOC_LOGE("%s: msg is %p and this is %p",
                  __func__, msg, this);
@@ -105,7 +137,14 @@ bool MTRunnable::run() {
 
     msg->log();
     // there is where each individual msg handling is invoked
-    msg->proc();
+    if (nullptr == mAccount) {
+        msg->proc();
+    } else {
+        const void* msgType = getMsgType(msg);
+        uint64_t startCpuNanos = LocWorkAccounting::threadCpuNanos();
+        msg->proc();
+        mAccount->addMsg(msgType, LocWorkAccounting::threadCpuNanos() - startCpuNanos);
+    }
 
     delete msg;
 
@@ -30,6 +30,8 @@
 #define __MSG_TASK__
 
 #include <functional>
+#include <atomic>
+#include <stdint.h>
 #include <LocThread.h>
 
 namespace loc_util {
@@ -39,6 +41,12 @@ struct LocMsg {
     inline virtual ~LocMsg() {}
     virtual void proc() const = 0;
     inline virtual void log() const {}
+    // A message with a non-zero coalesce key only carries the latest state of
+    // a report. A newer message of the same key and owner drops the pending one
+    // from the MsgTask queue and is queued behind everything sent before it, so
+    // a stalled worker processes one per key without reordering the reports.
+    inline virtual uint64_t getCoalesceKey() const { return 0; }
+    inline virtual const void* getCoalesceOwner() const { return nullptr; }
 };
 
 class MsgTask {
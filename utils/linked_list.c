@@ -323,3 +323,60 @@ linked_list_err_type linked_list_search(void* list_data, void **data_p,
    return eLINKED_LIST_SUCCESS;
 }
 
+
+/*===========================================================================
+
+  FUNCTION:   linked_list_replace
+
+  ===========================================================================*/
+linked_list_err_type linked_list_replace(void* list_data, void *data_obj,
+                                         void (*dealloc)(void*),
+                                         bool (*equal)(void* data_0, void* data),
+                                         unsigned int max_scan, bool* replaced)
+{
+   if( list_data == NULL || NULL == equal )
+   {
+      LOC_LOGE("%s: Invalid list parameter! list_data %p equal %p\n",
+               __FUNCTION__, list_data, equal);
+      return eLINKED_LIST_INVALID_HANDLE;
+   }
+
+   if( data_obj == NULL || replaced == NULL )
+   {
+      LOC_LOGE("%s: Invalid input parameter!\n", __FUNCTION__);
+      return eLINKED_LIST_INVALID_PARAMETER;
+   }
+
+   list_state* p_list = (list_state*)list_data;
+   /* elements are added at the head, so the scan starts with the newest */
+   list_element* tmp = p_list->p_head;
+   unsigned int scanned = 0;
+
+   *replaced = false;
+   while (NULL != tmp && scanned < max_scan) {
+     if ((*equal)(data_obj, tmp->data_ptr)) {
+       /* unlink the superseded element; data_obj is added as the newest
+          element below, so it does not overtake anything queued before it */
+       if (NULL != tmp->prev) {
+           tmp->prev->next = tmp->next;
+       } else {
+           p_list->p_head = tmp->next;
+       }
+       if (NULL != tmp->next) {
+           tmp->next->prev = tmp->prev;
+       } else {
+           p_list->p_tail = tmp->prev;
+       }
+       if (NULL != tmp->dealloc_func) {
+           tmp->dealloc_func(tmp->data_ptr);
+       }
+       free(tmp);
+       *replaced = true;
+       break;
+     }
+     tmp = tmp->next;
+     scanned++;
+   }
+
+   return linked_list_add(list_data, data_obj, dealloc);
+}
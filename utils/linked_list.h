@@ -212,6 +212,38 @@ linked_list_err_type linked_list_search(void* list_data, void **data_p,
                                         bool (*equal)(void* data_0, void* data),
                                         void* data_0, bool rm_if_found);
 
+/*===========================================================================
+FUNCTION    linked_list_replace
+
+DESCRIPTION
+   Adds data_obj to the list as with linked_list_add, dropping the first
+   element found matching data_obj. The dropped data is deallocated with the
+   dealloc function it was added with. Only the max_scan most recently added
+   elements are searched, so the cost stays bounded on a long list.
+
+   p_list_data:  List handle.
+   data_obj:     Pointer to the new data.
+   dealloc:      Function used to deallocate memory for data_obj.
+   equal:        Function ptr takes in data_obj and a list element, and
+                 returns indication if this the one to be replaced.
+   max_scan:     Max number of elements searched for a match.
+   replaced:     Set to true if an element was dropped.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+linked_list_err_type linked_list_replace(void* list_data, void *data_obj,
+                                         void (*dealloc)(void*),
+                                         bool (*equal)(void* data_0, void* data),
+                                         unsigned int max_scan, bool* replaced);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
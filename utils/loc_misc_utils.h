@@ -121,7 +121,9 @@ RETURN VALUE
        symName can not be found.
 
 SIDE EFFECTS
-   N/A
+   Goes through LocPluginRegistry, which opens each library and resolves each
+   symbol once per process, failures included. Libraries opened here stay
+   loaded for the life of the process; callers need not dlclose the handle.
 ===========================================================================*/
 void* dlGetSymFromLib(void*& libHandle, const char* libName, const char* symName);
 
@@ -92,4 +92,36 @@ inline bool loc_nmea_is_debug(const char* nmea, int length) {
             (nmea[0] == '$') && (nmea[1] == 'P') && (nmea[2] == 'Q') && (nmea[3] == 'W'));
 }
 
+/* Key identifying the slot of a single standard NMEA sentence within an epoch,
+ * i.e. its address field, plus the message number fields for GSV sentences.
+ * Returns 0 for debug, tag block and multi sentence strings, which must not
+ * be superseded by a later sentence. */
+inline uint32_t loc_nmea_get_sentence_key(const char* nmea, int length) {
+    if (nullptr == nmea || length < DEBUG_NMEA_MINSIZE || nmea[0] != '$' ||
+            loc_nmea_is_debug(nmea, length)) {
+        return 0;
+    }
+    // FNV-1a over the address field, and the 2 fields following it for GSV
+    uint32_t key = 2166136261u;
+    int fields = 1;
+    int i = 1;
+    for (; i < length && nmea[i] != '\0' && nmea[i] != '*'; i++) {
+        if (nmea[i] == ',') {
+            if (1 == fields && (i < 4 || 0 != strncmp(&nmea[i - 3], "GSV", 3))) {
+                break;
+            }
+            if (++fields > 3) {
+                break;
+            }
+        }
+        key = (key ^ (uint8_t)nmea[i]) * 16777619u;
+    }
+    for (; i < length && nmea[i] != '\0'; i++) {
+        if (nmea[i] == '\n' && i + 1 < length && nmea[i + 1] != '\0') {
+            return 0;
+        }
+    }
+    return (0 == key) ? 1 : key;
+}
+
 #endif // LOC_ENG_NMEA_H
@@ -221,6 +221,58 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
    return rv;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_snd_replace
+
+  ===========================================================================*/
+msq_q_err_type msg_q_snd_replace(void* msg_q_data, void* msg_obj, void (*dealloc)(void*),
+                                 bool (*equal)(void* data_0, void* data),
+                                 unsigned int max_scan, bool* replaced)
+{
+   msq_q_err_type rv;
+   if( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+   if( msg_obj == NULL || equal == NULL || replaced == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_obj parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+   LOC_LOGV("%s: Sending message with handle = %p\n", __FUNCTION__, msg_obj);
+
+   if( p_msg_q->unblocked )
+   {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   rv = convert_linked_list_err_type(
+           linked_list_replace(p_msg_q->msg_list, msg_obj, dealloc, equal, max_scan,
+                               replaced));
+
+   /* Show data is in the message queue. A replaced message was already signaled,
+      and the number of queued messages did not change. */
+   if( !*replaced )
+   {
+      pthread_cond_signal(&p_msg_q->list_cond);
+   }
+
+   pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+   LOC_LOGV("%s: Finished Sending message with handle = %p, replaced %d\n",
+            __FUNCTION__, msg_obj, *replaced);
+
+   return rv;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_rcv
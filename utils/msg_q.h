@@ -33,6 +33,7 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 /** Linked List Return Codes */
@@ -135,6 +136,38 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*));
 
+/*===========================================================================
+FUNCTION    msg_q_snd_replace
+
+DESCRIPTION
+   Sends data to the message queue as with msg_q_snd, dropping a pending
+   message which the equal function reports as superseded by msg_obj. The
+   dropped message is deallocated. msg_obj is queued behind every message
+   sent before it, so the order of delivery is kept. Only the max_scan most
+   recently sent messages are searched.
+
+   msg_q_data: Message Queue to add the element to.
+   msgp:       Pointer to data to add into message queue.
+   dealloc:    Function used to deallocate memory for this element.
+   equal:      Function ptr takes in msg_obj and a pending message, and
+               returns indication if the pending message is to be replaced.
+   max_scan:   Max number of pending messages searched.
+   replaced:   Set to true if a pending message was dropped.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_snd_replace(void* msg_q_data, void* msg_obj, void (*dealloc)(void*),
+                                 bool (*equal)(void* data_0, void* data),
+                                 unsigned int max_scan, bool* replaced);
+
 /*===========================================================================
 FUNCTION    msg_q_rcv
 